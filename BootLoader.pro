@@ -1,5 +1,5 @@
 # Qt模块配置
-QT += core gui widgets serialport network
+QT += core gui widgets serialport network concurrent
 
 # C++标准
 CONFIG += c++17
@@ -14,14 +14,37 @@ SOURCES += \
     src/main.cpp \
     src/mainwindow.cpp \
     src/protocol.cpp \
+    src/crc16.cpp \
+    src/lz4.cpp \
+    src/framedecoder.cpp \
+    src/transferplan.cpp \
+    src/firmwareimage.cpp \
     src/communication.cpp \
+    src/linkworker.cpp \
+    src/asynclogger.cpp \
+    src/sessioncapture.cpp \
+    src/timerwheel.cpp \
+    src/upgradejournal.cpp \
+    src/upgradetelemetry.cpp \
     src/upgrade.cpp
 
 # 头文件
 HEADERS += \
     inc/mainwindow.h \
     inc/protocol.h \
+    inc/crc16.h \
+    inc/lz4.h \
+    inc/framedecoder.h \
+    inc/transferplan.h \
+    inc/firmwareimage.h \
     inc/communication.h \
+    inc/spscqueue.h \
+    inc/linkworker.h \
+    inc/asynclogger.h \
+    inc/sessioncapture.h \
+    inc/timerwheel.h \
+    inc/upgradejournal.h \
+    inc/upgradetelemetry.h \
     inc/upgrade.h
 
 # UI文件
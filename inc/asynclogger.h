@@ -0,0 +1,92 @@
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#include <QByteArrayView>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "spscqueue.h"
+
+/**
+ * @brief 日志记录（二进制形式，格式化推迟到日志线程）
+ */
+struct LogRecord {
+    enum class Kind : quint8 {
+        Text,       // 整行文本
+        Tx,         // 发送的报文
+        Rx,         // 接收的报文
+        TxFailed    // 发送失败
+    };
+
+    static constexpr int PREVIEW_SIZE = 20;     // 日志只显示报文前20个字节
+
+    qint64 timestamp = 0;       // 毫秒（UTC纪元）
+    Kind kind = Kind::Text;
+    bool extended = false;      // 数据包是否使用扩展寻址，用于解析包序号
+    quint8 previewSize = 0;
+    qint32 frameSize = 0;       // 报文完整长度
+    char preview[PREVIEW_SIZE] = {};
+    QString text;               // Text 的内容，或发送报文的描述（数据包为空，不分配内存）
+};
+
+/**
+ * @brief 异步批量日志写入器
+ *
+ * 每个写日志的线程通过 channel() 取得自己的通道（单生产者单消费者无锁队列），
+ * 热路径上只复制报文的前20个字节和时间戳。日志线程周期性取走所有通道中的记录，
+ * 按时间排序后格式化，一次写入保持打开的日志文件并刷新。通道写满时丢弃新记录并计数，
+ * 下一批写入时记录丢弃条数，内存占用固定。
+ */
+class AsyncLogger
+{
+public:
+    class Channel
+    {
+    public:
+        explicit Channel(std::size_t capacity);
+
+        void logText(const QString &text);
+        void logTx(QByteArrayView frame, const QString &description, bool extended);
+        void logRx(QByteArrayView frame);
+        void logTxFailed();
+
+    private:
+        friend class AsyncLogger;
+
+        void push(LogRecord &&record);
+        static void fillPreview(LogRecord &record, QByteArrayView frame);
+
+        SpscQueue<LogRecord> queue;
+        std::atomic<quint64> dropped;
+    };
+
+    explicit AsyncLogger(const QString &filePath);
+    ~AsyncLogger();
+
+    /**
+     * @brief 为一个生产者线程创建通道，须在 start() 之前调用
+     */
+    Channel *channel();
+
+    void start();
+    void stop();
+
+private:
+    Q_DISABLE_COPY(AsyncLogger)
+
+    void run();
+    void drain(QByteArray &batch);
+    static QString format(const LogRecord &record);
+
+    QString m_filePath;
+    std::vector<std::unique_ptr<Channel>> m_channels;
+    QVector<LogRecord> m_pending;
+    std::unique_ptr<QThread> m_thread;
+    std::atomic<bool> m_stopping;
+};
+
+#endif // ASYNCLOGGER_H
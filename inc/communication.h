@@ -8,6 +8,7 @@
 #include <QString>
 
 #include "protocol.h"
+#include "sessioncapture.h"
 
 class CommunicationManager : public QObject
 {
@@ -45,12 +46,15 @@ public:
     // 协议访问
     BootLoaderProtocol& getProtocol() { return protocol; }
 
+    // 会话抓包：记录之后收发的每个报文，直到 stopCapture()
+    bool startCapture(const QString &path, QString *errorString = nullptr);
+    void stopCapture();
+    bool isCapturing() const { return capture.isOpen(); }
+
 signals:
     // 数据接收信号
-    void dataReceived(const QByteArray &frame, quint8 slaveId,
-                     BootLoaderProtocol::MessageType msgType,
-                     BootLoaderProtocol::ResponseFlag flag,
-                     const QByteArray &payload);
+    // frame 中的视图指向接收缓冲区，只在槽函数执行期间有效，必须使用直接连接
+    void frameReceived(const BootLoaderProtocol::Frame &frame);
 
     // 错误信号
     void serialError(const QString &errorMessage);
@@ -70,10 +74,17 @@ private slots:
     void handleTcpError(QAbstractSocket::SocketError error);
 
 private:
+    // 以本对象为父对象，随本对象一起移动到I/O线程
     QSerialPort serialPort;
     QTcpSocket tcpSocket;
     BootLoaderProtocol protocol;
     LinkType activeLink;
+    SessionCapture capture;
+
+    SessionCapture::Link captureLink() const
+    {
+        return activeLink == LinkType::Serial ? SessionCapture::Link::Serial : SessionCapture::Link::Ethernet;
+    }
 
     // 处理接收到的数据（共用逻辑）
     void processReceivedData(const QByteArray &data);
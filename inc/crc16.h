@@ -0,0 +1,85 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <QtGlobal>
+#include <array>
+
+/**
+ * @brief CRC16-MODBUS 计算引擎
+ *
+ * 查表在编译期生成；update() 采用 slice-by-8，每次处理 8 字节。
+ * 支持分段增量计算，结果与一次性计算相同：
+ *
+ *     quint16 crc = Crc16::INIT;
+ *     crc = Crc16::update(crc, part1, len1);
+ *     crc = Crc16::update(crc, part2, len2);
+ */
+namespace Crc16 {
+
+constexpr quint16 INIT = 0xFFFF;     // MODBUS 初始值
+constexpr quint16 POLY = 0xA001;     // 多项式 0x8005 的反射形式
+
+using Table = std::array<quint16, 256>;
+using SliceTables = std::array<Table, 8>;
+
+/**
+ * @brief 生成 slice-by-8 查找表，tables[0] 即常规的单字节查找表
+ */
+constexpr SliceTables makeTables()
+{
+    SliceTables tables{};
+    for (int b = 0; b < 256; ++b) {
+        quint16 crc = static_cast<quint16>(b);
+        for (int j = 0; j < 8; ++j) {
+            crc = (crc & 0x0001) ? static_cast<quint16>((crc >> 1) ^ POLY) : static_cast<quint16>(crc >> 1);
+        }
+        tables[0][b] = crc;
+    }
+    for (int k = 1; k < 8; ++k) {
+        for (int b = 0; b < 256; ++b) {
+            const quint16 prev = tables[k - 1][b];
+            tables[k][b] = static_cast<quint16>((prev >> 8) ^ tables[0][prev & 0xFF]);
+        }
+    }
+    return tables;
+}
+
+inline constexpr SliceTables TABLES = makeTables();
+
+/**
+ * @brief 单字节查表更新
+ */
+constexpr quint16 updateByte(quint16 state, quint8 byte)
+{
+    return static_cast<quint16>((state >> 8) ^ TABLES[0][(state ^ byte) & 0xFF]);
+}
+
+/**
+ * @brief 逐字节查表更新（短数据或对照用）
+ */
+inline quint16 updateTable(quint16 state, const void *data, qsizetype len)
+{
+    const quint8 *p = static_cast<const quint8 *>(data);
+    for (qsizetype i = 0; i < len; ++i) {
+        state = updateByte(state, p[i]);
+    }
+    return state;
+}
+
+/**
+ * @brief slice-by-8 增量更新
+ * @param state 上一次的结果（首次传入 INIT）
+ */
+quint16 update(quint16 state, const void *data, qsizetype len);
+
+/**
+ * @brief 一次性计算整段数据的 CRC16-MODBUS
+ */
+inline quint16 calculate(const void *data, qsizetype len)
+{
+    return update(INIT, data, len);
+}
+
+} // namespace Crc16
+
+#endif // CRC16_H
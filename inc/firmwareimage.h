@@ -0,0 +1,72 @@
+#ifndef FIRMWAREIMAGE_H
+#define FIRMWAREIMAGE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFile>
+#include <QSharedPointer>
+#include <QString>
+
+/**
+ * @brief 只读固件镜像
+ *
+ * 镜像本身只记录路径和大小，内容通过 Reader 按窗口读取：Reader 以只读内存映射
+ * 每次映射一段（默认64MB），读取位置越过窗口时再映射下一段，因此无论镜像多大，
+ * 地址空间和常驻内存都只与窗口大小有关。无法映射的文件退回到按窗口 read() 到缓冲区。
+ * 每个 Reader 持有独立的文件句柄，不同线程各自创建 Reader 即可并发读取。
+ */
+class FirmwareImage
+{
+public:
+    /**
+     * @brief 打开固件文件并获取大小
+     * @param path 文件路径
+     * @param errorString 输出：失败原因
+     * @return 失败时返回空指针
+     */
+    static QSharedPointer<FirmwareImage> open(const QString &path, QString *errorString = nullptr);
+
+    QString filePath() const { return m_path; }
+    qint64 size() const { return m_size; }
+
+    /**
+     * @brief 窗口式顺序读取器
+     */
+    class Reader
+    {
+    public:
+        explicit Reader(const FirmwareImage &image);
+        ~Reader();
+
+        bool isValid() const { return m_file.isOpen(); }
+        QString errorString() const { return m_file.errorString(); }
+
+        /**
+         * @brief 读取 [offset, offset+length) 段
+         * @return 视图，在下一次调用 read() 之前有效；越界或读取失败时返回空视图
+         */
+        QByteArrayView read(qint64 offset, qsizetype length);
+
+    private:
+        Q_DISABLE_COPY(Reader)
+
+        bool loadWindow(qint64 offset, qsizetype length);
+        void releaseWindow();
+
+        QFile m_file;
+        qint64 m_size;
+        uchar *m_map;           // 当前窗口的映射地址
+        QByteArray m_buffer;    // 映射失败时的窗口缓冲区
+        qint64 m_windowOffset;  // 当前窗口在文件中的起始位置
+        qint64 m_windowLength;
+        bool m_mappable;
+    };
+
+private:
+    FirmwareImage();
+
+    QString m_path;
+    qint64 m_size;
+};
+
+#endif // FIRMWAREIMAGE_H
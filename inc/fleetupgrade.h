@@ -0,0 +1,111 @@
+#ifndef FLEETUPGRADE_H
+#define FLEETUPGRADE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QSet>
+#include <QVector>
+#include <memory>
+
+#include "iothreadpool.h"
+#include "upgradesession.h"
+
+/**
+ * @brief 批量升级 - 同时对多个目标（链路 + 从机ID）各自运行一个升级会话
+ *
+ * 目标按加入顺序排队，同时运行的会话数不超过并发上限；每个会话有自己的链路和
+ * 状态机，互不影响。同一串口上的多个从机只能依次升级，不会同时打开同一串口。
+ * 设置了I/O线程数时，会话分配到 IoThreadPool 中链路最少的线程运行，
+ * 调度和汇总仍在本对象所在线程。
+ */
+class FleetUpgrade : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 单个目标的结果
+    struct Result {
+        UpgradeSession::Target target;
+        UpgradeSession::Status status = UpgradeSession::Status::Cancelled;
+        QString message;
+        qint64 elapsedMs = 0;       // 从会话开始到结束
+        bool finished = false;
+        UpgradeTelemetry telemetry;
+    };
+
+    // 汇总进度
+    struct Progress {
+        int total = 0;
+        int pending = 0;
+        int running = 0;
+        int succeeded = 0;
+        int failed = 0;
+        quint64 bytes = 0;              // 已开始的目标中已确认的字节数
+        quint64 totalBytes = 0;         // 已开始的目标的固件总字节数
+        double bytesPerSecond = 0.0;    // 运行中会话的吞吐之和
+        int percent = 0;                // 已结束目标计100%，运行中按字节，未开始计0
+    };
+
+    explicit FleetUpgrade(QObject *parent = nullptr);
+    ~FleetUpgrade();
+
+    // 开始前设置
+    void addTarget(const UpgradeSession::Target &target);
+    void setMaxConcurrent(int count);
+    int maxConcurrent() const { return concurrency; }
+
+    // I/O线程数，0 表示会话在本对象所在线程中运行
+    void setIoThreads(int count);
+
+    const QVector<Result> &results() const { return targetResults; }
+    bool isRunning() const { return running; }
+
+public slots:
+    void start();
+
+    // 取消尚未开始和正在运行的全部会话
+    void cancel();
+
+signals:
+    void sessionStarted(int index);
+    void sessionInfo(int index, const QString &text);
+    void sessionProgress(int index, const UpgradeManager::Progress &progress);
+    void sessionFinished(int index, const FleetUpgrade::Result &result);
+
+    // 汇总进度，最多每 100ms 一次，会话开始和结束时立即发出
+    void progressUpdated(const FleetUpgrade::Progress &progress);
+
+    // 全部目标结束
+    void finished();
+
+private:
+    // 会话及其最近的进度快照（结束后保留快照）
+    struct ActiveSession {
+        UpgradeSession *session = nullptr;
+        QElapsedTimer clock;
+        quint64 bytes = 0;
+        quint64 totalBytes = 0;
+        double bytesPerSecond = 0.0;
+    };
+
+    void launchPending();
+    void launch(int index);
+    void onSessionFinished(int index, UpgradeSession::Status status, const QString &message);
+    void updateProgress(bool force);
+    QString serialPortOf(int index) const;
+
+    QVector<Result> targetResults;
+    QVector<ActiveSession> active;  // 按目标索引存放，未运行或已结束时 session 为空
+    QList<int> pendingTargets;
+    QSet<QString> busyPorts;        // 正在使用的串口
+    int concurrency;
+    int runningCount;
+    bool running;
+    QElapsedTimer progressClock;
+    qint64 lastProgressMs;
+    int ioThreads;
+    std::unique_ptr<IoThreadPool> ioPool;
+};
+
+#endif // FLEETUPGRADE_H
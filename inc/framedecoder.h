@@ -0,0 +1,75 @@
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <memory>
+
+/**
+ * @brief 接收帧分割器 - 固定容量环形缓冲区
+ *
+ * 按帧头(0xAA 0x55 / 0x55 0xAA)和长度字段从字节流中切出完整帧：
+ * - 写入和消费只移动读写位置，不搬移数据
+ * - 用 memchr 查找帧头，重同步游标保证已扫描过的字节不会被重复扫描
+ * - 取出的帧是指向缓冲区内部的视图，只有跨越缓冲区末尾的帧才拷贝一次
+ *
+ * 用法：
+ *     while (remaining > 0) {
+ *         const qsizetype n = decoder.write(data, remaining);
+ *         data += n; remaining -= n;
+ *         QByteArrayView frame;
+ *         while (decoder.nextFrame(frame)) { ... }
+ *     }
+ */
+class FrameDecoder
+{
+public:
+    static constexpr qsizetype CAPACITY = 128 * 1024;   // 至少容纳两个最大帧，必须是2的幂
+    static constexpr qsizetype MAX_FRAME_SIZE = 0xFFFF; // 长度字段为16位
+    static constexpr qsizetype MIN_FRAME_SIZE = 9;      // 帧头(2)+ID(1)+长度(2)+类型(1)+标识(1)+CRC(2)
+
+    FrameDecoder();
+
+    /**
+     * @brief 写入接收到的数据
+     * @return 实际写入的字节数；缓冲区已满时小于 len，需先取出帧再继续写入
+     */
+    qsizetype write(const char *data, qsizetype len);
+
+    /**
+     * @brief 取出下一个完整帧
+     * @param frame 输出：帧视图，在下一次调用 write()/nextFrame()/clear() 之前有效
+     * @return 是否取到完整帧
+     */
+    bool nextFrame(QByteArrayView &frame);
+
+    // 清空缓冲区
+    void clear();
+
+    // 缓冲区中尚未消费的字节数
+    qsizetype size() const { return static_cast<qsizetype>(m_tail - m_head); }
+
+    // 累计丢弃的无效字节数（帧头之前的杂散数据、无效长度的帧头）
+    quint64 droppedBytes() const { return m_dropped; }
+
+private:
+    static constexpr quint64 MASK = CAPACITY - 1;
+
+    quint8 byteAt(quint64 pos) const { return static_cast<quint8>(m_buffer[pos & MASK]); }
+    void consumePending();
+    void drop(quint64 newHead);
+    quint64 find55(quint64 from) const;
+    bool findHeader();
+    QByteArrayView view(quint64 pos, qsizetype len);
+
+    std::unique_ptr<char[]> m_buffer;  // 首次写入时分配
+    QByteArray m_scratch;              // 跨越缓冲区末尾的帧在此拼接
+    quint64 m_head;                    // 读位置（绝对位置，只增不减）
+    quint64 m_tail;                    // 写位置
+    quint64 m_scan;                    // 重同步游标：此前的字节都已查找过帧头
+    qsizetype m_pending;               // 上一次交出的帧长度，下一次调用时再消费
+    quint64 m_dropped;
+};
+
+#endif // FRAMEDECODER_H
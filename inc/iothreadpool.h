@@ -0,0 +1,54 @@
+#ifndef IOTHREADPOOL_H
+#define IOTHREADPOOL_H
+
+#include <QObject>
+#include <QThread>
+#include <QVector>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief I/O线程池 - 少量线程承载大量链路
+ *
+ * 每个线程运行一个事件循环，其中的串口/套接字由事件分发器统一等待
+ * （Linux 上为 poll，Windows 上为 WSAEventSelect/重叠I/O），
+ * 一个线程可同时服务数十条链路，总吞吐随链路数增长而不是随线程数增长。
+ *
+ * 链路的套接字和串口只能在创建它们的线程中使用，不能在线程之间迁移，
+ * 因此负载均衡在分配时完成：新链路放到当前链路数最少的线程上。
+ */
+class IoThreadPool
+{
+public:
+    /**
+     * @param threadCount 线程数，<= 0 时按CPU核数
+     */
+    explicit IoThreadPool(int threadCount = 0);
+    ~IoThreadPool();
+
+    IoThreadPool(const IoThreadPool &) = delete;
+    IoThreadPool &operator=(const IoThreadPool &) = delete;
+
+    int threadCount() const { return static_cast<int>(threads.size()); }
+
+    /**
+     * @brief 把对象（及其子对象）移动到链路数最少的线程，该线程链路数加一
+     *
+     * 对象须没有父对象；之后只能通过信号槽或 QMetaObject::invokeMethod 访问。
+     * 对象销毁时自动减少所在线程的链路数。
+     */
+    void assign(QObject *object);
+
+    // 各线程当前的链路数
+    QVector<int> loads() const;
+
+private:
+    struct Worker {
+        QThread thread;
+        int load = 0;
+    };
+
+    std::vector<std::unique_ptr<Worker>> threads;
+};
+
+#endif // IOTHREADPOOL_H
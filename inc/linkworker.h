@@ -0,0 +1,117 @@
+#ifndef LINKWORKER_H
+#define LINKWORKER_H
+
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <atomic>
+
+#include "communication.h"
+#include "upgrade.h"
+#include "spscqueue.h"
+#include "asynclogger.h"
+
+/**
+ * @brief 工作线程发往界面的事件
+ */
+struct LinkEvent {
+    enum class Type {
+        Info,               // 信息窗口文本
+        Progress,           // 升级进度 progress=进度快照
+        UpgradeStarted,     // 启动升级的结果 flag=是否已启动
+        UpgradeFinished,    // 升级结束 flag=是否成功 text=结果信息
+        ConnectionState,    // 连接状态 flag=是否已连接
+        SerialError,        // 串口错误 text=错误信息
+        TcpError            // 网口错误 text=错误信息
+    };
+
+    Type type = Type::Info;
+    QString text;
+    UpgradeManager::Progress progress;
+    bool flag = false;
+};
+
+/**
+ * @brief 通信工作线程对象
+ *
+ * 持有 CommunicationManager 和 UpgradeManager，整体移动到专用I/O线程运行：
+ * 收到应答 -> 状态机 -> 发送下一包 全部在该线程内直接调用完成，不经过界面线程。
+ * 发往界面的信息、进度和状态通过单生产者单消费者无锁队列传递，界面线程重绘或
+ * 被拖动时不影响传输；界面发往本对象的操作通过 QMetaObject::invokeMethod 投递到
+ * 本线程执行。
+ */
+class LinkWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param eventReceiver 接收事件的界面对象，须有 drainLinkEvents() 槽
+     */
+    explicit LinkWorker(QObject *eventReceiver);
+
+    // 以下对象只能在I/O线程中访问
+    CommunicationManager *communication() const { return commManager; }
+    UpgradeManager *upgrade() const { return upgradeManager; }
+
+    /**
+     * @brief I/O线程：启动升级，结果以 UpgradeStarted 事件通知界面
+     */
+    void startUpgrade(quint8 slaveId, int packetSize,
+                      bool upgradeFPGA, bool upgradeDSP1,
+                      bool upgradeDSP2, bool upgradeARM,
+                      const QString &fpgaPath, const QString &dsp1Path,
+                      const QString &dsp2Path, const QString &armPath);
+
+    /**
+     * @brief I/O线程：选择固件后在后台准备，按从机使用对应的基线目录
+     */
+    void preloadFirmware(UpgradeManager::DeviceType device, const QString &path, quint8 slaveId, int packetSize);
+
+    // 收发报文日志的写入通道，须在移动到I/O线程之前设置
+    void setLogChannel(AsyncLogger::Channel *channel) { logChannel = channel; }
+
+    // 是否记录收发报文日志（界面线程写，I/O线程读）
+    void setLogEnabled(bool enabled) { logEnabled.store(enabled, std::memory_order_relaxed); }
+
+    /**
+     * @brief 界面线程：取出一个事件
+     * @return 没有待处理事件时返回 false
+     */
+    bool takeEvent(LinkEvent &event);
+
+    /**
+     * @brief 界面线程：开始处理一批事件前调用，之后到达的事件会再次通知界面
+     */
+    void beginDrain();
+
+    /**
+     * @brief 界面线程：取出并清零因队列已满而丢弃的事件数
+     */
+    quint64 takeDroppedCount();
+
+private slots:
+    void handleFrameReceived(const BootLoaderProtocol::Frame &frame);
+    void sendData(const QByteArray &data, const QString &description);
+
+private:
+    void useSlaveStorage(quint8 slaveId);
+    void postEvent(LinkEvent &&event);
+    void postInfo(const QString &text);
+
+    CommunicationManager *commManager;
+    UpgradeManager *upgradeManager;
+
+    QObject *receiver;          // 生命周期长于I/O线程
+    SpscQueue<LinkEvent> events;
+    std::atomic<bool> drainScheduled;
+    QMutex overflowMutex;
+    QList<LinkEvent> overflowEvents;    // 队列已满时的状态类事件，很少使用
+    std::atomic<bool> overflowPending;
+    std::atomic<quint64> droppedEvents;
+    AsyncLogger::Channel *logChannel;
+    std::atomic<bool> logEnabled;
+};
+
+#endif // LINKWORKER_H
@@ -0,0 +1,46 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <QtGlobal>
+
+/**
+ * @brief LZ4 块格式编解码
+ *
+ * 只实现块格式（不含帧头和校验），输出可由参考实现的 LZ4_decompress_safe 解压。
+ * 解压只做顺序拷贝，除输出缓冲区外不需要额外内存，下位机BootLoader可以逐包解压。
+ * 压缩使用单个哈希表做贪心匹配，压缩率接近参考实现的快速模式；每次调用独立，
+ * 不引用之前压缩过的数据。
+ */
+namespace Lz4 {
+
+constexpr int MIN_MATCH = 4;         // 最短匹配长度
+constexpr int MAX_OFFSET = 65535;    // 匹配偏移上限（2字节）
+
+/**
+ * @brief 最坏情况（完全不可压缩）下压缩结果的长度
+ */
+constexpr qsizetype compressBound(qsizetype size)
+{
+    return size + size / 255 + 16;
+}
+
+/**
+ * @brief 压缩一段数据
+ * @param capacity dst 的容量，不小于 compressBound(size) 时总能成功
+ * @return 压缩后的长度，容量不足时返回0
+ *
+ * 结果只取决于输入，与容量无关：容量恰好等于上次的结果长度时再压缩同一输入，
+ * 得到逐字节相同的输出。
+ */
+qsizetype compress(const char *src, qsizetype size, char *dst, qsizetype capacity);
+
+/**
+ * @brief 解压一段数据
+ * @param capacity dst 的容量
+ * @return 解压后的长度，数据格式错误或超出容量时返回 -1
+ */
+qsizetype decompress(const char *src, qsizetype size, char *dst, qsizetype capacity);
+
+} // namespace Lz4
+
+#endif // LZ4_H
@@ -10,22 +10,24 @@
 #include <QMessageBox>
 #include <QSerialPortInfo>
 #include <QStatusBar>
-#include <QTextCursor>
 #include <QDir>
 #include <QCoreApplication>
 #include <QLineEdit>
 #include <QCheckBox>
+#include <QThread>
+#include <QTimer>
+#include <QStringList>
 
 #include "communication.h"
 #include "protocol.h"
 #include "upgrade.h"
+#include "linkworker.h"
+#include "asynclogger.h"
 
 namespace Ui {
 class MainWindow;
 }
 
-class UpgradeManager; // 前向声明
-
 class MainWindow : public QMainWindow
 {
     Q_OBJECT // 启用元对象系统
@@ -35,11 +37,8 @@ public:
     ~MainWindow() override;
 
 private slots:
-    // 通信管理器信号槽
-    void handleDataReceived(const QByteArray &frame, quint8 slaveId, BootLoaderProtocol::MessageType msgType, BootLoaderProtocol::ResponseFlag flag, const QByteArray &payload);
-    void handleSerialError(const QString &errorMessage);
-    void handleTcpError(const QString &errorMessage);
-    void handleConnectionStateChanged(bool connected);
+    // 取出I/O线程投递的全部事件
+    void drainLinkEvents();
 
     // UI按钮槽函数
     void on_pushButton_FPGA_clicked();
@@ -50,13 +49,17 @@ private slots:
     void on_pushButton_SJ_clicked();
     void on_link_currentIndexChanged(int index);
 
-    // 升级管理器信号槽
-    void onUpgradeProgressUpdated(int currentDevice, int totalDevice);
-    void onUpgradeFinished(bool success, const QString &message);
-
     void on_pushButton_clicked();
 
 private:
+    // I/O线程事件处理
+    void handleSerialError(const QString &errorMessage);
+    void handleTcpError(const QString &errorMessage);
+    void handleConnectionStateChanged(bool connected);
+    void onUpgradeStarted(bool started);
+    void onUpgradeProgressUpdated(const UpgradeManager::Progress &progress);
+    void onUpgradeFinished(bool success, const QString &message);
+
     void populateSerialPorts();
     bool openSerialPort();
     bool openTcpSocket();
@@ -64,15 +67,22 @@ private:
     void applyConnectedState(bool connected, const QString &statusText = QString());
     void updateUiForLinkSelection(int index);
     void appendInfoDisplay(const QString &text);
+    void flushInfoDisplay();
+    void clearInfoDisplay();
     void writeToLogFile(const QString &text);
-    void sendData(const QByteArray &data, const QString &description = QString());
     QString toPrintable(const QByteArray &data) const;
-    void selectFirmwareFile(QLineEdit *lineEdit, QCheckBox *checkBox, const QString &title, const QString &filter);
+    void selectFirmwareFile(UpgradeManager::DeviceType device, QLineEdit *lineEdit, QCheckBox *checkBox,
+                            const QString &title, const QString &filter);
     quint8 getSlaveId() const;
 
     Ui::MainWindow *ui;
-    CommunicationManager *commManager;
-    UpgradeManager *upgradeManager;
+    QThread ioThread;           // 通信与升级状态机所在的I/O线程
+    LinkWorker *linkWorker;     // 运行在 ioThread 中，只能通过 invokeMethod 访问其成员对象
+    AsyncLogger *logger;        // 后台批量写日志文件
+    AsyncLogger::Channel *uiLogChannel;
+    QTimer infoFlushTimer;      // 信息窗口按帧率合并刷新
+    QStringList pendingInfo;    // 等待刷新到信息窗口的行
+    quint64 omittedInfo;        // 本次刷新前因超出窗口行数而省略的行数
     bool isConnected;
     QString logFilePath;
 };
@@ -5,6 +5,9 @@
 #include <QObject>
 #include <QByteArray>
 #include <QString>
+#include <QHash>
+
+#include "framedecoder.h"
 
 /**
  * @brief BootLoader协议通信类 - 纯协议实现
@@ -35,6 +38,10 @@ public:
         DSP2_END = 0x0F,             // DSP2升级结束
 
         TOTAL_END = 0x10,            // 总体结束
+        RESUME = 0x11,               // 断点续传
+        DELTA_COMMAND = 0x12,        // 差分升级指令
+        DELTA_DATA = 0x13,           // 差分升级数据（只含变化的块）
+        COMPRESSED_DATA = 0x14,      // 压缩升级数据（LZ4块格式，逐包独立压缩）
         DEBUG_INFO = 0x1F            // 调试信息显示
     };
 
@@ -99,16 +106,63 @@ public:
         bool dsp2;
         bool arm;
 
-        UpgradeFlags() : fpga(false), dsp1(false), dsp2(false), arm(false) {}
+        bool resume;                 // 请求保留上次未完成的升级状态（断点续传）
+        bool extended;               // 请求扩展寻址（32位包序号/64位文件大小）
+
+        UpgradeFlags() : fpga(false), dsp1(false), dsp2(false), arm(false), resume(false), extended(false) {}
 
         quint8 toByte() const {
             return (fpga ? 0x01 : 0x00) |
                    (dsp1 ? 0x02 : 0x00) |
                    (dsp2 ? 0x04 : 0x00) |
-                   (arm ? 0x08 : 0x00);
+                   (arm ? 0x08 : 0x00) |
+                   (resume ? 0x40 : 0x00) |
+                   (extended ? 0x80 : 0x00);
         }
     };
 
+    // 升级请求应答中 payload[1] 的能力位（旧版下位机只回复1字节）
+    static constexpr quint8 CAPABILITY_EXTENDED_ADDRESSING = 0x01;
+    static constexpr quint8 CAPABILITY_RESUME = 0x02;
+    static constexpr quint8 CAPABILITY_DELTA = 0x04;
+    static constexpr quint8 CAPABILITY_COMPRESSION = 0x08;
+    static constexpr quint8 CAPABILITY_WINDOW = 0x10;   // 能缓存乱序数据包，应答中的接收计数为连续接收的包数
+
+    // 差分数据包中数据内容之前的字段：包序号(4) + 块号(4)
+    static constexpr qsizetype DELTA_DATA_FIELDS = 8;
+
+    // 压缩数据包中数据内容之前的字段：包序号(4) + 块号(4) + 原始长度(2)
+    static constexpr qsizetype COMPRESSED_DATA_FIELDS = 10;
+
+    // 普通寻址的协议上限：16位包序号、32位文件大小
+    static constexpr quint32 MAX_PACKET_COUNT = 0xFFFF;
+    static constexpr quint64 MAX_FILE_SIZE = 0xFFFFFFFFull;
+
+    // 扩展寻址的协议上限：32位包序号、64位文件大小
+    static constexpr quint32 MAX_EXTENDED_PACKET_COUNT = 0xFFFFFFFFu;
+
+    /**
+     * @brief 解码后的帧
+     *
+     * raw 和 payload 都是视图，指向被解析的原始帧数据，不拥有内存；
+     * 只在原始数据有效期间可用（接收路径上即 nextReceivedFrame() 的下一次调用之前）。
+     */
+    struct Frame {
+        QByteArrayView raw;          // 完整帧（含帧头和CRC）
+        QByteArrayView payload;      // 命令数据
+        quint8 slaveId;
+        MessageType type;
+        ResponseFlag flag;
+
+        Frame() : slaveId(0), type(MessageType::DEBUG_INFO), flag(ResponseFlag::SUCCESS) {}
+    };
+
+    // 帧固定开销：帧头(2) + ID(1) + 长度(2) + 类型(1) + 标识(1) + CRC(2)
+    static constexpr qsizetype FRAME_OVERHEAD = 9;
+
+    // 给定命令数据长度时的整帧长度
+    static constexpr qsizetype frameSize(qsizetype payloadSize) { return FRAME_OVERHEAD + payloadSize; }
+
     explicit BootLoaderProtocol(QObject *parent = nullptr);
 
     // ============= 上位机发送接口 =============
@@ -137,6 +191,66 @@ public:
     QByteArray buildUpgradeCommand(quint8 slaveId, MessageType type,
                                    quint32 fileSize, quint16 packetCount, quint16 fileCRC);
 
+    /**
+     * @brief 构建扩展寻址的升级命令报文
+     * @param fileSize 文件大小（8字节，高字节在前）
+     * @param packetCount 数据包总数（4字节，高字节在前）
+     * @param fileCRC 文件CRC16校验值
+     */
+    QByteArray buildUpgradeCommandExtended(quint8 slaveId, MessageType type,
+                                           quint64 fileSize, quint32 packetCount, quint16 fileCRC);
+
+    /**
+     * @brief 构建断点续传报文
+     * @param commandType 续传设备的升级命令类型（ARM_COMMAND/FPGA_COMMAND/DSP1_COMMAND/DSP2_COMMAND）
+     * @param fileSize 文件大小（8字节，高字节在前）
+     * @param packetCount 数据包总数（4字节，高字节在前）
+     * @param fileCRC 文件CRC16校验值
+     * @param fromPacket 上位机记录的已累计确认包数（4字节，高字节在前）
+     */
+    QByteArray buildResume(quint8 slaveId, MessageType commandType, quint64 fileSize,
+                           quint32 packetCount, quint16 fileCRC, quint32 fromPacket);
+
+    /**
+     * @brief 构建差分升级指令报文
+     *
+     * 下位机确认当前固件与基线一致后只写入随后 DELTA_DATA 报文中的块，其余块保持不变。
+     * @param commandType 目标设备的升级命令类型（ARM_COMMAND/FPGA_COMMAND/DSP1_COMMAND/DSP2_COMMAND）
+     * @param baselineSize 基线固件大小（8字节，高字节在前）
+     * @param baselineCRC 基线固件CRC16
+     * @param fileSize 新固件大小（8字节，高字节在前）
+     * @param packetCount 差分数据包总数，即变化的块数（4字节，高字节在前）
+     * @param fileCRC 新固件CRC16，升级结束时下位机按它校验整个镜像
+     * @param blockSize 块大小，与分包大小相同
+     */
+    QByteArray buildDeltaCommand(quint8 slaveId, MessageType commandType,
+                                 quint64 baselineSize, quint16 baselineCRC,
+                                 quint64 fileSize, quint32 packetCount, quint16 fileCRC,
+                                 quint16 blockSize);
+
+    /**
+     * @brief 编码差分数据包报文中数据内容之前的部分
+     * @param packetNum 差分包序号（从1开始）
+     * @param block 块号（从0开始），块在镜像中的偏移 = 块号 * 块大小
+     * @return 写入的字节数（15）
+     */
+    static qsizetype encodeDeltaDataHeader(char *out, quint8 slaveId, quint32 packetNum,
+                                           quint32 block, qsizetype dataSize);
+
+    /**
+     * @brief 编码压缩数据包报文中数据内容之前的部分
+     *
+     * 数据内容是第 block 块的 LZ4 块格式压缩结果，下位机解压得到 rawSize 字节后写入；
+     * 数据内容长度等于 rawSize 时为未压缩的原始内容（该块压缩后不会变小）。
+     * @param packetNum 包序号（从1开始），与升级指令/差分升级指令的包序号一致
+     * @param block 块号（从0开始），块在镜像中的偏移 = 块号 * 分包大小
+     * @param rawSize 块的原始长度
+     * @param dataSize 随后的数据内容长度
+     * @return 写入的字节数（17）
+     */
+    static qsizetype encodeCompressedDataHeader(char *out, quint8 slaveId, quint32 packetNum,
+                                                quint32 block, quint16 rawSize, qsizetype dataSize);
+
     /**
      * @brief 构建升级数据包报文
      * @param slaveId 下位机ID
@@ -147,6 +261,34 @@ public:
     QByteArray buildUpgradeData(quint8 slaveId, MessageType type,
                                 quint16 packetNum, const QByteArray &data);
 
+    /**
+     * @brief 将升级数据包报文直接编码到调用者提供的缓冲区（不分配内存）
+     * @param out 输出缓冲区，至少 frameSize(2 + data.size()) 字节
+     * @return 写入的字节数
+     */
+    static qsizetype encodeUpgradeData(char *out, quint8 slaveId, MessageType type,
+                                       quint16 packetNum, QByteArrayView data);
+
+    /**
+     * @brief 编码升级数据包报文中数据内容之前的部分（帧头至包序号）
+     * @param dataSize 随后的升级文件内容长度，用于填写长度字段
+     * @param extended 扩展寻址：包序号占4字节，否则占2字节
+     * @return 写入的字节数（9 或 11）
+     */
+    static qsizetype encodeUpgradeDataHeader(char *out, quint8 slaveId, MessageType type,
+                                             quint32 packetNum, qsizetype dataSize, bool extended = false);
+
+    // 数据包报文中包序号字段的长度
+    static constexpr qsizetype packetNumberSize(bool extended) { return extended ? 4 : 2; }
+
+    /**
+     * @brief 将上位机报文直接编码到调用者提供的缓冲区（不分配内存）
+     * @param out 输出缓冲区，至少 frameSize(payload.size()) 字节
+     * @return 写入的字节数
+     */
+    static qsizetype encodeMasterFrame(char *out, quint8 slaveId, MessageType type,
+                                       ResponseFlag flag, QByteArrayView payload);
+
     /**
      * @brief 构建升级结束报文
      * @param slaveId 下位机ID
@@ -181,6 +323,19 @@ public:
      */
     QList<QByteArray> parseReceivedData(const QByteArray &data);
 
+    /**
+     * @brief 写入接收到的数据（不复制出帧）
+     * @return 实际写入的字节数，接收缓冲区已满时小于 size，需先取帧再继续写入
+     */
+    qsizetype feedReceivedData(const char *data, qsizetype size);
+
+    /**
+     * @brief 取出下一个完整帧
+     * @param frame 输出：指向接收缓冲区的帧视图，下一次调用 feedReceivedData()/nextReceivedFrame() 前有效
+     * @return 是否取到完整帧
+     */
+    bool nextReceivedFrame(QByteArrayView &frame);
+
     /**
      * @brief 解析单个完整帧
      * @param frame 完整帧数据
@@ -193,12 +348,21 @@ public:
     bool parseFrame(const QByteArray &frame, quint8 &slaveId, MessageType &type,
                    ResponseFlag &flag, QByteArray &payload);
 
+    /**
+     * @brief 原地解析单个完整帧（原地校验CRC，不复制数据）
+     * @param frame 完整帧数据
+     * @param decoded 输出：解码结果，字段视图指向 frame
+     * @return 解析是否成功
+     */
+    static bool parseFrame(QByteArrayView frame, Frame &decoded);
+
     // ============= 工具函数 =============
 
     /**
      * @brief 计算CRC16-MODBUS校验值
      */
     static quint16 calculateCRC16(const QByteArray &data);
+    static quint16 calculateCRC16(const char *data, qsizetype size);
 
     /**
      * @brief 获取响应标识描述
@@ -210,6 +374,13 @@ public:
      */
     static QString getMessageTypeDescription(MessageType type);
 
+    /**
+     * @brief 根据上位机报文内容生成描述（数据包附带包序号），用于日志
+     * @param frame 报文，可以只是开头的一部分（日志预览），长度按帧中的长度字段计
+     * @param extended 数据包是否使用扩展寻址（4字节包序号）
+     */
+    static QString describeMasterFrame(QByteArrayView frame, bool extended = false);
+
 private:
     // 帧头常量
     static constexpr quint8 MASTER_HEADER1 = 0xAA;  // 上位机帧头1
@@ -220,14 +391,31 @@ private:
     /**
      * @brief 构建上位机报文帧
      */
-    QByteArray buildMasterFrame(quint8 slaveId, MessageType type, ResponseFlag flag, const QByteArray &payload);
+    QByteArray buildMasterFrame(quint8 slaveId, MessageType type, ResponseFlag flag, QByteArrayView payload);
 
     /**
      * @brief 构建下位机报文帧
      */
-    QByteArray buildSlaveFrame(quint8 slaveId, MessageType type, ResponseFlag flag, const QByteArray &payload);
+    QByteArray buildSlaveFrame(quint8 slaveId, MessageType type, ResponseFlag flag, QByteArrayView payload);
+
+    /**
+     * @brief 编码帧头、长度、类型和标识（7字节），返回写入的字节数
+     */
+    static qsizetype encodeHeader(char *out, quint8 header1, quint8 header2, quint8 slaveId,
+                                  qsizetype frameLength, MessageType type, ResponseFlag flag);
+
+    /**
+     * @brief 对 [out, out+length) 计算CRC并追加在其后，返回整帧长度
+     */
+    static qsizetype appendCRC(char *out, qsizetype length);
+
+    /**
+     * @brief 获取固定内容的控制报文（复位、升级结束、总体结束），按从机ID缓存
+     */
+    QByteArray controlFrame(quint8 slaveId, MessageType type);
 
-    QByteArray m_receiveBuffer;  // 接收缓冲区
+    FrameDecoder m_decoder;  // 接收缓冲区（环形）
+    QHash<quint16, QByteArray> m_controlFrames;  // (从机ID << 8 | 报文类型) -> 预编码的控制报文
 };
 
 #endif // BOOTLOADER_PROTOCOL_H
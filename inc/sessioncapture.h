@@ -0,0 +1,89 @@
+#ifndef SESSIONCAPTURE_H
+#define SESSIONCAPTURE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+
+/**
+ * @brief 会话抓包 - 二进制记录每个收发报文
+ *
+ * 文件格式（小端）：
+ *   文件头 16 字节：magic "BLCP" | 版本 u16 | 文件头长度 u16 | 开始时间 i64（UTC毫秒）
+ *   每条记录：时间戳 u64（相对开始的单调纳秒）| 链路 u8 | 方向 u8 | 标志 u16 | 长度 u32 | 报文
+ *
+ * 写入先进入内存缓冲区，满一定大小再写文件，收发路径上只有一次内存复制。
+ */
+class SessionCapture
+{
+public:
+    enum class Link : quint8 {
+        Serial = 0,
+        Ethernet = 1
+    };
+
+    enum class Direction : quint8 {
+        Tx = 0,
+        Rx = 1
+    };
+
+    // 记录标志
+    static constexpr quint16 FLAG_CRC_ERROR = 0x0001;   // 接收帧CRC校验失败
+
+    static constexpr quint16 VERSION = 1;
+    static constexpr int FILE_HEADER_SIZE = 16;
+    static constexpr int RECORD_HEADER_SIZE = 16;
+
+    struct Record {
+        quint64 timestampNs = 0;
+        Link link = Link::Serial;
+        Direction direction = Direction::Tx;
+        quint16 flags = 0;
+        QByteArray data;
+    };
+
+    SessionCapture();
+    ~SessionCapture();
+
+    bool open(const QString &path, QString *errorString = nullptr);
+    void close();
+    bool isOpen() const { return m_file.isOpen(); }
+    QString filePath() const { return m_file.fileName(); }
+
+    void write(Link link, Direction direction, QByteArrayView frame, quint16 flags = 0);
+
+private:
+    Q_DISABLE_COPY(SessionCapture)
+
+    void flush();
+
+    QFile m_file;
+    QElapsedTimer m_clock;
+    QByteArray m_buffer;
+};
+
+/**
+ * @brief 会话抓包读取器
+ */
+class SessionCaptureReader
+{
+public:
+    bool open(const QString &path, QString *errorString = nullptr);
+
+    // 抓包开始时刻（UTC毫秒）
+    qint64 startTime() const { return m_startTime; }
+
+    /**
+     * @brief 读取下一条记录
+     * @return 文件结束或记录不完整时返回 false
+     */
+    bool next(SessionCapture::Record &record);
+
+private:
+    QFile m_file;
+    qint64 m_startTime = 0;
+};
+
+#endif // SESSIONCAPTURE_H
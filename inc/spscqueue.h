@@ -0,0 +1,81 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 单生产者单消费者无锁环形队列
+ *
+ * 只允许一个线程调用 tryPush()、另一个线程调用 tryPop()。两端各自只写自己的下标，
+ * 通过 acquire/release 交接元素，不使用互斥锁。容量向上取整为2的幂。
+ */
+template <typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(std::size_t capacity)
+        : m_mask(roundUpPowerOfTwo(capacity) - 1)
+        , m_slots(m_mask + 1)
+        , m_head(0)
+        , m_tail(0)
+    {
+    }
+
+    std::size_t capacity() const { return m_mask + 1; }
+
+    /**
+     * @brief 生产者：写入一个元素
+     * @return 队列已满时返回 false，元素保持不变
+     */
+    bool tryPush(T &&value)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) > m_mask) {
+            return false;
+        }
+        m_slots[tail & m_mask] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 消费者：取出一个元素
+     * @return 队列为空时返回 false
+     */
+    bool tryPop(T &value)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(m_slots[head & m_mask]);
+        m_slots[head & m_mask] = T();   // 及时释放元素持有的资源
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    Q_DISABLE_COPY(SpscQueue)
+
+    static std::size_t roundUpPowerOfTwo(std::size_t value)
+    {
+        std::size_t result = 2;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const std::size_t m_mask;
+    std::vector<T> m_slots;
+
+    // 两端下标分处不同缓存行，避免生产者和消费者互相失效
+    alignas(64) std::atomic<std::size_t> m_head;   // 消费者写
+    alignas(64) std::atomic<std::size_t> m_tail;   // 生产者写
+};
+
+#endif // SPSCQUEUE_H
@@ -0,0 +1,93 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <array>
+#include <functional>
+
+/**
+ * @brief 时间轮 - 同一线程内所有升级会话共用的超时计时
+ *
+ * 每个线程一个实例，由一个周期性 QTimer 按单调时钟推进；定时器按到期刻度
+ * 挂在对应槽位的双向链表上，启动、重新启动、停止都只是链表操作（O(1)），
+ * 不经过事件分发器。到期时间超过一圈的定时器留在槽位中，转到到期那一圈时触发。
+ * 没有活动定时器时停止推进，空闲线程不会被周期性唤醒。
+ *
+ * 精度为刻度：回调不会早于设定时间触发，最多晚两个 TICK_MS（不计事件循环本身的延迟）。
+ *
+ * 不加锁：定时器的启动、停止和析构都必须在启动它的线程中进行。UpgradeManager 依赖这一点，
+ * 在I/O线程退出、销毁本线程时间轮之前于同一线程中停止并销毁其定时器。
+ */
+class TimerWheel : public QObject
+{
+    Q_OBJECT
+
+    struct Node {
+        Node *prev = nullptr;
+        Node *next = nullptr;
+    };
+
+public:
+    static constexpr int TICK_MS = 5;
+    static constexpr int SLOT_COUNT = 512;      // 一圈约 2.56s
+
+    /**
+     * @brief 单次定时器，只能在同一线程中启动、停止和销毁
+     *
+     * 启动时挂到当前线程的时间轮上，因此所属对象可以在启动前移动到其他线程；
+     * 处于活动状态时 stop() 和析构函数必须在启动它的线程中调用，否则会与该线程的
+     * 时间轮同时修改槽位链表。
+     */
+    class Timer : private Node
+    {
+    public:
+        explicit Timer(std::function<void()> callback);
+        ~Timer();
+
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+        // 启动或重新启动，ms 后调用回调
+        void start(int ms);
+        void stop();
+
+        bool isActive() const { return wheel != nullptr; }
+        int interval() const { return intervalMs; }
+
+    private:
+        friend class TimerWheel;
+
+        TimerWheel *wheel = nullptr;
+        quint64 expiry = 0;         // 到期刻度
+        int intervalMs = 0;
+        std::function<void()> callback;
+    };
+
+    ~TimerWheel();
+
+    // 当前线程的时间轮（线程结束时销毁）
+    static TimerWheel *forCurrentThread();
+
+    int activeCount() const { return activeTimers; }
+
+private:
+    TimerWheel();
+
+    void add(Timer *timer, int ms);
+    void remove(Timer *timer);
+    void advance();
+    quint64 elapsedTicks() const { return static_cast<quint64>(clock.elapsed()) / TICK_MS; }
+
+    static void linkTail(Node &list, Node *node);
+    static void unlink(Node *node);
+
+    std::array<Node, SLOT_COUNT> slotLists;
+    QElapsedTimer clock;
+    QTimer tickTimer;
+    quint64 currentTick;        // 已处理到的刻度
+    int activeTimers;
+};
+
+#endif // TIMERWHEEL_H
@@ -0,0 +1,165 @@
+#ifndef TRANSFERPLAN_H
+#define TRANSFERPLAN_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QVector>
+#include <functional>
+
+#include "protocol.h"
+#include "firmwareimage.h"
+
+/**
+ * @brief 传输计划 - 一个固件镜像的全部数据包报文
+ *
+ * 加载固件时在后台顺序读一遍镜像，预先算好整个文件的CRC和每个 *_DATA 报文的CRC，
+ * 计划本身每包只占2字节。发送或重传时只需把帧头、从读取器取得的数据段和CRC
+ * 依次写入发送缓冲区，不再计算CRC，也不持有镜像的副本。
+ *
+ * 给出基线镜像（下位机当前的固件）时，同一遍读取中逐块比较新旧镜像，另外记下
+ * 内容有变化的块及其 DELTA_DATA 报文的CRC。切换到差分模式后，包数、包长和
+ * assemble() 都只针对变化的块，完整模式的计划保留，下位机拒绝差分时可直接退回。
+ *
+ * 要求压缩时，同一遍读取中把每块用 LZ4 独立压缩，只保留比原始内容短的结果，
+ * 并另外算好 COMPRESSED_DATA 报文的CRC。压缩结果是计划中唯一随镜像大小增长的部分，
+ * 总量小于镜像本身；发送和重传时直接拷贝，不再压缩。压缩模式与完整/差分模式可以组合，
+ * 未变小的块仍在压缩报文中按原始内容发送。
+ */
+class TransferPlan
+{
+public:
+    TransferPlan();
+
+    /**
+     * @brief 为镜像计算全部数据包报文的CRC
+     * @param slaveId 下位机ID
+     * @param dataType 报文类型（ARM_DATA/FPGA_DATA/DSP1_DATA/DSP2_DATA）
+     * @param image 固件镜像
+     * @param packetSize 分包大小
+     * @param extended 是否使用扩展寻址（4字节包序号）
+     * @param baseline 可选，基线镜像，按分包大小分块与新镜像比较
+     * @param compress 是否预先压缩各块，分包大小超过 65535 时忽略
+     * @param isCanceled 可选，返回 true 时放弃计算并返回空计划
+     */
+    static TransferPlan build(quint8 slaveId, BootLoaderProtocol::MessageType dataType,
+                              QSharedPointer<const FirmwareImage> image, int packetSize,
+                              bool extended = false,
+                              QSharedPointer<const FirmwareImage> baseline = QSharedPointer<const FirmwareImage>(),
+                              bool compress = false,
+                              const std::function<bool()> &isCanceled = std::function<bool()>());
+
+    bool isEmpty() const { return m_packetCount == 0; }
+
+    // 当前模式下的数据包数：完整模式为全部分包，差分模式为变化的块数
+    qint64 packetCount() const { return m_deltaMode ? m_deltaBlocks.size() : m_packetCount; }
+    qint64 blockCount() const { return m_packetCount; }
+    bool isExtended() const { return m_extended; }
+
+    // 整个镜像的CRC16，与报文CRC在同一遍读取中算出
+    quint16 fileCRC() const { return m_fileCRC; }
+
+    // 整个镜像的SHA-256，同一遍读取中算出，断点续传时用于确认镜像未变
+    QByteArray digest() const { return m_digest; }
+
+    // 是否与基线比较过；基线的大小和CRC16用于让下位机确认其当前固件就是该基线
+    bool hasBaseline() const { return m_baselineSize >= 0; }
+    qint64 baselineSize() const { return m_baselineSize; }
+    quint16 baselineCRC() const { return m_baselineCRC; }
+
+    // 与基线相比内容有变化的块数及字节数
+    qint64 deltaPacketCount() const { return m_deltaBlocks.size(); }
+    quint64 deltaBytes() const { return m_deltaBytes; }
+
+    // 切换完整/差分模式，差分模式只在有基线时可用
+    void setDeltaMode(bool delta) { m_deltaMode = delta && hasBaseline(); }
+    bool isDeltaMode() const { return m_deltaMode; }
+
+    // 当前（完整或差分）模式下全部数据包的原始字节数与压缩后的字节数
+    quint64 transferBytes() const
+    {
+        return m_deltaMode ? m_deltaBytes : static_cast<quint64>(m_image ? m_image->size() : 0);
+    }
+    quint64 compressedBytes() const { return m_deltaMode ? m_deltaCompressedBytes : m_compressedBytes; }
+
+    // 当前模式下全部数据包报文在链路上的总字节数（含帧头、报文字段和CRC），用于比较是否值得压缩
+    quint64 frameBytes(bool compressed) const
+    {
+        return static_cast<quint64>(packetCount()) * BootLoaderProtocol::frameSize(fieldSize(compressed)) +
+               (compressed ? compressedBytes() : transferBytes());
+    }
+
+    // 切换压缩模式，只在构建时要求压缩的计划中可用
+    bool hasCompression() const { return m_compressed; }
+    void setCompressedMode(bool compressed) { m_compressedMode = compressed && m_compressed; }
+    bool isCompressedMode() const { return m_compressedMode; }
+
+    // 第 index 包（从0开始）的数据内容长度（压缩前）
+    qsizetype dataSize(qint64 index) const;
+
+    // 第 index 包实际发送的数据内容长度：压缩模式下为压缩后的长度，否则同 dataSize()
+    qsizetype wireSize(qint64 index) const;
+
+    // 第 index 包的完整报文长度
+    qsizetype frameSize(qint64 index) const
+    {
+        return BootLoaderProtocol::frameSize(fieldSize(m_compressedMode) + wireSize(index));
+    }
+
+    /**
+     * @brief 组装第 index 包的完整报文
+     * @param reader 该镜像的读取器，由调用方持有以复用映射窗口
+     * @param out 输出缓冲区，至少 frameSize(index) 字节
+     * @return 写入的字节数，索引无效或读取失败时返回0
+     */
+    qsizetype assemble(qint64 index, FirmwareImage::Reader &reader, char *out) const;
+
+private:
+    // 数据包报文中数据内容之前的字段长度（包序号、块号、原始长度）
+    qsizetype fieldSize(bool compressed) const
+    {
+        return compressed ? BootLoaderProtocol::COMPRESSED_DATA_FIELDS
+             : m_deltaMode ? BootLoaderProtocol::DELTA_DATA_FIELDS
+                           : BootLoaderProtocol::packetNumberSize(m_extended);
+    }
+
+    // 第 block 块（完整模式的分包）的数据内容长度
+    qsizetype blockSize(qint64 block) const;
+
+    // 第 index 包对应的块号
+    qint64 blockAt(qint64 index) const
+    {
+        return m_deltaMode ? m_deltaBlocks[static_cast<qsizetype>(index)] : index;
+    }
+
+    // 第 block 块压缩后的长度，0 表示该块按原始内容发送
+    qsizetype compressedSize(qint64 block) const
+    {
+        return static_cast<qsizetype>(m_compressedOffsets[block + 1] - m_compressedOffsets[block]);
+    }
+
+    QSharedPointer<const FirmwareImage> m_image;
+    QVector<quint16> m_frameCRCs;   // 每包完整报文的CRC
+    QByteArray m_digest;
+    QVector<quint32> m_deltaBlocks; // 有变化的块号，按升序
+    QVector<quint16> m_deltaCRCs;   // 对应 DELTA_DATA 报文的CRC
+    quint64 m_deltaBytes;
+    QByteArray m_compressedData;    // 各块压缩结果依次拼接
+    QVector<qint64> m_compressedOffsets; // 第 i 块压缩结果在 m_compressedData 中的起止位置
+    QVector<quint16> m_compressedCRCs;   // 完整模式下各包 COMPRESSED_DATA 报文的CRC
+    QVector<quint16> m_deltaCompressedCRCs; // 差分模式下各包 COMPRESSED_DATA 报文的CRC
+    quint64 m_compressedBytes;      // 完整模式下压缩报文数据内容的总字节数
+    quint64 m_deltaCompressedBytes;
+    bool m_compressed;
+    bool m_compressedMode;
+    qint64 m_baselineSize;          // 没有基线时为 -1
+    quint16 m_baselineCRC;
+    bool m_deltaMode;
+    BootLoaderProtocol::MessageType m_dataType;
+    quint16 m_fileCRC;
+    quint8 m_slaveId;
+    bool m_extended;
+    int m_packetSize;
+    qint64 m_packetCount;
+};
+
+#endif // TRANSFERPLAN_H
@@ -2,12 +2,21 @@
 #define UPGRADE_H
 
 #include <QObject>
-#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
 #include <QByteArray>
 #include <QList>
+#include <QMap>
+#include <QDateTime>
+#include <QFuture>
+#include <QScopedPointer>
+#include <QSharedPointer>
 #include "protocol.h"
-
-class MainWindow; // 前向声明
+#include "firmwareimage.h"
+#include "transferplan.h"
+#include "timerwheel.h"
+#include "upgradejournal.h"
+#include "upgradetelemetry.h"
 
 /**
  * @brief 升级管理器 - 处理固件升级流程
@@ -22,6 +31,7 @@ public:
         IDLE,                    // 空闲状态
         WAIT_UPGRADE_REQUEST,    // 等待升级请求回复
         WAIT_SYSTEM_RESET,       // 等待系统复位回复
+        WAIT_RESUME,             // 等待断点续传回复
         WAIT_UPGRADE_COMMAND,    // 等待升级指令回复
         WAIT_UPGRADE_DATA,       // 等待升级数据回复
         WAIT_UPGRADE_END,        // 等待升级结束回复
@@ -38,19 +48,77 @@ public:
         ARM
     };
 
+    // 在途数据包状态，按 包索引 % 窗口上限 存放，只覆盖当前窗口
+    struct InFlightPacket {
+        qint64 sendTime;             // 最近一次发送的时间戳(us)
+        bool acked;                  // 逐包确认标记，用于选择性重传
+        bool retransmitted;          // 重传过的包不参与RTT采样（Karn算法）
+
+        InFlightPacket() : sendTime(0), acked(false), retransmitted(false) {}
+    };
+
     // 固件信息结构
     struct FirmwareInfo {
         QString filePath;
-        QByteArray fileData;
-        quint32 fileSize;
-        quint16 packetCount;
+        QSharedPointer<FirmwareImage> image;  // 只读镜像，固件信息的各个副本共享
+        quint64 fileSize;
+        quint64 transferSize;        // 需要传输的字节数：完整升级为文件大小，差分升级为变化块的大小
+        quint32 packetCount;         // 需要传输的包数（差分升级为变化的块数）
         quint16 fileCRC;
-        quint16 currentPacket;
+        quint32 currentPacket;       // 已被累计确认的包数（窗口下沿）
+        quint32 nextPacket;          // 下一个首次发送的包索引（窗口上沿）
         quint16 packetSize;
         DeviceType deviceType;
+        QVector<InFlightPacket> inFlight; // 窗口内各包的确认/发送状态
+        QFuture<TransferPlan> planFuture; // 加载时在后台计算的文件CRC与数据包报文CRC
+        TransferPlan plan;           // 发送升级指令前从 planFuture 取出
+        int gapAckCount;             // 窗口下沿缺包时收到的越序应答次数
+    };
+
+    // 进度快照，数据阶段按固定频率采样发出
+    struct Progress {
+        DeviceType device;
+        int devicePercent;           // 当前设备进度(%)
+        int totalPercent;            // 总体进度(%)
+        quint64 deviceBytes;         // 当前设备已确认的字节数
+        quint64 deviceTotalBytes;
+        quint64 overallBytes;        // 全部设备已确认的字节数
+        quint64 overallTotalBytes;
+        double bytesPerSecond;       // 指数平滑后的吞吐
+        double packetsPerSecond;
+        qint64 deviceEtaMs;          // 当前设备剩余时间，-1 表示尚无法估计
+        qint64 totalEtaMs;           // 全部数据剩余传输时间（不含后续设备的擦除/校验）
+        quint64 retransmits;         // 本次升级重传的数据包数
+        quint64 timeouts;            // 本次升级的超时重发次数
+
+        Progress()
+            : device(DeviceType::FPGA), devicePercent(0), totalPercent(0)
+            , deviceBytes(0), deviceTotalBytes(0), overallBytes(0), overallTotalBytes(0)
+            , bytesPerSecond(0.0), packetsPerSecond(0.0), deviceEtaMs(-1), totalEtaMs(-1)
+            , retransmits(0), timeouts(0) {}
+    };
+
+    // 数据包往返时延估计（RFC 6298：平滑RTT + 偏差）
+    struct RttEstimator {
+        double srtt;
+        double rttvar;
+        bool hasSample;
+
+        RttEstimator() : srtt(0.0), rttvar(0.0), hasSample(false) {}
+
+        void addSample(qint64 rttMs);
+        int timeout() const;
     };
 
-    explicit UpgradeManager(MainWindow *parent);
+    // 设备名称（"FPGA"/"DSP1"/"DSP2"/"ARM"），用于显示、断点记录和基线文件名
+    static QString deviceName(DeviceType device);
+
+    // 设备对应的升级指令/升级数据/升级结束报文类型
+    static BootLoaderProtocol::MessageType commandType(DeviceType device);
+    static BootLoaderProtocol::MessageType dataType(DeviceType device);
+    static BootLoaderProtocol::MessageType endType(DeviceType device);
+
+    explicit UpgradeManager(QObject *parent = nullptr);
     ~UpgradeManager();
 
     // 启动升级
@@ -63,7 +131,15 @@ public:
     // 处理接收到的响应
     void handleResponse(BootLoaderProtocol::MessageType msgType,
                        BootLoaderProtocol::ResponseFlag flag,
-                       const QByteArray &payload);
+                       QByteArrayView payload);
+
+    /**
+     * @brief 选择固件文件后立即在后台准备（打开、计算CRC、分包）
+     *
+     * 结果按设备缓存，启动升级时文件、从机ID、分包大小都未改变则直接使用，
+     * 无需在点击升级后再读取镜像。
+     */
+    void preloadFirmware(DeviceType device, const QString &path, quint8 slaveId, int packetSize);
 
     // 获取当前状态
     UpgradeState currentState() const { return upgradeState; }
@@ -71,6 +147,44 @@ public:
     // 停止升级
     void stopUpgrade();
 
+    // 滑动窗口大小（允许同时在途的数据包数），1 表示停等模式；下位机未声明支持滑动窗口时按1传输
+    void setWindowSize(int size);
+    int windowSize() const { return transferWindow; }
+
+    /**
+     * @brief 断点记录文件，为空时不记录也不续传
+     *
+     * 数据传输中定期写入当前进度，链路断开、失败或取消后保留；下次升级同一组固件时
+     * 若下位机支持，从记录的位置续传，不再复位和擦除。全部设备升级成功后删除。
+     */
+    void setJournalPath(const QString &path) { journalFile = path; }
+    QString journalPath() const { return journalFile; }
+
+    /**
+     * @brief 基线固件目录，为空时不做差分升级
+     *
+     * 每个设备升级成功后，把写入的固件复制为该目录下的 <设备>.bin，作为下位机当前固件的副本。
+     * 下次升级时若下位机支持差分，只传输与基线相比内容有变化的块；下位机确认其固件与基线
+     * 不一致时自动改为完整升级。
+     */
+    void setBaselineDir(const QString &dir) { baselineDirectory = dir; }
+    QString baselineDir() const { return baselineDirectory; }
+
+    /**
+     * @brief 是否压缩传输，默认开启
+     *
+     * 开启时加载固件的后台计算中逐块做 LZ4 压缩；下位机声明支持压缩且压缩后总量变小时，
+     * 数据阶段改用压缩报文发送。修改后对之后准备的固件生效。
+     */
+    void setCompressionEnabled(bool enabled) { compressFirmware = enabled; }
+    bool compressionEnabled() const { return compressFirmware; }
+
+    // 本次升级是否使用扩展寻址（32位包序号）
+    bool isExtendedAddressing() const { return extendedAddressing; }
+
+    // 最近一次（或正在进行的）升级的统计数据
+    const UpgradeTelemetry &lastTelemetry() const { return telemetry; }
+
 signals:
     // 需要发送数据
     void sendData(const QByteArray &data, const QString &description);
@@ -78,16 +192,33 @@ signals:
     // 显示信息
     void showInfo(const QString &text);
 
-    // 升级进度更新
-    void progressUpdated(int currentDevice, int totalDevice);
+    // 升级进度更新（最多每 100ms 一次，设备开始和完成时立即发出）
+    void progressUpdated(const UpgradeManager::Progress &progress);
+
+    // 升级结束时给出本次升级的统计数据，在 upgradeFinished 之前发出
+    void telemetryReady(const UpgradeTelemetry &telemetry);
 
     // 升级完成
     void upgradeFinished(bool success, const QString &message);
 
-private slots:
-    void onTimeout();
-
 private:
+    // 选择文件时启动的后台准备任务
+    struct PreparedFirmware {
+        QSharedPointer<FirmwareImage> image;
+        QDateTime lastModified;      // 用于发现选择后被改写的文件
+        quint8 slaveId;
+        int packetSize;
+        bool extended;
+        QString baselinePath;        // 计算时使用的基线，为空表示没有基线
+        QDateTime baselineModified;
+        bool compress;               // 计算时是否压缩各块
+        QFuture<TransferPlan> planFuture;
+    };
+
+    QFuture<TransferPlan> startTransferPlan(DeviceType device, const QSharedPointer<FirmwareImage> &image,
+                                            quint8 slaveId, int packetSize, bool extended,
+                                            const QSharedPointer<FirmwareImage> &baseline, bool compress);
+
     // 准备固件文件
     bool prepareFirmware(int packetSize,
                         bool upgradeFPGA, bool upgradeDSP1,
@@ -98,30 +229,92 @@ private:
     // 发送各个阶段的报文
     void sendUpgradeRequest();
     void sendSystemReset();
+    void sendResume();
     void startDeviceUpgrade(DeviceType device);
     void sendUpgradeCommand();
     void sendUpgradeData();
+    void sendDataPacket(quint32 index, bool retransmit);
+    void retransmitMissingPackets(quint32 limit);
     void sendUpgradeEnd();
     void sendTotalEnd();
 
     // 辅助函数
     void upgradeComplete(bool success, const QString &message);
     void resetState();
-    void updateProgress();
+    void updateProgress(bool force = false);
+    void resetRateSample();
+    void enterPhase(UpgradeTelemetry::Phase phase);
+    void closePhase();
+    qint64 elapsedUs() const { return rttClock.nsecsElapsed() / 1000; }
     QString failureMessageForFlag(BootLoaderProtocol::ResponseFlag flag) const;
+    void handleDataAck(FirmwareInfo &fw, quint32 packetNum, quint32 receivedCount);
+    bool resolveTransferPlan(FirmwareInfo &fw);
+    bool takeTransferPlan(FirmwareInfo &fw);
+    bool planInUse(DeviceType device) const;
+
+    // 断点续传
+    bool journalMatches(const UpgradeJournal &journal) const;
+    bool journalDigestsMatch();
+    void resumeUpgrade();
+    void writeCheckpoint(int deviceIndex, quint32 ackedPackets);
+    void discardJournal();
+
+    // 差分升级
+    QString baselinePathFor(DeviceType device) const;
+    void selectDeltaMode(FirmwareInfo &fw, bool delta);
+    void storeBaseline(const FirmwareInfo &fw);
+
+    // 压缩传输
+    void selectCompression(FirmwareInfo &fw);
+
+    // 超时计时
+    void onTimeout();
+    void armTimer();
+    int phaseTimeout() const;
+    int maxRetries() const;
 
-    MainWindow *mainWindow;
     BootLoaderProtocol protocol;
 
     // 升级状态
     UpgradeState upgradeState;
     QList<FirmwareInfo> firmwareList;
+    QMap<DeviceType, PreparedFirmware> preparedFirmware;
     int currentFirmwareIndex;
     quint8 slaveId;
     int retryCount;
-    QTimer *upgradeTimer;
-    int totalPackets;
-    int sentPackets;
+    TimerWheel::Timer upgradeTimer;   // 本线程所有会话共用时间轮，重新计时不经过事件分发器
+    QElapsedTimer rttClock;
+    RttEstimator dataRtt;
+    QByteArray txBuffer;        // 数据包发送缓冲区，按最大包长预分配后反复使用
+    QScopedPointer<FirmwareImage::Reader> dataReader; // 当前镜像的窗口读取器
+    bool extendedAddressing;    // 本次升级使用32位包序号/64位文件大小
+    qint64 totalPackets;
+    qint64 sentPackets;
+    quint64 totalBytes;         // 全部固件的字节数
+    quint64 completedBytes;     // 已完成设备的字节数
+    qint64 lastProgressTime;    // 上次发出进度的时刻(ms, rttClock)
+    qint64 rateSampleTime;      // 吞吐采样起点
+    quint64 rateSampleBytes;
+    qint64 rateSamplePackets;
+    double bytesRate;           // 指数平滑的字节/秒，0 表示尚无样本
+    double packetRate;
+    UpgradeTelemetry telemetry;
+    UpgradeTelemetry::Phase currentPhase;
+    int phaseDevice;            // 当前阶段所属的固件索引，非设备阶段为 -1
+    qint64 phaseStartUs;
+    bool phaseActive;
+    int transferWindow;
+    int activeWindow;               // 本次升级实际使用的窗口，下位机未声明支持滑动窗口时为1
+    QString journalFile;
+    UpgradeJournal::Writer journalWriter;
+    UpgradeJournal resumeJournal;   // 本次升级请求续传的断点，无效表示完整升级
+    qint64 lastCheckpointTime;      // 上次写入断点的时刻(ms, rttClock)
+    bool journalError;              // 本次升级已报告过写入失败
+    QString baselineDirectory;
+    QList<QFuture<void>> baselineWriters;   // 后台写入基线的任务，已完成的在下次保存时移除
+    bool deltaSupported;            // 下位机在升级请求应答中声明支持差分升级
+    bool compressFirmware;
+    bool compressionSupported;      // 下位机在升级请求应答中声明支持压缩报文
 };
 
 #endif // UPGRADE_H
@@ -0,0 +1,88 @@
+#ifndef UPGRADEJOURNAL_H
+#define UPGRADEJOURNAL_H
+
+#include <QByteArray>
+#include <QFuture>
+#include <QJsonObject>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+/**
+ * @brief 升级断点记录 - 断点续传所需的最小状态
+ *
+ * 数据传输过程中由 UpgradeManager 定期写入一个小的 JSON 文件：各固件的路径、大小、
+ * 分包和 SHA-256，当前设备，以及该设备已被累计确认的包数。链路断开或程序退出后
+ * 再次升级同一组固件时据此请求下位机续传，不再复位和擦除。
+ *
+ * 文件通过 QSaveFile 整体替换，写入中途退出不会留下半个记录。升级过程中经 Writer
+ * 在线程池中写入，应答处理不等待磁盘。
+ */
+struct UpgradeJournal {
+    struct Image {
+        QString device;             // "FPGA" / "DSP1" / "DSP2" / "ARM"
+        QString path;
+        quint64 size = 0;
+        QByteArray digest;          // 镜像的SHA-256，传输计划尚未算出时为空
+        int packetSize = 0;
+        quint32 packetCount = 0;
+    };
+
+    quint8 slaveId = 0;
+    bool extended = false;
+    QList<Image> images;            // 按升级顺序
+    int deviceIndex = 0;            // 正在传输的固件索引，等于 images.size() 表示只差总体结束
+    quint32 ackedPackets = 0;       // 该固件已被累计确认的包数
+    qint64 updated = 0;             // 写入时刻（UTC毫秒）
+
+    bool isValid() const { return !images.isEmpty(); }
+
+    QJsonObject toJson() const;
+    static UpgradeJournal fromJson(const QJsonObject &json);
+
+    bool save(const QString &path, QString *errorString = nullptr) const;
+
+    // 文件不存在或格式错误时返回无效记录
+    static UpgradeJournal load(const QString &path);
+    static void remove(const QString &path);
+
+    /**
+     * @brief 后台写入器 - 在线程池中依次执行写入和删除
+     *
+     * 只保留最新一次请求：前一次尚未开始时被替换，断点记录只需要最终状态。
+     * 请求方只做序列化，不等待写入和 fsync；析构时等待正在进行的一次写入结束。
+     */
+    class Writer
+    {
+    public:
+        Writer() = default;
+        ~Writer();
+
+        Writer(const Writer &) = delete;
+        Writer &operator=(const Writer &) = delete;
+
+        void save(const QString &path, const UpgradeJournal &journal);
+        void remove(const QString &path);
+
+        // 等待已提交的请求全部完成（读取记录之前调用）
+        void flush();
+
+        // 取出并清除最近一次写入失败的原因，没有失败时为空
+        QString takeError();
+
+    private:
+        void submit(const QString &path, const QByteArray &data, bool remove);
+        void run();
+
+        QMutex mutex;
+        QFuture<void> worker;
+        bool running = false;           // 后台任务已启动且尚未退出
+        bool pending = false;           // 有尚未执行的请求
+        QString pendingPath;
+        QByteArray pendingData;
+        bool pendingRemove = false;
+        QString error;
+    };
+};
+
+#endif // UPGRADEJOURNAL_H
@@ -0,0 +1,96 @@
+#ifndef UPGRADESESSION_H
+#define UPGRADESESSION_H
+
+#include <QObject>
+#include <QString>
+#include <QTimer>
+
+#include "communication.h"
+#include "upgrade.h"
+
+/**
+ * @brief 无界面升级会话 - 一条链路、一个从机ID的完整升级
+ *
+ * 持有自己的 CommunicationManager 和 UpgradeManager，依次完成
+ * 打开链路 -> 升级 -> 关闭链路，结果以 finished() 通知。
+ * 只依赖 QtCore/Network/SerialPort，可在 QCoreApplication 或任意工作线程中运行。
+ */
+class UpgradeSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 升级目标：链路参数、从机ID、分包与固件
+    struct Target {
+        CommunicationManager::LinkType link = CommunicationManager::LinkType::Ethernet;
+        QString portName;           // 串口
+        qint32 baudRate = 115200;
+        QString host;               // 网口
+        quint16 port = 503;
+        quint8 slaveId = 1;
+        int packetSize = 1024;
+        int windowSize = 1;
+        QString fpgaPath;           // 为空表示不升级该设备
+        QString dsp1Path;
+        QString dsp2Path;
+        QString armPath;
+        QString capturePath;        // 非空时抓取本次会话的全部收发报文
+        QString journalPath;        // 非空时记录断点，并在下次升级同一组固件时续传
+        QString baselineDir;        // 非空时保存成功写入的固件，下次升级时下位机支持则差分传输
+        bool compress = true;       // 下位机支持时压缩传输
+
+        // 日志和结果中使用的名称，如 "COM3#1"、"192.168.1.10:503#1"
+        QString name() const;
+    };
+
+    // 会话结果，命令行工具直接映射为退出码
+    enum class Status {
+        Success,
+        UpgradeFailed,      // 设备拒绝、校验失败或重试耗尽
+        LinkError,          // 无法打开链路，或升级中链路断开
+        InvalidImage,       // 固件文件不存在、为空或读取失败
+        Cancelled
+    };
+    Q_ENUM(Status)
+
+    explicit UpgradeSession(const Target &target, QObject *parent = nullptr);
+
+    const Target &target() const { return m_target; }
+    bool isRunning() const { return m_running; }
+
+    // 会话内的对象只能在会话所在线程中访问
+    CommunicationManager *communication() { return &m_comm; }
+    UpgradeManager *upgrade() { return &m_upgrade; }
+
+    static QString statusName(Status status);
+
+public slots:
+    /**
+     * @brief 打开链路并开始升级，结果以 finished() 通知（启动失败时也会发出）
+     */
+    void start();
+
+    // 停止升级并关闭链路，以 Cancelled 结束
+    void cancel();
+
+signals:
+    void showInfo(const QString &text);
+    void progressUpdated(const UpgradeManager::Progress &progress);
+    void telemetryReady(const UpgradeTelemetry &telemetry);
+    void finished(UpgradeSession::Status status, const QString &message);
+
+private:
+    void onConnectionStateChanged(bool connected);
+    void onLinkError(const QString &message);
+    void beginUpgrade();
+    void finish(Status status, const QString &message);
+
+    Target m_target;
+    CommunicationManager m_comm;
+    UpgradeManager m_upgrade;
+    QTimer m_connectTimer;
+    bool m_running = false;
+    bool m_upgrading = false;
+};
+
+#endif // UPGRADESESSION_H
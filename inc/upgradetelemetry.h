@@ -0,0 +1,120 @@
+#ifndef UPGRADETELEMETRY_H
+#define UPGRADETELEMETRY_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <array>
+
+/**
+ * @brief 延迟直方图 - 以2为底的对数分桶（微秒）
+ *
+ * 第0桶为 [0, 1us)，第 i 桶为 [2^(i-1), 2^i) us，最后一桶收纳更大的值。
+ * 分桶固定，记录一个样本只做一次位运算，不保存样本本身。
+ */
+class LatencyHistogram
+{
+public:
+    static constexpr int BUCKETS = 24;      // 最后一桶下限约 4.2s
+
+    void add(qint64 us);
+    void merge(const LatencyHistogram &other);
+
+    quint64 count() const { return m_count; }
+    qint64 min() const { return m_count ? m_min : 0; }
+    qint64 max() const { return m_max; }
+    double mean() const { return m_count ? static_cast<double>(m_sum) / m_count : 0.0; }
+
+    /**
+     * @brief 估计百分位数（返回所在桶的上界，不超过最大值）
+     * @param p 0.0 ~ 1.0
+     */
+    qint64 percentile(double p) const;
+
+    quint64 bucketCount(int bucket) const { return m_buckets[bucket]; }
+    static qint64 bucketUpperBound(int bucket);
+
+private:
+    std::array<quint64, BUCKETS> m_buckets = {};
+    quint64 m_count = 0;
+    qint64 m_sum = 0;
+    qint64 m_min = 0;
+    qint64 m_max = 0;
+};
+
+/**
+ * @brief 一次升级的统计数据
+ *
+ * 由 UpgradeManager 在升级过程中填写，升级结束时通过 telemetryReady 信号给出，
+ * 可输出为文本摘要或 JSON，用于比较不同链路和分包大小的实际表现。
+ */
+struct UpgradeTelemetry {
+    // 升级阶段
+    enum class Phase {
+        Request,        // 升级请求
+        Reset,          // 系统复位
+        Erase,          // 升级指令（擦除Flash）
+        Data,           // 数据传输
+        End,            // 升级结束（校验/配置）
+        TotalEnd,       // 总体结束
+        Count
+    };
+    static constexpr int PHASE_COUNT = static_cast<int>(Phase::Count);
+
+    using PhaseDurations = std::array<qint64, PHASE_COUNT>;    // 各阶段耗时(us)
+
+    struct Device {
+        QString name;
+        quint64 fileSize = 0;
+        quint32 packetCount = 0;
+        int packetSize = 0;
+        bool delta = false;             // 是否按差分升级传输
+        quint32 deltaPackets = 0;       // 差分升级传输的块数
+        quint64 transferBytes = 0;      // 实际传输的数据字节数，完整升级等于文件大小
+        bool compressed = false;        // 是否按压缩报文传输
+        quint64 payloadBytes = 0;       // 已发送数据包的原始数据字节数（不含重传）
+        quint64 wireBytes = 0;          // 其中实际上线的数据内容字节数，未压缩时等于 payloadBytes
+        PhaseDurations phaseUs = {};    // 只使用 擦除/数据/结束 三个阶段
+        LatencyHistogram rtt;           // 数据包往返时延（不含重传包）
+        quint64 packetsSent = 0;        // 数据包发送次数（含重传）
+        quint64 retransmits = 0;        // 数据包重传次数
+        quint64 fastRetransmits = 0;    // 其中由越序应答触发的快速重传次数
+        quint64 timeouts = 0;           // 本设备各阶段超时重发次数
+
+        // 有效吞吐（字节/秒）：文件大小 / 数据阶段耗时，差分升级时高于链路实际吞吐
+        double goodput() const;
+
+        // 压缩比：原始数据字节数 / 上线字节数，未压缩时为 1
+        double compressionRatio() const;
+
+        // 链路吞吐（字节/秒）：上线字节数 / 数据阶段耗时
+        double wireThroughput() const;
+    };
+
+    qint64 startTime = 0;           // 升级开始时刻（UTC毫秒）
+    qint64 totalUs = 0;
+    bool success = false;
+    QString message;
+    int packetSize = 0;             // 界面设置的分包大小
+    int windowSize = 1;
+    bool extended = false;
+    PhaseDurations phaseUs = {};    // 各阶段耗时（多设备累加）
+    QVector<Device> devices;
+    LatencyHistogram rtt;           // 全部设备的数据包往返时延
+    quint64 retransmits = 0;
+    quint64 timeouts = 0;
+    quint64 resumedPackets = 0;     // 断点续传时下位机已有、未重新发送的数据包数
+
+    static QString phaseName(Phase phase);
+
+    // 全部固件字节数 / 全部数据阶段耗时
+    double goodput() const;
+
+    // 升级结束时写入信息窗口和日志的文本摘要
+    QStringList summary() const;
+
+    QJsonObject toJson() const;
+};
+
+#endif // UPGRADETELEMETRY_H
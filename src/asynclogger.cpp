@@ -0,0 +1,225 @@
+#include "inc/asynclogger.h"
+#include "inc/protocol.h"
+#include <QDateTime>
+#include <QFile>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+constexpr std::size_t CHANNEL_CAPACITY = 8192;  // 每个通道最多缓存的记录数
+constexpr int FLUSH_INTERVAL_MS = 50;           // 日志线程批量写入的周期
+
+// 辅助函数：计算字符串显示宽度并填充到指定宽度（中文字符算2个宽度）
+QString padString(const QString &str, int targetWidth)
+{
+    int displayWidth = 0;
+    for (const QChar &ch : str) {
+        if (ch.unicode() > 0x7F) {  // 非ASCII字符（包括中文）
+            displayWidth += 2;
+        } else {
+            displayWidth += 1;
+        }
+    }
+    int paddingNeeded = targetWidth - displayWidth;
+    return str + QString(paddingNeeded > 0 ? paddingNeeded : 0, ' ');
+}
+}
+
+// ============= 生产者通道 =============
+
+AsyncLogger::Channel::Channel(std::size_t capacity)
+    : queue(capacity)
+    , dropped(0)
+{
+}
+
+void AsyncLogger::Channel::push(LogRecord &&record)
+{
+    record.timestamp = QDateTime::currentMSecsSinceEpoch();
+    if (!queue.tryPush(std::move(record))) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AsyncLogger::Channel::fillPreview(LogRecord &record, QByteArrayView frame)
+{
+    record.frameSize = static_cast<qint32>(frame.size());
+    record.previewSize = static_cast<quint8>(qMin<qsizetype>(frame.size(), LogRecord::PREVIEW_SIZE));
+    std::memcpy(record.preview, frame.data(), record.previewSize);
+}
+
+void AsyncLogger::Channel::logText(const QString &text)
+{
+    LogRecord record;
+    record.kind = LogRecord::Kind::Text;
+    record.text = text;
+    push(std::move(record));
+}
+
+void AsyncLogger::Channel::logTx(QByteArrayView frame, const QString &description, bool extended)
+{
+    LogRecord record;
+    record.kind = LogRecord::Kind::Tx;
+    record.extended = extended;
+    record.text = description;
+    fillPreview(record, frame);
+    push(std::move(record));
+}
+
+void AsyncLogger::Channel::logRx(QByteArrayView frame)
+{
+    LogRecord record;
+    record.kind = LogRecord::Kind::Rx;
+    fillPreview(record, frame);
+    push(std::move(record));
+}
+
+void AsyncLogger::Channel::logTxFailed()
+{
+    LogRecord record;
+    record.kind = LogRecord::Kind::TxFailed;
+    push(std::move(record));
+}
+
+// ============= 日志线程 =============
+
+AsyncLogger::AsyncLogger(const QString &filePath)
+    : m_filePath(filePath)
+    , m_stopping(false)
+{
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    stop();
+}
+
+AsyncLogger::Channel *AsyncLogger::channel()
+{
+    m_channels.push_back(std::make_unique<Channel>(CHANNEL_CAPACITY));
+    return m_channels.back().get();
+}
+
+void AsyncLogger::start()
+{
+    if (m_thread) {
+        return;
+    }
+    m_stopping.store(false, std::memory_order_relaxed);
+    m_thread.reset(QThread::create([this]() { run(); }));
+    m_thread->setObjectName(QStringLiteral("BootLoaderLog"));
+    m_thread->start(QThread::LowPriority);
+}
+
+void AsyncLogger::stop()
+{
+    if (!m_thread) {
+        return;
+    }
+    m_stopping.store(true, std::memory_order_release);
+    m_thread->wait();
+    m_thread.reset();
+}
+
+void AsyncLogger::run()
+{
+    QFile file(m_filePath);
+    QByteArray batch;
+
+    for (;;) {
+        const bool stopping = m_stopping.load(std::memory_order_acquire);
+
+        batch.clear();
+        drain(batch);
+
+        if (!batch.isEmpty()) {
+            // 文件在第一次写入时打开并一直保持打开
+            if (!file.isOpen()) {
+                file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+            }
+            if (file.isOpen()) {
+                file.write(batch);
+                file.flush();
+            }
+        }
+
+        if (stopping) {
+            break;
+        }
+        QThread::msleep(FLUSH_INTERVAL_MS);
+    }
+
+    file.close();
+}
+
+void AsyncLogger::drain(QByteArray &batch)
+{
+    m_pending.clear();
+
+    quint64 dropped = 0;
+    LogRecord record;
+    for (const auto &channel : m_channels) {
+        while (channel->queue.tryPop(record)) {
+            m_pending.append(std::move(record));
+        }
+        dropped += channel->dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    // 各通道内部有序，合并后按时间排序
+    std::stable_sort(m_pending.begin(), m_pending.end(), [](const LogRecord &a, const LogRecord &b) {
+        return a.timestamp < b.timestamp;
+    });
+
+    for (const LogRecord &pending : m_pending) {
+        batch.append(format(pending).toUtf8());
+        batch.append('\n');
+    }
+
+    if (dropped > 0) {
+        const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
+        batch.append(QString("[%1] | 日志写入跟不上，丢弃 %2 条记录\n").arg(timestamp).arg(dropped).toUtf8());
+    }
+}
+
+QString AsyncLogger::format(const LogRecord &record)
+{
+    if (record.kind == LogRecord::Kind::Text) {
+        return record.text;
+    }
+
+    const QString timestamp = QDateTime::fromMSecsSinceEpoch(record.timestamp).toString("yyyy-MM-dd hh:mm:ss");
+    if (record.kind == LogRecord::Kind::TxFailed) {
+        return QString("[%1] | TX | 发送失败").arg(timestamp);
+    }
+
+    const QByteArrayView preview(record.preview, record.previewSize);
+    QString hexData = QString::fromLatin1(QByteArray::fromRawData(preview.data(), preview.size()).toHex(' ').toUpper());
+    if (record.frameSize > LogRecord::PREVIEW_SIZE) {
+        hexData += " ...";
+    }
+
+    // 尝试从数据中解析ID（第3个字节是ID）
+    const quint8 deviceId = preview.size() >= 3 ? static_cast<quint8>(preview[2]) : 0;
+
+    QString typeDesc;
+    QString flagDesc;
+    if (record.kind == LogRecord::Kind::Tx) {
+        typeDesc = record.text.isEmpty() ? BootLoaderProtocol::describeMasterFrame(preview, record.extended)
+                                         : record.text;
+    } else if (preview.size() >= 7) {
+        typeDesc = BootLoaderProtocol::getMessageTypeDescription(
+            static_cast<BootLoaderProtocol::MessageType>(static_cast<quint8>(preview[5])));
+        flagDesc = BootLoaderProtocol::getResponseDescription(
+            static_cast<BootLoaderProtocol::ResponseFlag>(static_cast<quint8>(preview[6])));
+    }
+
+    // 格式: [时间] | TX/RX | ID=xx | TYPE=类型描述 | FLAG=标志描述 | DATA=十六进制
+    // 手动填充以支持中文对齐（TYPE=24字符宽度，FLAG=34字符宽度）
+    return QString("[%1] | %2 | ID=%3 | TYPE=%4 | FLAG=%5 | DATA=%6")
+        .arg(timestamp)
+        .arg(record.kind == LogRecord::Kind::Tx ? QStringLiteral("TX") : QStringLiteral("RX"))
+        .arg(deviceId, 2, 10, QChar('0'))
+        .arg(padString(typeDesc, 24))
+        .arg(padString(flagDesc, 34))
+        .arg(hexData);
+}
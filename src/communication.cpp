@@ -3,8 +3,8 @@
 
 CommunicationManager::CommunicationManager(QObject *parent)
     : QObject(parent)
-    , serialPort()
-    , tcpSocket()
+    , serialPort(this)
+    , tcpSocket(this)
     , protocol()
     , activeLink(LinkType::Serial)
 {
@@ -22,6 +22,21 @@ CommunicationManager::~CommunicationManager()
 {
     closeSerialPort();
     closeTcpConnection();
+    stopCapture();
+}
+
+// ========================================================================
+// 会话抓包
+// ========================================================================
+
+bool CommunicationManager::startCapture(const QString &path, QString *errorString)
+{
+    return capture.open(path, errorString);
+}
+
+void CommunicationManager::stopCapture()
+{
+    capture.close();
 }
 
 // ========================================================================
@@ -195,20 +210,29 @@ void CommunicationManager::handleTcpError(QAbstractSocket::SocketError error)
 
 void CommunicationManager::processReceivedData(const QByteArray &data)
 {
-    // 使用协议解析接收到的数据
-    QList<QByteArray> frames = protocol.parseReceivedData(data);
-
-    for (const QByteArray &frame : frames) {
-        quint8 slaveId;
-        BootLoaderProtocol::MessageType msgType;
-        BootLoaderProtocol::ResponseFlag flag;
-        QByteArray payload;
-
-        if (protocol.parseFrame(frame, slaveId, msgType, flag, payload)) {
-            // 发送信号，让UI层处理
-            emit dataReceived(frame, slaveId, msgType, flag, payload);
+    const char *input = data.constData();
+    qsizetype remaining = data.size();
+
+    // 接收缓冲区满时先取出帧再继续写入
+    do {
+        const qsizetype written = protocol.feedReceivedData(input, remaining);
+        input += written;
+        remaining -= written;
+
+        QByteArrayView frameView;
+        while (protocol.nextReceivedFrame(frameView)) {
+            BootLoaderProtocol::Frame frame;
+            const bool valid = BootLoaderProtocol::parseFrame(frameView, frame);
+            if (capture.isOpen()) {
+                capture.write(captureLink(), SessionCapture::Direction::Rx, frameView,
+                              valid ? 0 : SessionCapture::FLAG_CRC_ERROR);
+            }
+            if (valid) {
+                // 发送信号，让UI层处理（帧视图在本次循环内有效）
+                emit frameReceived(frame);
+            }
         }
-    }
+    } while (remaining > 0);
 }
 
 // ========================================================================
@@ -231,5 +255,9 @@ qint64 CommunicationManager::sendData(const QByteArray &data)
         tcpSocket.flush();
     }
 
+    if (bytesWritten > 0 && capture.isOpen()) {
+        capture.write(captureLink(), SessionCapture::Direction::Tx, data);
+    }
+
     return bytesWritten;
 }
\ No newline at end of file
@@ -0,0 +1,24 @@
+#include "inc/crc16.h"
+
+namespace Crc16 {
+
+quint16 update(quint16 state, const void *data, qsizetype len)
+{
+    const quint8 *p = static_cast<const quint8 *>(data);
+
+    // 每次处理8字节：CRC只有16位，只需与前2字节异或，其余字节直接查表
+    while (len >= 8) {
+        const quint8 b0 = static_cast<quint8>(p[0] ^ (state & 0xFF));
+        const quint8 b1 = static_cast<quint8>(p[1] ^ (state >> 8));
+        state = static_cast<quint16>(TABLES[7][b0] ^ TABLES[6][b1] ^
+                                     TABLES[5][p[2]] ^ TABLES[4][p[3]] ^
+                                     TABLES[3][p[4]] ^ TABLES[2][p[5]] ^
+                                     TABLES[1][p[6]] ^ TABLES[0][p[7]]);
+        p += 8;
+        len -= 8;
+    }
+
+    return updateTable(state, p, len);
+}
+
+} // namespace Crc16
@@ -0,0 +1,107 @@
+#include "inc/firmwareimage.h"
+
+namespace {
+constexpr qint64 WINDOW_SIZE = 64 * 1024 * 1024;   // 每次映射的窗口大小
+constexpr qint64 WINDOW_ALIGN = 64 * 1024;         // 映射起点对齐（Windows 分配粒度）
+}
+
+FirmwareImage::FirmwareImage()
+    : m_size(0)
+{
+}
+
+QSharedPointer<FirmwareImage> FirmwareImage::open(const QString &path, QString *errorString)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return QSharedPointer<FirmwareImage>();
+    }
+
+    QSharedPointer<FirmwareImage> image(new FirmwareImage());
+    image->m_path = path;
+    image->m_size = file.size();
+    return image;
+}
+
+// ============= 窗口式读取器 =============
+
+FirmwareImage::Reader::Reader(const FirmwareImage &image)
+    : m_file(image.filePath())
+    , m_size(image.size())
+    , m_map(nullptr)
+    , m_windowOffset(0)
+    , m_windowLength(0)
+    , m_mappable(true)
+{
+    m_file.open(QIODevice::ReadOnly);
+}
+
+FirmwareImage::Reader::~Reader()
+{
+    releaseWindow();
+    m_file.close();
+}
+
+QByteArrayView FirmwareImage::Reader::read(qint64 offset, qsizetype length)
+{
+    if (offset < 0 || length < 0 || offset + length > m_size || !m_file.isOpen()) {
+        return QByteArrayView();
+    }
+
+    // 不在当前窗口内则切换窗口
+    if (offset < m_windowOffset || offset + length > m_windowOffset + m_windowLength) {
+        if (!loadWindow(offset, length)) {
+            return QByteArrayView();
+        }
+    }
+
+    const qsizetype start = static_cast<qsizetype>(offset - m_windowOffset);
+    const char *base = m_map ? reinterpret_cast<const char *>(m_map) : m_buffer.constData();
+    return QByteArrayView(base + start, length);
+}
+
+bool FirmwareImage::Reader::loadWindow(qint64 offset, qsizetype length)
+{
+    releaseWindow();
+
+    const qint64 windowOffset = offset - offset % WINDOW_ALIGN;
+    const qint64 windowLength = qMin(qMax<qint64>(WINDOW_SIZE, offset - windowOffset + length),
+                                     m_size - windowOffset);
+
+    if (m_mappable) {
+        m_map = m_file.map(windowOffset, windowLength);
+        if (m_map) {
+            m_windowOffset = windowOffset;
+            m_windowLength = windowLength;
+            return true;
+        }
+        // 不支持映射的文件改为读取
+        m_mappable = false;
+    }
+
+    if (!m_file.seek(windowOffset)) {
+        return false;
+    }
+    m_buffer.resize(static_cast<qsizetype>(windowLength));
+    if (m_file.read(m_buffer.data(), windowLength) != windowLength) {
+        m_buffer.clear();
+        return false;
+    }
+
+    m_windowOffset = windowOffset;
+    m_windowLength = windowLength;
+    return true;
+}
+
+void FirmwareImage::Reader::releaseWindow()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+    m_windowOffset = 0;
+    m_windowLength = 0;
+}
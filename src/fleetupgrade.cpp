@@ -0,0 +1,238 @@
+#include "inc/fleetupgrade.h"
+#include <utility>
+
+namespace {
+constexpr int PROGRESS_INTERVAL_MS = 100;
+}
+
+FleetUpgrade::FleetUpgrade(QObject *parent)
+    : QObject(parent)
+    , concurrency(8)
+    , runningCount(0)
+    , running(false)
+    , lastProgressMs(0)
+    , ioThreads(0)
+{
+}
+
+FleetUpgrade::~FleetUpgrade()
+{
+    // I/O线程中的会话没有父对象，线程结束时销毁
+    for (const ActiveSession &entry : std::as_const(active)) {
+        if (entry.session && ioPool) {
+            entry.session->deleteLater();
+        }
+    }
+}
+
+void FleetUpgrade::addTarget(const UpgradeSession::Target &target)
+{
+    if (running) {
+        return;
+    }
+    Result result;
+    result.target = target;
+    targetResults.append(result);
+}
+
+void FleetUpgrade::setMaxConcurrent(int count)
+{
+    concurrency = qMax(1, count);
+}
+
+void FleetUpgrade::setIoThreads(int count)
+{
+    if (!running) {
+        ioThreads = qMax(0, count);
+    }
+}
+
+void FleetUpgrade::start()
+{
+    if (running) {
+        return;
+    }
+
+    running = true;
+    runningCount = 0;
+    busyPorts.clear();
+    pendingTargets.clear();
+    active = QVector<ActiveSession>(targetResults.size());
+    for (int i = 0; i < targetResults.size(); ++i) {
+        targetResults[i].finished = false;
+        pendingTargets.append(i);
+    }
+    progressClock.start();
+    lastProgressMs = 0;
+    if (ioThreads > 0 && (!ioPool || ioPool->threadCount() != ioThreads)) {
+        ioPool = std::make_unique<IoThreadPool>(ioThreads);
+    }
+    if (ioThreads == 0) {
+        ioPool.reset();
+    }
+
+    launchPending();
+    updateProgress(true);
+    if (runningCount == 0) {
+        running = false;
+        emit finished();
+    }
+}
+
+void FleetUpgrade::cancel()
+{
+    if (!running) {
+        return;
+    }
+
+    // 未开始的目标直接记为取消
+    const QList<int> pending = pendingTargets;
+    pendingTargets.clear();
+    for (int index : pending) {
+        targetResults[index].status = UpgradeSession::Status::Cancelled;
+        targetResults[index].message = tr("未开始");
+        targetResults[index].finished = true;
+        emit sessionFinished(index, targetResults[index]);
+    }
+
+    // 运行中的会话取消后由 onSessionFinished 收尾
+    for (const ActiveSession &entry : std::as_const(active)) {
+        if (entry.session) {
+            QMetaObject::invokeMethod(entry.session, &UpgradeSession::cancel);
+        }
+    }
+    if (runningCount == 0) {
+        running = false;
+        updateProgress(true);
+        emit finished();
+    }
+}
+
+/**
+ * @brief 在并发上限内按顺序启动排队的目标，跳过串口正被占用的目标
+ */
+void FleetUpgrade::launchPending()
+{
+    for (auto it = pendingTargets.begin(); it != pendingTargets.end() && runningCount < concurrency;) {
+        const QString port = serialPortOf(*it);
+        if (!port.isEmpty() && busyPorts.contains(port)) {
+            ++it;
+            continue;
+        }
+        const int index = *it;
+        it = pendingTargets.erase(it);
+        launch(index);
+    }
+}
+
+void FleetUpgrade::launch(int index)
+{
+    const QString port = serialPortOf(index);
+    if (!port.isEmpty()) {
+        busyPorts.insert(port);
+    }
+    runningCount++;
+
+    ActiveSession &entry = active[index];
+    entry.session = new UpgradeSession(targetResults[index].target, ioPool ? nullptr : this);
+    entry.clock.start();
+
+    UpgradeSession *session = entry.session;
+    connect(session, &UpgradeSession::showInfo, this, [this, index](const QString &text) {
+        emit sessionInfo(index, text);
+    });
+    connect(session, &UpgradeSession::progressUpdated, this, [this, index](const UpgradeManager::Progress &progress) {
+        ActiveSession &entry = active[index];
+        entry.bytes = progress.overallBytes;
+        entry.totalBytes = progress.overallTotalBytes;
+        entry.bytesPerSecond = progress.bytesPerSecond;
+        emit sessionProgress(index, progress);
+        updateProgress(false);
+    });
+    connect(session, &UpgradeSession::telemetryReady, this, [this, index](const UpgradeTelemetry &telemetry) {
+        targetResults[index].telemetry = telemetry;
+    });
+    connect(session, &UpgradeSession::finished, this, [this, index](UpgradeSession::Status status, const QString &message) {
+        onSessionFinished(index, status, message);
+    });
+
+    emit sessionStarted(index);
+    if (ioPool) {
+        // 之后会话的信号排队回到本线程
+        ioPool->assign(session);
+        QMetaObject::invokeMethod(session, &UpgradeSession::start, Qt::QueuedConnection);
+    } else {
+        session->start();
+    }
+}
+
+void FleetUpgrade::onSessionFinished(int index, UpgradeSession::Status status, const QString &message)
+{
+    ActiveSession &entry = active[index];
+    Result &result = targetResults[index];
+    result.status = status;
+    result.message = message;
+    result.elapsedMs = entry.clock.elapsed();
+    result.finished = true;
+
+    entry.session->deleteLater();
+    entry.session = nullptr;
+    entry.bytesPerSecond = 0.0;
+    if (status == UpgradeSession::Status::Success) {
+        entry.bytes = entry.totalBytes;
+    }
+
+    const QString port = serialPortOf(index);
+    if (!port.isEmpty()) {
+        busyPorts.remove(port);
+    }
+    runningCount--;
+
+    emit sessionFinished(index, result);
+
+    launchPending();
+    updateProgress(true);
+
+    if (runningCount == 0 && pendingTargets.isEmpty()) {
+        running = false;
+        emit finished();
+    }
+}
+
+void FleetUpgrade::updateProgress(bool force)
+{
+    const qint64 now = progressClock.elapsed();
+    if (!force && now - lastProgressMs < PROGRESS_INTERVAL_MS) {
+        return;
+    }
+    lastProgressMs = now;
+
+    Progress progress;
+    progress.total = targetResults.size();
+    progress.pending = pendingTargets.size();
+    progress.running = runningCount;
+
+    double percentSum = 0.0;
+    for (int i = 0; i < targetResults.size(); ++i) {
+        const ActiveSession &entry = active[i];
+        progress.bytes += entry.bytes;
+        progress.totalBytes += entry.totalBytes;
+        progress.bytesPerSecond += entry.bytesPerSecond;
+
+        if (targetResults[i].finished) {
+            targetResults[i].status == UpgradeSession::Status::Success ? progress.succeeded++ : progress.failed++;
+            percentSum += 100.0;
+        } else if (entry.totalBytes > 0) {
+            percentSum += 100.0 * entry.bytes / entry.totalBytes;
+        }
+    }
+    progress.percent = progress.total > 0 ? static_cast<int>(percentSum / progress.total) : 100;
+
+    emit progressUpdated(progress);
+}
+
+QString FleetUpgrade::serialPortOf(int index) const
+{
+    const UpgradeSession::Target &target = targetResults[index].target;
+    return target.link == CommunicationManager::LinkType::Serial ? target.portName : QString();
+}
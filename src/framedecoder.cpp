@@ -0,0 +1,197 @@
+#include "inc/framedecoder.h"
+#include <QDebug>
+#include <cstring>
+
+namespace {
+constexpr quint8 HEADER_AA = 0xAA;
+constexpr quint8 HEADER_55 = 0x55;
+constexpr quint64 NOT_FOUND = ~quint64(0);
+
+static_assert((FrameDecoder::CAPACITY & (FrameDecoder::CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+static_assert(FrameDecoder::CAPACITY >= 2 * FrameDecoder::MAX_FRAME_SIZE, "CAPACITY must hold two frames");
+}
+
+FrameDecoder::FrameDecoder()
+    : m_head(0)
+    , m_tail(0)
+    , m_scan(0)
+    , m_pending(0)
+    , m_dropped(0)
+{
+}
+
+qsizetype FrameDecoder::write(const char *data, qsizetype len)
+{
+    consumePending();
+
+    if (!m_buffer) {
+        m_buffer.reset(new char[CAPACITY]);
+    }
+
+    const qsizetype count = qMin(len, CAPACITY - size());
+    if (count <= 0) {
+        return 0;
+    }
+
+    // 最多分两段写入（绕回缓冲区开头）
+    const qsizetype offset = static_cast<qsizetype>(m_tail & MASK);
+    const qsizetype first = qMin(count, CAPACITY - offset);
+    std::memcpy(m_buffer.get() + offset, data, static_cast<size_t>(first));
+    if (count > first) {
+        std::memcpy(m_buffer.get(), data + first, static_cast<size_t>(count - first));
+    }
+
+    m_tail += static_cast<quint64>(count);
+    return count;
+}
+
+bool FrameDecoder::nextFrame(QByteArrayView &frame)
+{
+    consumePending();
+
+    while (findHeader()) {
+        if (size() < 5) {
+            return false;
+        }
+
+        // 获取报文长度（长度字段表示整个报文的总字节数）
+        const qsizetype length = (byteAt(m_head + 3) << 8) | byteAt(m_head + 4);
+        if (length < MIN_FRAME_SIZE) {
+            qWarning().noquote() << QStringLiteral("BootLoaderProtocol: invalid frame length %1, dropping header")
+                                        .arg(length);
+            drop(m_head + 2);
+            continue;
+        }
+
+        // 检查完整帧是否接收完毕
+        if (size() < length) {
+            return false;
+        }
+
+        frame = view(m_head, length);
+        m_pending = length;
+        return true;
+    }
+
+    return false;
+}
+
+void FrameDecoder::clear()
+{
+    m_head = m_tail;
+    m_scan = m_tail;
+    m_pending = 0;
+}
+
+/**
+ * @brief 消费上一次交出的帧
+ */
+void FrameDecoder::consumePending()
+{
+    if (m_pending > 0) {
+        m_head += static_cast<quint64>(m_pending);
+        m_pending = 0;
+    }
+}
+
+/**
+ * @brief 丢弃 newHead 之前的无效数据
+ */
+void FrameDecoder::drop(quint64 newHead)
+{
+    m_dropped += newHead - m_head;
+    m_head = newHead;
+    if (m_scan < m_head) {
+        m_scan = m_head;
+    }
+}
+
+/**
+ * @brief 从 from 开始查找 0x55，返回绝对位置
+ */
+quint64 FrameDecoder::find55(quint64 from) const
+{
+    while (from < m_tail) {
+        // 每次查找一个连续段：到写位置或缓冲区末尾为止
+        const qsizetype offset = static_cast<qsizetype>(from & MASK);
+        const qsizetype length = static_cast<qsizetype>(qMin<quint64>(m_tail - from, static_cast<quint64>(CAPACITY - offset)));
+        const void *hit = std::memchr(m_buffer.get() + offset, HEADER_55, static_cast<size_t>(length));
+        if (hit) {
+            return from + static_cast<quint64>(static_cast<const char *>(hit) - (m_buffer.get() + offset));
+        }
+        from += static_cast<quint64>(length);
+    }
+    return NOT_FOUND;
+}
+
+/**
+ * @brief 将读位置对齐到帧头
+ * @return 读位置处是否为帧头
+ *
+ * 两种帧头都含有 0x55，因此只需查找 0x55 再检查其前后字节。
+ */
+bool FrameDecoder::findHeader()
+{
+    while (size() >= 2) {
+        const quint8 first = byteAt(m_head);
+        const quint8 second = byteAt(m_head + 1);
+        if ((first == HEADER_AA && second == HEADER_55) ||
+            (first == HEADER_55 && second == HEADER_AA)) {
+            return true;
+        }
+
+        const quint64 pos = find55(qMax(m_scan, m_head));
+
+        if (pos == NOT_FOUND) {
+            // 没有 0x55：只有末尾的 0xAA 可能是帧头的一部分
+            drop(byteAt(m_tail - 1) == HEADER_AA ? m_tail - 1 : m_tail);
+            m_scan = m_tail;
+            return false;
+        }
+
+        // 0xAA 0x55：上位机帧头
+        if (pos > m_head && byteAt(pos - 1) == HEADER_AA) {
+            drop(pos - 1);
+            m_scan = pos + 1;
+            return true;
+        }
+
+        // 0x55 后的字节尚未到达，等待更多数据
+        if (pos + 1 >= m_tail) {
+            drop(pos);
+            m_scan = pos;
+            return false;
+        }
+
+        // 0x55 0xAA：下位机帧头
+        if (byteAt(pos + 1) == HEADER_AA) {
+            drop(pos);
+            m_scan = pos + 1;
+            return true;
+        }
+
+        drop(pos + 1);
+    }
+
+    return false;
+}
+
+/**
+ * @brief 返回 [pos, pos+len) 的连续视图
+ */
+QByteArrayView FrameDecoder::view(quint64 pos, qsizetype len)
+{
+    const qsizetype offset = static_cast<qsizetype>(pos & MASK);
+    if (offset + len <= CAPACITY) {
+        return QByteArrayView(m_buffer.get() + offset, len);
+    }
+
+    // 帧跨越缓冲区末尾，拼接到暂存区（预分配一次，之后不再分配）
+    if (m_scratch.size() < MAX_FRAME_SIZE) {
+        m_scratch.resize(MAX_FRAME_SIZE);
+    }
+    const qsizetype first = CAPACITY - offset;
+    std::memcpy(m_scratch.data(), m_buffer.get() + offset, static_cast<size_t>(first));
+    std::memcpy(m_scratch.data() + first, m_buffer.get(), static_cast<size_t>(len - first));
+    return QByteArrayView(m_scratch.constData(), len);
+}
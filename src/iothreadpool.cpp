@@ -0,0 +1,58 @@
+#include "inc/iothreadpool.h"
+
+namespace {
+constexpr int MAX_DEFAULT_THREADS = 8;
+}
+
+IoThreadPool::IoThreadPool(int threadCount)
+{
+    if (threadCount <= 0) {
+        threadCount = qBound(1, QThread::idealThreadCount(), MAX_DEFAULT_THREADS);
+    }
+
+    threads.reserve(threadCount);
+    for (int i = 0; i < threadCount; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->thread.setObjectName(QStringLiteral("LinkIO-%1").arg(i));
+        worker->thread.start(QThread::HighPriority);
+        threads.push_back(std::move(worker));
+    }
+}
+
+IoThreadPool::~IoThreadPool()
+{
+    // 线程结束时销毁其中尚未处理的 deleteLater 对象
+    for (const auto &worker : threads) {
+        worker->thread.quit();
+    }
+    for (const auto &worker : threads) {
+        worker->thread.wait();
+    }
+}
+
+void IoThreadPool::assign(QObject *object)
+{
+    Worker *target = threads.front().get();
+    for (const auto &worker : threads) {
+        if (worker->load < target->load) {
+            target = worker.get();
+        }
+    }
+
+    // 负载计数只在分配线程中修改，销毁通知排队回到该线程
+    target->load++;
+    QObject::connect(object, &QObject::destroyed, &target->thread, [target]() {
+        target->load--;
+    });
+    object->moveToThread(&target->thread);
+}
+
+QVector<int> IoThreadPool::loads() const
+{
+    QVector<int> result;
+    result.reserve(static_cast<int>(threads.size()));
+    for (const auto &worker : threads) {
+        result.append(worker->load);
+    }
+    return result;
+}
@@ -0,0 +1,233 @@
+#include "inc/linkworker.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QMutexLocker>
+
+namespace {
+constexpr std::size_t EVENT_QUEUE_CAPACITY = 4096;
+
+// 信息和进度在队列满时可以丢弃，状态类事件必须送达
+bool isDroppable(LinkEvent::Type type)
+{
+    return type == LinkEvent::Type::Info ||
+           type == LinkEvent::Type::Progress;
+}
+}
+
+LinkWorker::LinkWorker(QObject *eventReceiver)
+    : QObject(nullptr)
+    , commManager(new CommunicationManager(this))
+    , upgradeManager(new UpgradeManager(this))
+    , receiver(eventReceiver)
+    , events(EVENT_QUEUE_CAPACITY)
+    , drainScheduled(false)
+    , overflowPending(false)
+    , droppedEvents(0)
+    , logChannel(nullptr)
+    , logEnabled(false)
+{
+    // 应答 -> 状态机 -> 下一包 均在本线程内直接调用
+    connect(commManager, &CommunicationManager::frameReceived, this, &LinkWorker::handleFrameReceived, Qt::DirectConnection);
+    connect(upgradeManager, &UpgradeManager::sendData, this, &LinkWorker::sendData);
+
+    // 其余通知转为事件交给界面线程
+    connect(commManager, &CommunicationManager::serialError, this, [this](const QString &message) {
+        LinkEvent event;
+        event.type = LinkEvent::Type::SerialError;
+        event.text = message;
+        postEvent(std::move(event));
+    });
+    connect(commManager, &CommunicationManager::tcpError, this, [this](const QString &message) {
+        LinkEvent event;
+        event.type = LinkEvent::Type::TcpError;
+        event.text = message;
+        postEvent(std::move(event));
+    });
+    connect(commManager, &CommunicationManager::connectionStateChanged, this, [this](bool connected) {
+        LinkEvent event;
+        event.type = LinkEvent::Type::ConnectionState;
+        event.flag = connected;
+        postEvent(std::move(event));
+    });
+    connect(upgradeManager, &UpgradeManager::showInfo, this, &LinkWorker::postInfo);
+    connect(upgradeManager, &UpgradeManager::progressUpdated, this, [this](const UpgradeManager::Progress &progress) {
+        LinkEvent event;
+        event.type = LinkEvent::Type::Progress;
+        event.progress = progress;
+        postEvent(std::move(event));
+    });
+    connect(upgradeManager, &UpgradeManager::telemetryReady, this, [this](const UpgradeTelemetry &telemetry) {
+        // 统计摘要显示在信息窗口，记录日志时同时写入日志文件
+        const bool logging = logChannel && logEnabled.load(std::memory_order_relaxed);
+        for (const QString &line : telemetry.summary()) {
+            postInfo(line);
+            if (logging) {
+                logChannel->logText(line);
+            }
+        }
+    });
+    connect(upgradeManager, &UpgradeManager::upgradeFinished, this, [this](bool success, const QString &message) {
+        commManager->stopCapture();
+
+        LinkEvent event;
+        event.type = LinkEvent::Type::UpgradeFinished;
+        event.flag = success;
+        event.text = message;
+        postEvent(std::move(event));
+    });
+}
+
+// ========================================================================
+// 界面线程接口
+// ========================================================================
+
+bool LinkWorker::takeEvent(LinkEvent &event)
+{
+    if (events.tryPop(event)) {
+        return true;
+    }
+
+    // 队列中的事件都早于溢出列表中的，队列取空后再按顺序取溢出的状态事件
+    if (!overflowPending.load(std::memory_order_acquire)) {
+        return false;
+    }
+    QMutexLocker locker(&overflowMutex);
+    if (overflowEvents.isEmpty()) {
+        return false;
+    }
+    event = overflowEvents.takeFirst();
+    if (overflowEvents.isEmpty()) {
+        overflowPending.store(false, std::memory_order_release);
+    }
+    return true;
+}
+
+void LinkWorker::beginDrain()
+{
+    drainScheduled.exchange(false, std::memory_order_acq_rel);
+}
+
+quint64 LinkWorker::takeDroppedCount()
+{
+    return droppedEvents.exchange(0, std::memory_order_relaxed);
+}
+
+// ========================================================================
+// I/O线程
+// ========================================================================
+
+void LinkWorker::preloadFirmware(UpgradeManager::DeviceType device, const QString &path, quint8 slaveId, int packetSize)
+{
+    useSlaveStorage(slaveId);
+    upgradeManager->preloadFirmware(device, path, slaveId, packetSize);
+}
+
+/**
+ * @brief 每个从机一个断点记录和一组基线固件
+ *
+ * 断点记录用于链路断开或程序退出后续传；基线是上次成功写入的固件，用于差分升级。
+ */
+void LinkWorker::useSlaveStorage(quint8 slaveId)
+{
+    const QString appDir = QCoreApplication::applicationDirPath();
+    upgradeManager->setJournalPath(QStringLiteral("%1/journal/slave_%2.json").arg(appDir).arg(slaveId));
+    upgradeManager->setBaselineDir(QStringLiteral("%1/baselines/slave_%2").arg(appDir).arg(slaveId));
+}
+
+void LinkWorker::startUpgrade(quint8 slaveId, int packetSize, bool upgradeFPGA, bool upgradeDSP1, bool upgradeDSP2, bool upgradeARM, const QString &fpgaPath, const QString &dsp1Path, const QString &dsp2Path, const QString &armPath)
+{
+    // 记录日志时同时抓取本次升级的全部收发报文，供离线分析
+    if (logEnabled.load(std::memory_order_relaxed)) {
+        const QString path = QStringLiteral("%1/captures/session_%2.blcap")
+                                 .arg(QCoreApplication::applicationDirPath(),
+                                      QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss"));
+        QString errorString;
+        if (commManager->startCapture(path, &errorString)) {
+            postInfo(tr("会话抓包: %1").arg(path));
+        } else {
+            postInfo(tr("无法创建抓包文件：%1").arg(errorString));
+        }
+    }
+
+    useSlaveStorage(slaveId);
+
+    LinkEvent event;
+    event.type = LinkEvent::Type::UpgradeStarted;
+    event.flag = upgradeManager->startUpgrade(slaveId, packetSize,
+                                              upgradeFPGA, upgradeDSP1, upgradeDSP2, upgradeARM,
+                                              fpgaPath, dsp1Path, dsp2Path, armPath);
+    if (!event.flag) {
+        commManager->stopCapture();
+    }
+    postEvent(std::move(event));
+}
+
+void LinkWorker::postEvent(LinkEvent &&event)
+{
+    // 溢出列表非空时新事件不再进入队列，保持先后顺序；界面阻塞（如模态对话框）时
+    // 信息和进度丢弃，状态类事件放入溢出列表，I/O线程从不等待界面
+    if (overflowPending.load(std::memory_order_acquire) || !events.tryPush(std::move(event))) {
+        if (isDroppable(event.type)) {
+            droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        QMutexLocker locker(&overflowMutex);
+        overflowEvents.append(std::move(event));
+        overflowPending.store(true, std::memory_order_release);
+    }
+
+    // 界面尚未安排处理时才投递通知，一次处理会取走队列中的全部事件
+    if (!drainScheduled.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(receiver, "drainLinkEvents", Qt::QueuedConnection);
+    }
+}
+
+void LinkWorker::postInfo(const QString &text)
+{
+    LinkEvent event;
+    event.type = LinkEvent::Type::Info;
+    event.text = text;
+    postEvent(std::move(event));
+}
+
+void LinkWorker::handleFrameReceived(const BootLoaderProtocol::Frame &frame)
+{
+    // 如果勾选了日志记录，只把报文交给日志线程，格式化和写文件都不在本线程进行
+    if (logChannel && logEnabled.load(std::memory_order_relaxed)) {
+        logChannel->logRx(frame.raw);
+    }
+
+    // 如果正在升级流程中，处理响应（包括调试报文，用于重置超时计时器）
+    if (upgradeManager->currentState() != UpgradeManager::UpgradeState::IDLE) {
+        upgradeManager->handleResponse(frame.type, frame.flag, frame.payload);
+    }
+}
+
+void LinkWorker::sendData(const QByteArray &data, const QString &description)
+{
+    if (data.isEmpty()) {
+        return;
+    }
+
+    const bool connected = commManager->getActiveLink() == CommunicationManager::LinkType::Serial
+                               ? commManager->isSerialPortOpen()
+                               : commManager->isTcpConnected();
+    if (!connected) {
+        return;
+    }
+
+    // 使用通信管理器发送数据
+    const qint64 bytesWritten = commManager->sendData(data);
+    const bool logging = logChannel && logEnabled.load(std::memory_order_relaxed);
+
+    if (bytesWritten > 0) {
+        if (logging) {
+            logChannel->logTx(data, description, upgradeManager->isExtendedAddressing());
+        }
+    } else {
+        postInfo(tr("发送失败"));
+        if (logging) {
+            logChannel->logTxFailed();
+        }
+    }
+}
@@ -0,0 +1,214 @@
+#include "inc/lz4.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace Lz4 {
+
+namespace {
+constexpr int HASH_BITS = 12;
+constexpr int LAST_LITERALS = 5;     // 块末尾至少5字节是字面量
+constexpr int MF_LIMIT = 12;         // 最后一个匹配必须在块末尾12字节之前开始
+
+quint32 read32(const quint8 *p)
+{
+    quint32 value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+quint32 hash(quint32 sequence)
+{
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// 长度超过 token 中4位所能表示的部分所需的字节数
+qsizetype lengthBytes(qsizetype length)
+{
+    return length >= 15 ? (length - 15) / 255 + 1 : 0;
+}
+
+// 长度超过 token 中4位所能表示的部分：每字节255，最后一个字节小于255
+quint8 *writeLength(quint8 *op, qsizetype length)
+{
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = static_cast<quint8>(length);
+    return op;
+}
+
+/**
+ * @brief 写入一个序列：token + 字面量 + 偏移 + 匹配长度
+ * @param matchLength 为0时只写字面量（块的最后一个序列）
+ * @return 新的写入位置，容量不足时返回 nullptr
+ *
+ * 容量按序列的实际长度检查，同一输入以恰好等于上次结果的容量再压缩一次必定成功。
+ */
+quint8 *writeSequence(quint8 *op, const quint8 *opEnd, const quint8 *literals, qsizetype literalLength,
+                      qsizetype offset, qsizetype matchLength)
+{
+    qsizetype needed = 1 + lengthBytes(literalLength) + literalLength;
+    if (matchLength > 0) {
+        needed += 2 + lengthBytes(matchLength - MIN_MATCH);
+    }
+    if (opEnd - op < needed) {
+        return nullptr;
+    }
+
+    quint8 *token = op++;
+    *token = static_cast<quint8>(qMin<qsizetype>(literalLength, 15) << 4);
+    if (literalLength >= 15) {
+        op = writeLength(op, literalLength - 15);
+    }
+    // 空输入时 literals 可能为空指针，不能传给 memcpy
+    if (literalLength > 0) {
+        std::memcpy(op, literals, static_cast<size_t>(literalLength));
+        op += literalLength;
+    }
+
+    if (matchLength > 0) {
+        const qsizetype matchCode = matchLength - MIN_MATCH;
+        *token |= static_cast<quint8>(qMin<qsizetype>(matchCode, 15));
+        *op++ = static_cast<quint8>(offset & 0xFF);
+        *op++ = static_cast<quint8>(offset >> 8);
+        if (matchCode >= 15) {
+            op = writeLength(op, matchCode - 15);
+        }
+    }
+    return op;
+}
+}
+
+qsizetype compress(const char *src, qsizetype size, char *dst, qsizetype capacity)
+{
+    const quint8 *const base = reinterpret_cast<const quint8 *>(src);
+    const quint8 *const end = base + size;
+    quint8 *op = reinterpret_cast<quint8 *>(dst);
+    const quint8 *const opEnd = op + capacity;
+
+    const quint8 *ip = base;
+    const quint8 *anchor = base;     // 尚未输出的字面量起点
+
+    if (size > MF_LIMIT) {
+        const quint8 *const searchEnd = end - MF_LIMIT;
+        const quint8 *const matchLimit = end - LAST_LITERALS;
+
+        qint32 table[1 << HASH_BITS];
+        std::fill(std::begin(table), std::end(table), -1);
+
+        while (ip < searchEnd) {
+            const quint32 sequence = read32(ip);
+            const quint32 h = hash(sequence);
+            const qint32 candidate = table[h];
+            table[h] = static_cast<qint32>(ip - base);
+
+            if (candidate < 0 || (ip - base) - candidate > MAX_OFFSET || read32(base + candidate) != sequence) {
+                ++ip;
+                continue;
+            }
+
+            // 向后延伸匹配，不进入末尾的字面量区
+            const quint8 *match = base + candidate;
+            const quint8 *matchEnd = ip + MIN_MATCH;
+            const quint8 *ref = match + MIN_MATCH;
+            while (matchEnd < matchLimit && *matchEnd == *ref) {
+                ++matchEnd;
+                ++ref;
+            }
+
+            // 向前延伸，吸收相同的字面量
+            while (ip > anchor && match > base && ip[-1] == match[-1]) {
+                --ip;
+                --match;
+            }
+
+            op = writeSequence(op, opEnd, anchor, ip - anchor, ip - match, matchEnd - ip);
+            if (!op) {
+                return 0;
+            }
+            ip = matchEnd;
+            anchor = ip;
+        }
+    }
+
+    // 剩余部分全部作为字面量
+    op = writeSequence(op, opEnd, anchor, end - anchor, 0, 0);
+    if (!op) {
+        return 0;
+    }
+    return op - reinterpret_cast<quint8 *>(dst);
+}
+
+qsizetype decompress(const char *src, qsizetype size, char *dst, qsizetype capacity)
+{
+    const quint8 *ip = reinterpret_cast<const quint8 *>(src);
+    const quint8 *const end = ip + size;
+    quint8 *const out = reinterpret_cast<quint8 *>(dst);
+    quint8 *op = out;
+    const quint8 *const opEnd = out + capacity;
+
+    auto readLength = [&ip, end](qsizetype &length) {
+        quint8 byte;
+        do {
+            if (ip >= end) {
+                return false;
+            }
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (ip < end) {
+        const quint8 token = *ip++;
+
+        qsizetype literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(literalLength)) {
+            return -1;
+        }
+        if (end - ip < literalLength || opEnd - op < literalLength) {
+            return -1;
+        }
+        if (literalLength > 0) {
+            std::memcpy(op, ip, static_cast<size_t>(literalLength));
+            op += literalLength;
+            ip += literalLength;
+        }
+
+        // 最后一个序列只有字面量
+        if (ip == end) {
+            break;
+        }
+
+        if (end - ip < 2) {
+            return -1;
+        }
+        const qsizetype offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > op - out) {
+            return -1;
+        }
+
+        qsizetype matchLength = token & 0x0F;
+        if (matchLength == 15 && !readLength(matchLength)) {
+            return -1;
+        }
+        matchLength += MIN_MATCH;
+        if (opEnd - op < matchLength) {
+            return -1;
+        }
+
+        // 偏移小于长度时源与目的重叠（重复前面的字节），逐字节拷贝
+        const quint8 *match = op - offset;
+        for (qsizetype i = 0; i < matchLength; ++i) {
+            op[i] = match[i];
+        }
+        op += matchLength;
+    }
+
+    return op - out;
+}
+
+} // namespace Lz4
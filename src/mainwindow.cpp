@@ -1,16 +1,40 @@
 #include "inc/mainwindow.h"
 #include "ui_mainwindow.h"
+#include <QScrollBar>
 
+namespace {
+constexpr int INFO_FLUSH_INTERVAL_MS = 33;      // 信息窗口刷新间隔（约30Hz）
+constexpr int INFO_MAX_LINES = 5000;            // 信息窗口保留的最大行数，更早的行自动移除
+
+// 剩余时间显示为 分:秒，无法估计时显示 --:--
+QString formatEta(qint64 ms)
+{
+    if (ms < 0) {
+        return QStringLiteral("--:--");
+    }
+    const qint64 seconds = (ms + 999) / 1000;
+    return QStringLiteral("%1:%2").arg(seconds / 60, 2, 10, QLatin1Char('0'))
+                                  .arg(seconds % 60, 2, 10, QLatin1Char('0'));
+}
+}
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
-    , commManager(new CommunicationManager(this))
-    , upgradeManager(new UpgradeManager(this))
+    , linkWorker(new LinkWorker(this))
+    , logger(nullptr)
+    , uiLogChannel(nullptr)
+    , omittedInfo(0)
     , isConnected(false)
 {
     ui->setupUi(this);
 
+    // 信息窗口只保留最近若干行，追加的文本先缓存，由定时器合并后一次写入
+    ui->info_display->setMaximumBlockCount(INFO_MAX_LINES);
+    infoFlushTimer.setSingleShot(true);
+    infoFlushTimer.setInterval(INFO_FLUSH_INTERVAL_MS);
+    connect(&infoFlushTimer, &QTimer::timeout, this, &MainWindow::flushInfoDisplay);
+
     // 固定窗口大小，不允许调整
     setFixedSize(this->size());
 
@@ -18,23 +42,28 @@ MainWindow::MainWindow(QWidget *parent)
     QString appDir = QCoreApplication::applicationDirPath();
     logFilePath = appDir + "/bootloader.log";
 
+    // 日志由后台线程批量写入，界面线程和I/O线程各用一个通道
+    logger = new AsyncLogger(logFilePath);
+    uiLogChannel = logger->channel();
+    linkWorker->setLogChannel(logger->channel());
+    logger->start();
+
     // 枚举可用串口
     populateSerialPorts();
     ui->link->setCurrentIndex(0);
     ui->progressBar_DQ->setValue(0);
     ui->progressBar_ZT->setValue(0);
 
-    // 连接通信管理器的信号
-    connect(commManager, &CommunicationManager::dataReceived, this, &MainWindow::handleDataReceived);
-    connect(commManager, &CommunicationManager::serialError, this, &MainWindow::handleSerialError);
-    connect(commManager, &CommunicationManager::tcpError, this, &MainWindow::handleTcpError);
-    connect(commManager, &CommunicationManager::connectionStateChanged, this, &MainWindow::handleConnectionStateChanged);
+    // 通信和升级状态机运行在独立的I/O线程，界面负载不影响传输
+    linkWorker->moveToThread(&ioThread);
+    connect(&ioThread, &QThread::finished, linkWorker, &QObject::deleteLater);
+    ioThread.setObjectName(QStringLiteral("BootLoaderIO"));
+    ioThread.start(QThread::HighPriority);
 
-    // 连接升级管理器的信号
-    connect(upgradeManager, &UpgradeManager::sendData, this, &MainWindow::sendData);
-    connect(upgradeManager, &UpgradeManager::showInfo, this, &MainWindow::appendInfoDisplay);
-    connect(upgradeManager, &UpgradeManager::progressUpdated, this, &MainWindow::onUpgradeProgressUpdated);
-    connect(upgradeManager, &UpgradeManager::upgradeFinished, this, &MainWindow::onUpgradeFinished);
+    linkWorker->setLogEnabled(ui->checkBox_log->isChecked());
+    connect(ui->checkBox_log, &QCheckBox::toggled, this, [this](bool checked) {
+        linkWorker->setLogEnabled(checked);
+    });
 
     updateUiForLinkSelection(ui->link->currentIndex());
     statusBar()->showMessage(tr("未连接"));
@@ -47,58 +76,49 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
-    closeConnection();
+    // I/O线程退出时删除 linkWorker，连接随通信管理器析构关闭
+    ioThread.quit();
+    ioThread.wait();
+    delete logger;  // 写完剩余日志后停止日志线程
     delete ui;
 }
 
 /* ===============================  通信函数 ======================================= */
-// 辅助函数：计算字符串显示宽度并填充到指定宽度（中文字符算2个宽度）
-static QString padString(const QString &str, int targetWidth)
-{
-    int displayWidth = 0;
-    for (const QChar &ch : str) {
-        if (ch.unicode() > 0x7F) {  // 非ASCII字符（包括中文）
-            displayWidth += 2;
-        } else {
-            displayWidth += 1;
-        }
-    }
-    int paddingNeeded = targetWidth - displayWidth;
-    return str + QString(paddingNeeded > 0 ? paddingNeeded : 0, ' ');
-}
-
-void MainWindow::handleDataReceived(const QByteArray &frame, quint8 slaveId, BootLoaderProtocol::MessageType msgType, BootLoaderProtocol::ResponseFlag flag, const QByteArray &payload)
+// 取出I/O线程投递的事件并更新界面
+void MainWindow::drainLinkEvents()
 {
-    const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
-    const QString typeDesc = BootLoaderProtocol::getMessageTypeDescription(msgType);
-    const QString flagDesc = BootLoaderProtocol::getResponseDescription(flag);
-
-    // 如果勾选了日志记录，写入详细信息到文件
-    if (ui->checkBox_log->isChecked()) {
-        // 限制显示前20个字节
-        QByteArray displayData = frame.size() > 20 ? frame.left(20) : frame;
-        QString hexData = QString::fromLatin1(displayData.toHex(' ').toUpper());
-        if (frame.size() > 20) {
-            hexData += " ...";
+    linkWorker->beginDrain();
+
+    LinkEvent event;
+    while (linkWorker->takeEvent(event)) {
+        switch (event.type) {
+            case LinkEvent::Type::Info:
+                appendInfoDisplay(event.text);
+                break;
+            case LinkEvent::Type::Progress:
+                onUpgradeProgressUpdated(event.progress);
+                break;
+            case LinkEvent::Type::UpgradeStarted:
+                onUpgradeStarted(event.flag);
+                break;
+            case LinkEvent::Type::UpgradeFinished:
+                onUpgradeFinished(event.flag, event.text);
+                break;
+            case LinkEvent::Type::ConnectionState:
+                handleConnectionStateChanged(event.flag);
+                break;
+            case LinkEvent::Type::SerialError:
+                handleSerialError(event.text);
+                break;
+            case LinkEvent::Type::TcpError:
+                handleTcpError(event.text);
+                break;
         }
-
-        // 格式: [时间] | RX | ID=xx | TYPE=类型描述 | FLAG=标志描述 | DATA=十六进制
-        // 手动填充以支持中文对齐（TYPE=24字符宽度，FLAG=34字符宽度）
-        QString typePadded = padString(typeDesc, 24);
-        QString flagPadded = padString(flagDesc, 34);
-
-        QString logLine = QString("[%1] | RX | ID=%2 | TYPE=%3 | FLAG=%4 | DATA=%5")
-            .arg(timestamp)
-            .arg(slaveId, 2, 10, QChar('0'))
-            .arg(typePadded)
-            .arg(flagPadded)
-            .arg(hexData);
-        writeToLogFile(logLine);
     }
 
-    // 如果正在升级流程中，处理响应（包括调试报文，用于重置超时计时器）
-    if (upgradeManager->currentState() != UpgradeManager::UpgradeState::IDLE) {
-        upgradeManager->handleResponse(msgType, flag, payload);
+    const quint64 dropped = linkWorker->takeDroppedCount();
+    if (dropped > 0) {
+        appendInfoDisplay(tr("(界面繁忙，省略 %1 条信息)").arg(dropped));
     }
 }
 
@@ -132,7 +152,7 @@ void MainWindow::handleConnectionStateChanged(bool connected)
 
     if (connected) {
         QString statusMessage;
-        if (commManager->getActiveLink() == CommunicationManager::LinkType::Serial) {
+        if (ui->link->currentIndex() == 0) {
             QString portLabel = ui->portName->currentText();
             if (portLabel.isEmpty()) {
                 portLabel = ui->portName->currentData().toString();
@@ -231,17 +251,17 @@ bool MainWindow::openSerialPort()
         parity = QSerialPort::MarkParity;
     }
 
-    // 使用通信管理器打开串口
-    if (commManager->openSerialPort(portName, baudRate, dataBits, stopBits, parity)) {
-        const QString message = tr("正在连接串口: %1").arg(portName);
-        appendInfoDisplay(QStringLiteral("[%1] %2")
-                              .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"), message));
-        statusBar()->showMessage(message);
-        return true;
-    }
+    // 在I/O线程中打开串口，结果通过连接状态或串口错误事件返回
+    const QString message = tr("正在连接串口: %1").arg(portName);
+    appendInfoDisplay(QStringLiteral("[%1] %2")
+                          .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"), message));
+    statusBar()->showMessage(message);
 
-    statusBar()->showMessage(tr("串口连接失败"));
-    return false;
+    LinkWorker *worker = linkWorker;
+    QMetaObject::invokeMethod(worker, [worker, portName, baudRate, dataBits, stopBits, parity]() {
+        worker->communication()->openSerialPort(portName, baudRate, dataBits, stopBits, parity);
+    }, Qt::QueuedConnection);
+    return true;
 }
 
 // 打开网口连接
@@ -263,78 +283,34 @@ bool MainWindow::openTcpSocket()
         return false;
     }
 
-    // 使用通信管理器打开网口
-    if (commManager->openTcpConnection(host, port)) {
-        const QString message = tr("正在连接: %1:%2").arg(address.toString()).arg(port);
-        appendInfoDisplay(QStringLiteral("[%1] %2")
-                              .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"), message));
-        statusBar()->showMessage(message);
-        return true;
-    }
+    // 在I/O线程中打开网口，连接结果通过事件异步通知
+    const QString message = tr("正在连接: %1:%2").arg(address.toString()).arg(port);
+    appendInfoDisplay(QStringLiteral("[%1] %2")
+                          .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"), message));
+    statusBar()->showMessage(message);
 
-    statusBar()->showMessage(tr("网口连接失败"));
-    return false;
+    LinkWorker *worker = linkWorker;
+    QMetaObject::invokeMethod(worker, [worker, host, port]() {
+        worker->communication()->openTcpConnection(host, port);
+    }, Qt::QueuedConnection);
+    return true;
 }
 
 // 关闭当前连接
 void MainWindow::closeConnection()
 {
-    commManager->closeSerialPort();
-    commManager->closeTcpConnection();
-}
-
-// 发送数据（串口或网口）
-void MainWindow::sendData(const QByteArray &data, const QString &description)
-{
-    if (!isConnected || data.isEmpty()) {
-        return;
-    }
-
-    const QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
-
-    // 使用通信管理器发送数据
-    qint64 bytesWritten = commManager->sendData(data);
-
-    if (bytesWritten > 0) {
-        // 如果勾选了日志记录,写入文件（但不显示到界面）
-        if (ui->checkBox_log->isChecked()) {
-            QByteArray displayData = data.size() > 20 ? data.left(20) : data;   // 限制显示前20个字节
-            QString hexData = QString::fromLatin1(displayData.toHex(' ').toUpper());
-            if (data.size() > 20) {
-                hexData += " ...";
-            }
-            QString typeStr = description.isEmpty() ? tr("数据") : description;
-            // 尝试从数据中解析ID（假设第3个字节是ID）
-            quint8 deviceId = 0;
-            if (data.size() >= 3) {
-                deviceId = static_cast<quint8>(data[2]);
-            }
-
-            // 格式: [时间] | TX | ID=xx | TYPE=描述 | FLAG=(空) | DATA=十六进制
-            // 手动填充以支持中文对齐（TYPE=24字符宽度，FLAG=34字符宽度）
-            QString typePadded = padString(typeStr, 24);
-            QString flagPadded = padString("", 34);
-
-            QString logLine = QString("[%1] | TX | ID=%2 | TYPE=%3 | FLAG=%4 | DATA=%5")
-                .arg(timestamp)
-                .arg(deviceId, 2, 10, QChar('0'))
-                .arg(typePadded)
-                .arg(flagPadded)
-                .arg(hexData);
-            writeToLogFile(logLine);
-        }
-    } else {
-        appendInfoDisplay(tr("发送失败"));
-        if (ui->checkBox_log->isChecked()) {
-            writeToLogFile(QString("[%1] | TX | 发送失败").arg(timestamp));
-        }
-    }
+    LinkWorker *worker = linkWorker;
+    QMetaObject::invokeMethod(worker, [worker]() {
+        worker->communication()->closeSerialPort();
+        worker->communication()->closeTcpConnection();
+    }, Qt::QueuedConnection);
 }
 
 
 /* ===============================  功能函数 ======================================= */
 // 固件文件选择函数
-void MainWindow::selectFirmwareFile(QLineEdit *lineEdit, QCheckBox *checkBox, const QString &title, const QString &filter)
+void MainWindow::selectFirmwareFile(UpgradeManager::DeviceType device, QLineEdit *lineEdit, QCheckBox *checkBox,
+                                    const QString &title, const QString &filter)
 {
     const QString filePath = QFileDialog::getOpenFileName(
         this,
@@ -345,6 +321,14 @@ void MainWindow::selectFirmwareFile(QLineEdit *lineEdit, QCheckBox *checkBox, co
     if (!filePath.isEmpty()) {
         lineEdit->setText(filePath);
         checkBox->setChecked(true);
+
+        // 立即在后台准备固件，点击升级时即可直接开始传输
+        LinkWorker *worker = linkWorker;
+        const quint8 slaveId = getSlaveId();
+        const int packetSize = ui->lineEdit_size->text().toInt();
+        QMetaObject::invokeMethod(worker, [worker, device, filePath, slaveId, packetSize]() {
+            worker->preloadFirmware(device, filePath, slaveId, packetSize);
+        }, Qt::QueuedConnection);
     }
 }
 
@@ -405,7 +389,12 @@ void MainWindow::updateUiForLinkSelection(int index)
 {
     const bool serialSelected = (index == 0);
     if (!isConnected) {
-        commManager->setActiveLink(serialSelected ? CommunicationManager::LinkType::Serial : CommunicationManager::LinkType::Ethernet);
+        LinkWorker *worker = linkWorker;
+        const CommunicationManager::LinkType link = serialSelected ? CommunicationManager::LinkType::Serial
+                                                                   : CommunicationManager::LinkType::Ethernet;
+        QMetaObject::invokeMethod(worker, [worker, link]() {
+            worker->communication()->setActiveLink(link);
+        }, Qt::QueuedConnection);
     }
 
     ui->portName->setEnabled(serialSelected && !isConnected);
@@ -425,14 +414,52 @@ void MainWindow::updateUiForLinkSelection(int index)
     }
 }
 
-// 窗口追加信息
+// 窗口追加信息（缓存到下一次刷新）
 void MainWindow::appendInfoDisplay(const QString &text)
 {
-    QTextCursor cursor = ui->info_display->textCursor();
-    cursor.movePosition(QTextCursor::End);
-    cursor.insertText(text + QLatin1Char('\n'));
-    ui->info_display->setTextCursor(cursor);
-    ui->info_display->ensureCursorVisible();
+    // 一次刷新最多显示窗口能保留的行数，更早的行直接计数省略
+    if (pendingInfo.size() >= INFO_MAX_LINES) {
+        pendingInfo.removeFirst();
+        ++omittedInfo;
+    }
+    pendingInfo.append(text);
+
+    if (!infoFlushTimer.isActive()) {
+        infoFlushTimer.start();
+    }
+}
+
+// 把缓存的信息一次写入窗口，只触发一次重新布局
+void MainWindow::flushInfoDisplay()
+{
+    if (pendingInfo.isEmpty()) {
+        return;
+    }
+
+    if (omittedInfo > 0) {
+        pendingInfo.prepend(tr("(信息过多，省略 %1 条)").arg(omittedInfo));
+        omittedInfo = 0;
+    }
+
+    // 用户向上翻看时不自动滚动到底部
+    QScrollBar *scrollBar = ui->info_display->verticalScrollBar();
+    const bool atBottom = scrollBar->value() == scrollBar->maximum();
+
+    ui->info_display->appendPlainText(pendingInfo.join(QLatin1Char('\n')));
+    pendingInfo.clear();
+
+    if (atBottom) {
+        scrollBar->setValue(scrollBar->maximum());
+    }
+}
+
+// 清空信息窗口和尚未刷新的信息
+void MainWindow::clearInfoDisplay()
+{
+    infoFlushTimer.stop();
+    pendingInfo.clear();
+    omittedInfo = 0;
+    ui->info_display->clear();
 }
 
 // 写入日志文件
@@ -441,12 +468,7 @@ void MainWindow::writeToLogFile(const QString &text)
     if (!ui->checkBox_log->isChecked()) {
         return;
     }
-    QFile file(logFilePath);
-    if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
-        QTextStream out(&file);
-        out << text << "\n";
-        file.close();
-    }
+    uiLogChannel->logText(text);
 }
 
 // 获取从机ID
@@ -476,7 +498,7 @@ quint8 MainWindow::getSlaveId() const
 // 选择 FPGA 固件文件
 void MainWindow::on_pushButton_FPGA_clicked()
 {
-    selectFirmwareFile(ui->lineEdit_FPGA, ui->checkBox_FPGA,
+    selectFirmwareFile(UpgradeManager::DeviceType::FPGA, ui->lineEdit_FPGA, ui->checkBox_FPGA,
                       tr("选择 FPGA 文件"),
                       tr("FPGA 文件 (*.rbf *.bin);;所有文件 (*.*)"));
 }
@@ -484,7 +506,7 @@ void MainWindow::on_pushButton_FPGA_clicked()
 // 选择 DSP1 固件文件
 void MainWindow::on_pushButton_DSP1_clicked()
 {
-    selectFirmwareFile(ui->lineEdit_DSP1, ui->checkBox_DSP1,
+    selectFirmwareFile(UpgradeManager::DeviceType::DSP1, ui->lineEdit_DSP1, ui->checkBox_DSP1,
                       tr("选择 DSP1 文件"),
                       tr("DSP 文件 (*.hex *.bin);;所有文件 (*.*)"));
 }
@@ -492,7 +514,7 @@ void MainWindow::on_pushButton_DSP1_clicked()
 // 选择 DSP2 固件文件
 void MainWindow::on_pushButton_DSP2_clicked()
 {
-    selectFirmwareFile(ui->lineEdit_DSP2, ui->checkBox_DSP2,
+    selectFirmwareFile(UpgradeManager::DeviceType::DSP2, ui->lineEdit_DSP2, ui->checkBox_DSP2,
                       tr("选择 DSP2 文件"),
                       tr("DSP 文件 (*.hex *.bin);;所有文件 (*.*)"));
 }
@@ -500,7 +522,7 @@ void MainWindow::on_pushButton_DSP2_clicked()
 // 选择 ARM 固件文件
 void MainWindow::on_pushButton_ARM_clicked()
 {
-    selectFirmwareFile(ui->lineEdit_ARM, ui->checkBox_ARM,
+    selectFirmwareFile(UpgradeManager::DeviceType::ARM, ui->lineEdit_ARM, ui->checkBox_ARM,
                       tr("选择 ARM 文件"),
                       tr("ARM 文件 (*.hex *.bin);;所有文件 (*.*)"));
 }
@@ -539,41 +561,57 @@ void MainWindow::on_pushButton_SJ_clicked()
     quint8 slaveId = getSlaveId();
 
     // 自动清屏
-    ui->info_display->clear();
+    clearInfoDisplay();
+
+    // 在I/O线程开始升级流程，结果通过 UpgradeStarted 事件返回
+    ui->pushButton_SJ->setEnabled(false);
+
+    LinkWorker *worker = linkWorker;
+    const bool upgradeFPGA = ui->checkBox_FPGA->isChecked();
+    const bool upgradeDSP1 = ui->checkBox_DSP1->isChecked();
+    const bool upgradeDSP2 = ui->checkBox_DSP2->isChecked();
+    const bool upgradeARM = ui->checkBox_ARM->isChecked();
+    const QString fpgaPath = ui->lineEdit_FPGA->text();
+    const QString dsp1Path = ui->lineEdit_DSP1->text();
+    const QString dsp2Path = ui->lineEdit_DSP2->text();
+    const QString armPath = ui->lineEdit_ARM->text();
+    QMetaObject::invokeMethod(worker, [=]() {
+        worker->startUpgrade(slaveId, packetSize,
+                             upgradeFPGA, upgradeDSP1, upgradeDSP2, upgradeARM,
+                             fpgaPath, dsp1Path, dsp2Path, armPath);
+    }, Qt::QueuedConnection);
+}
 
-    // 开始升级流程
-    bool started = upgradeManager->startUpgrade(
-        slaveId, packetSize,
-        ui->checkBox_FPGA->isChecked(), ui->checkBox_DSP1->isChecked(),
-        ui->checkBox_DSP2->isChecked(), ui->checkBox_ARM->isChecked(),
-        ui->lineEdit_FPGA->text(), ui->lineEdit_DSP1->text(),
-        ui->lineEdit_DSP2->text(), ui->lineEdit_ARM->text()
-    );
-
-    if (started) {
-        // 修改升级按钮文本和状态
-        ui->pushButton_SJ->setText(tr("正在升级"));
-        ui->pushButton_SJ->setEnabled(false);
-        ui->pushButton_LJ->setEnabled(false);  // 升级过程中禁用断开按钮
-
-        // 禁用文件选择区域
-        ui->checkBox_FPGA->setEnabled(false);
-        ui->checkBox_DSP1->setEnabled(false);
-        ui->checkBox_DSP2->setEnabled(false);
-        ui->checkBox_ARM->setEnabled(false);
-        ui->lineEdit_FPGA->setEnabled(false);
-        ui->lineEdit_DSP1->setEnabled(false);
-        ui->lineEdit_DSP2->setEnabled(false);
-        ui->lineEdit_ARM->setEnabled(false);
-        ui->pushButton_FPGA->setEnabled(false);
-        ui->pushButton_DSP1->setEnabled(false);
-        ui->pushButton_DSP2->setEnabled(false);
-        ui->pushButton_ARM->setEnabled(false);
-
-        // 重置进度条
-        ui->progressBar_DQ->setValue(0);
-        ui->progressBar_ZT->setValue(0);
+// 升级已在I/O线程启动（或参数检查失败）
+void MainWindow::onUpgradeStarted(bool started)
+{
+    if (!started) {
+        ui->pushButton_SJ->setEnabled(true);
+        return;
     }
+
+    // 修改升级按钮文本和状态
+    ui->pushButton_SJ->setText(tr("正在升级"));
+    ui->pushButton_SJ->setEnabled(false);
+    ui->pushButton_LJ->setEnabled(false);  // 升级过程中禁用断开按钮
+
+    // 禁用文件选择区域
+    ui->checkBox_FPGA->setEnabled(false);
+    ui->checkBox_DSP1->setEnabled(false);
+    ui->checkBox_DSP2->setEnabled(false);
+    ui->checkBox_ARM->setEnabled(false);
+    ui->lineEdit_FPGA->setEnabled(false);
+    ui->lineEdit_DSP1->setEnabled(false);
+    ui->lineEdit_DSP2->setEnabled(false);
+    ui->lineEdit_ARM->setEnabled(false);
+    ui->pushButton_FPGA->setEnabled(false);
+    ui->pushButton_DSP1->setEnabled(false);
+    ui->pushButton_DSP2->setEnabled(false);
+    ui->pushButton_ARM->setEnabled(false);
+
+    // 重置进度条
+    ui->progressBar_DQ->setValue(0);
+    ui->progressBar_ZT->setValue(0);
 }
 
 // 通信方式选择
@@ -593,16 +631,24 @@ void MainWindow::on_link_currentIndexChanged(int index)
 // 日志窗口清屏
 void MainWindow::on_pushButton_clicked()
 {
-    ui->info_display->setText("");
+    clearInfoDisplay();
 }
 
 
 /* =============================== 升级管理器信号槽 ======================================= */
 //升级进度更新
-void MainWindow::onUpgradeProgressUpdated(int currentDevice, int totalDevice)
+void MainWindow::onUpgradeProgressUpdated(const UpgradeManager::Progress &progress)
 {
-    ui->progressBar_DQ->setValue(currentDevice);
-    ui->progressBar_ZT->setValue(totalDevice);
+    ui->progressBar_DQ->setValue(progress.devicePercent);
+    ui->progressBar_ZT->setValue(progress.totalPercent);
+
+    statusBar()->showMessage(tr("%1 升级中  %2 KB/s  %3 包/s  剩余 %4  总剩余 %5  重传 %6  超时 %7")
+                                 .arg(UpgradeManager::deviceName(progress.device))
+                                 .arg(progress.bytesPerSecond / 1024.0, 0, 'f', 1)
+                                 .arg(progress.packetsPerSecond, 0, 'f', 0)
+                                 .arg(formatEta(progress.deviceEtaMs), formatEta(progress.totalEtaMs))
+                                 .arg(progress.retransmits)
+                                 .arg(progress.timeouts));
 }
 
 // 升级完成
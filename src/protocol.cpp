@@ -1,10 +1,8 @@
 // protocol.cpp
 #include "inc/protocol.h"
+#include "inc/crc16.h"
 #include <QDebug>
-
-namespace {
-constexpr quint16 MIN_FRAME_SIZE = 9;
-}
+#include <cstring>
 
 /**
  * @brief 构造函数
@@ -19,166 +17,322 @@ BootLoaderProtocol::BootLoaderProtocol(QObject *parent)
  */
 quint16 BootLoaderProtocol::calculateCRC16(const QByteArray &data)
 {
-    quint16 crc = 0xFFFF;
-
-    for (int i = 0; i < data.size(); i++) {
-        crc ^= static_cast<quint8>(data[i]);
-        for (int j = 0; j < 8; j++) {
-            if (crc & 0x0001) {
-                crc = (crc >> 1) ^ 0xA001;
-            } else {
-                crc >>= 1;
-            }
-        }
-    }
+    return Crc16::calculate(data.constData(), data.size());
+}
 
-    return crc;
+quint16 BootLoaderProtocol::calculateCRC16(const char *data, qsizetype size)
+{
+    return Crc16::calculate(data, size);
 }
 
 /**
- * @brief 构建上位机报文帧
+ * @brief 编码帧头、长度、类型和标识
  */
-QByteArray BootLoaderProtocol::buildMasterFrame(quint8 slaveId, MessageType type, ResponseFlag flag, const QByteArray &payload)
+qsizetype BootLoaderProtocol::encodeHeader(char *out, quint8 header1, quint8 header2, quint8 slaveId,
+                                           qsizetype frameLength, MessageType type, ResponseFlag flag)
 {
-    QByteArray frame;
-    // 报文总长度 = 帧头(2) + ID(1) + 长度(2) + 类型(1) + 标识(1) + 数据(N) + CRC(2)
-    quint16 length = 9 + payload.size();
-
     // 帧头
-    frame.append(static_cast<char>(MASTER_HEADER1));
-    frame.append(static_cast<char>(MASTER_HEADER2));
+    out[0] = static_cast<char>(header1);
+    out[1] = static_cast<char>(header2);
 
     // 下位机ID
-    frame.append(static_cast<char>(slaveId));
+    out[2] = static_cast<char>(slaveId);
 
     // 长度（高位在前）
-    frame.append(static_cast<char>((length >> 8) & 0xFF));
-    frame.append(static_cast<char>(length & 0xFF));
+    out[3] = static_cast<char>((frameLength >> 8) & 0xFF);
+    out[4] = static_cast<char>(frameLength & 0xFF);
 
     // 报文类型
-    frame.append(static_cast<char>(type));
+    out[5] = static_cast<char>(type);
 
     // 应答标识
-    frame.append(static_cast<char>(flag));
+    out[6] = static_cast<char>(flag);
 
-    // 命令数据
-    frame.append(payload);
+    return 7;
+}
 
-    // 计算CRC（从帧头开始到数据结束，不包含CRC本身）
+/**
+ * @brief 计算CRC并追加在数据之后
+ */
+qsizetype BootLoaderProtocol::appendCRC(char *out, qsizetype length)
+{
     // CRC校验范围：帧头(2) + ID(1) + 长度(2) + 类型(1) + 标识(1) + 数据(N)
-    quint16 crc = calculateCRC16(frame);
+    const quint16 crc = calculateCRC16(out, length);
 
     // CRC（低位在前，高位在后）
-    frame.append(static_cast<char>(crc & 0xFF));          // 低位
-    frame.append(static_cast<char>((crc >> 8) & 0xFF));   // 高位
+    out[length] = static_cast<char>(crc & 0xFF);            // 低位
+    out[length + 1] = static_cast<char>((crc >> 8) & 0xFF); // 高位
 
-    return frame;
+    return length + 2;
 }
 
-/**
- * @brief 构建下位机报文帧
- */
-QByteArray BootLoaderProtocol::buildSlaveFrame(quint8 slaveId, MessageType type, ResponseFlag flag, const QByteArray &payload)
+qsizetype BootLoaderProtocol::encodeMasterFrame(char *out, quint8 slaveId, MessageType type, ResponseFlag flag, QByteArrayView payload)
 {
-    QByteArray frame;
-    // 报文总长度 = 帧头(2) + ID(1) + 长度(2) + 类型(1) + 标识(1) + 数据(N) + CRC(2)
-    quint16 length = 9 + payload.size();
+    const qsizetype length = frameSize(payload.size());
+    qsizetype pos = encodeHeader(out, MASTER_HEADER1, MASTER_HEADER2, slaveId, length, type, flag);
 
-    // 帧头（下位机是0x55 0xAA）
-    frame.append(static_cast<char>(SLAVE_HEADER1));
-    frame.append(static_cast<char>(SLAVE_HEADER2));
+    // 命令数据
+    if (!payload.isEmpty()) {
+        std::memcpy(out + pos, payload.data(), static_cast<size_t>(payload.size()));
+        pos += payload.size();
+    }
 
-    // ID
-    frame.append(static_cast<char>(slaveId));
+    return appendCRC(out, pos);
+}
 
-    // 长度（高位在前）
-    frame.append(static_cast<char>((length >> 8) & 0xFF));
-    frame.append(static_cast<char>(length & 0xFF));
+qsizetype BootLoaderProtocol::encodeUpgradeDataHeader(char *out, quint8 slaveId, MessageType type, quint32 packetNum, qsizetype dataSize, bool extended)
+{
+    const qsizetype length = frameSize(packetNumberSize(extended) + dataSize);
+    qsizetype pos = encodeHeader(out, MASTER_HEADER1, MASTER_HEADER2, slaveId, length, type, ResponseFlag::REQUEST_FLAG);
 
-    // 报文类型
-    frame.append(static_cast<char>(type));
+    // 数据包序号（高字节在前），扩展寻址为4字节
+    if (extended) {
+        out[pos++] = static_cast<char>((packetNum >> 24) & 0xFF);
+        out[pos++] = static_cast<char>((packetNum >> 16) & 0xFF);
+    }
+    out[pos++] = static_cast<char>((packetNum >> 8) & 0xFF);
+    out[pos++] = static_cast<char>(packetNum & 0xFF);
 
-    // 应答标识
-    frame.append(static_cast<char>(flag));
+    return pos;
+}
 
-    // 命令数据
-    frame.append(payload);
+qsizetype BootLoaderProtocol::encodeDeltaDataHeader(char *out, quint8 slaveId, quint32 packetNum, quint32 block, qsizetype dataSize)
+{
+    const qsizetype length = frameSize(DELTA_DATA_FIELDS + dataSize);
+    qsizetype pos = encodeHeader(out, MASTER_HEADER1, MASTER_HEADER2, slaveId, length,
+                                 MessageType::DELTA_DATA, ResponseFlag::REQUEST_FLAG);
 
-    // 计算CRC（从帧头开始到数据结束，不包含CRC本身）
-    // CRC校验范围：帧头(2) + ID(1) + 长度(2) + 类型(1) + 标识(1) + 数据(N)
-    quint16 crc = calculateCRC16(frame);
+    // 差分包序号、块号（各4字节，高字节在前）
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out[pos++] = static_cast<char>((packetNum >> shift) & 0xFF);
+    }
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out[pos++] = static_cast<char>((block >> shift) & 0xFF);
+    }
 
-    // CRC（低位在前，高位在后）
-    frame.append(static_cast<char>(crc & 0xFF));          // 低位
-    frame.append(static_cast<char>((crc >> 8) & 0xFF));   // 高位
+    return pos;
+}
+
+qsizetype BootLoaderProtocol::encodeCompressedDataHeader(char *out, quint8 slaveId, quint32 packetNum, quint32 block, quint16 rawSize, qsizetype dataSize)
+{
+    const qsizetype length = frameSize(COMPRESSED_DATA_FIELDS + dataSize);
+    qsizetype pos = encodeHeader(out, MASTER_HEADER1, MASTER_HEADER2, slaveId, length,
+                                 MessageType::COMPRESSED_DATA, ResponseFlag::REQUEST_FLAG);
+
+    // 包序号、块号（各4字节）与原始长度（2字节），高字节在前
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out[pos++] = static_cast<char>((packetNum >> shift) & 0xFF);
+    }
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        out[pos++] = static_cast<char>((block >> shift) & 0xFF);
+    }
+    out[pos++] = static_cast<char>((rawSize >> 8) & 0xFF);
+    out[pos++] = static_cast<char>(rawSize & 0xFF);
 
+    return pos;
+}
 
+qsizetype BootLoaderProtocol::encodeUpgradeData(char *out, quint8 slaveId, MessageType type, quint16 packetNum, QByteArrayView data)
+{
+    qsizetype pos = encodeUpgradeDataHeader(out, slaveId, type, packetNum, data.size());
+
+    // 升级文件内容
+    if (!data.isEmpty()) {
+        std::memcpy(out + pos, data.data(), static_cast<size_t>(data.size()));
+        pos += data.size();
+    }
+
+    return appendCRC(out, pos);
+}
+
+/**
+ * @brief 构建上位机报文帧
+ */
+QByteArray BootLoaderProtocol::buildMasterFrame(quint8 slaveId, MessageType type, ResponseFlag flag, QByteArrayView payload)
+{
+    // 报文总长度 = 帧头(2) + ID(1) + 长度(2) + 类型(1) + 标识(1) + 数据(N) + CRC(2)
+    QByteArray frame(frameSize(payload.size()), Qt::Uninitialized);
+    encodeMasterFrame(frame.data(), slaveId, type, flag, payload);
     return frame;
 }
 
+/**
+ * @brief 构建下位机报文帧
+ */
+QByteArray BootLoaderProtocol::buildSlaveFrame(quint8 slaveId, MessageType type, ResponseFlag flag, QByteArrayView payload)
+{
+    // 报文总长度 = 帧头(2) + ID(1) + 长度(2) + 类型(1) + 标识(1) + 数据(N) + CRC(2)
+    QByteArray frame(frameSize(payload.size()), Qt::Uninitialized);
+    char *out = frame.data();
+
+    // 帧头（下位机是0x55 0xAA）
+    qsizetype pos = encodeHeader(out, SLAVE_HEADER1, SLAVE_HEADER2, slaveId, frame.size(), type, flag);
+
+    // 命令数据
+    if (!payload.isEmpty()) {
+        std::memcpy(out + pos, payload.data(), static_cast<size_t>(payload.size()));
+        pos += payload.size();
+    }
+
+    appendCRC(out, pos);
+    return frame;
+}
+
+/**
+ * @brief 获取预编码的控制报文
+ *
+ * 复位、升级结束和总体结束报文的内容只取决于从机ID和报文类型，
+ * 首次使用时编码一次，之后返回共享的同一份数据。
+ */
+QByteArray BootLoaderProtocol::controlFrame(quint8 slaveId, MessageType type)
+{
+    const quint16 key = static_cast<quint16>((slaveId << 8) | static_cast<quint8>(type));
+    auto it = m_controlFrames.constFind(key);
+    if (it == m_controlFrames.constEnd()) {
+        const char payload = 0x00;
+        it = m_controlFrames.insert(key, buildMasterFrame(slaveId, type, ResponseFlag::REQUEST_FLAG,
+                                                          QByteArrayView(&payload, 1)));
+    }
+    return it.value();
+}
+
 // ============= 上位机发送接口实现 =============
 
 QByteArray BootLoaderProtocol::buildUpgradeRequest(quint8 slaveId, const UpgradeFlags &flags)
 {
-    QByteArray payload;
-    payload.append(static_cast<char>(flags.toByte()));
-    return buildMasterFrame(slaveId, MessageType::UPGRADE_REQUEST, ResponseFlag::REQUEST_FLAG, payload);
+    const char payload = static_cast<char>(flags.toByte());
+    return buildMasterFrame(slaveId, MessageType::UPGRADE_REQUEST, ResponseFlag::REQUEST_FLAG, QByteArrayView(&payload, 1));
 }
 
 QByteArray BootLoaderProtocol::buildSystemReset(quint8 slaveId)
 {
-    QByteArray payload;
-    payload.append(static_cast<char>(0x00));
-    return buildMasterFrame(slaveId, MessageType::SYSTEM_RESET, ResponseFlag::REQUEST_FLAG, payload);
+    return controlFrame(slaveId, MessageType::SYSTEM_RESET);
 }
 
 QByteArray BootLoaderProtocol::buildUpgradeCommand(quint8 slaveId, MessageType type, quint32 fileSize, quint16 packetCount, quint16 fileCRC)
 {
-    QByteArray payload;
+    char payload[8];
 
     // 文件大小（高字节在前）
-    payload.append(static_cast<char>((fileSize >> 24) & 0xFF));
-    payload.append(static_cast<char>((fileSize >> 16) & 0xFF));
-    payload.append(static_cast<char>((fileSize >> 8) & 0xFF));
-    payload.append(static_cast<char>(fileSize & 0xFF));
+    payload[0] = static_cast<char>((fileSize >> 24) & 0xFF);
+    payload[1] = static_cast<char>((fileSize >> 16) & 0xFF);
+    payload[2] = static_cast<char>((fileSize >> 8) & 0xFF);
+    payload[3] = static_cast<char>(fileSize & 0xFF);
 
     // 数据包总数（高字节在前）
-    payload.append(static_cast<char>((packetCount >> 8) & 0xFF));
-    payload.append(static_cast<char>(packetCount & 0xFF));
+    payload[4] = static_cast<char>((packetCount >> 8) & 0xFF);
+    payload[5] = static_cast<char>(packetCount & 0xFF);
 
     // 文件CRC16（高字节在前）
-    payload.append(static_cast<char>((fileCRC >> 8) & 0xFF));
-    payload.append(static_cast<char>(fileCRC & 0xFF));
+    payload[6] = static_cast<char>((fileCRC >> 8) & 0xFF);
+    payload[7] = static_cast<char>(fileCRC & 0xFF);
 
-    return buildMasterFrame(slaveId, type, ResponseFlag::REQUEST_FLAG, payload);
+    return buildMasterFrame(slaveId, type, ResponseFlag::REQUEST_FLAG, QByteArrayView(payload, sizeof(payload)));
 }
 
-QByteArray BootLoaderProtocol::buildUpgradeData(quint8 slaveId, MessageType type, quint16 packetNum, const QByteArray &data)
+QByteArray BootLoaderProtocol::buildUpgradeCommandExtended(quint8 slaveId, MessageType type, quint64 fileSize, quint32 packetCount, quint16 fileCRC)
 {
-    QByteArray payload;
+    char payload[14];
+    int pos = 0;
 
-    // 数据包序号（高字节在前）
-    payload.append(static_cast<char>((packetNum >> 8) & 0xFF));
-    payload.append(static_cast<char>(packetNum & 0xFF));
+    // 文件大小（8字节，高字节在前）
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        payload[pos++] = static_cast<char>((fileSize >> shift) & 0xFF);
+    }
 
-    // 升级文件内容
-    payload.append(data);
+    // 数据包总数（4字节，高字节在前）
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        payload[pos++] = static_cast<char>((packetCount >> shift) & 0xFF);
+    }
+
+    // 文件CRC16（高字节在前）
+    payload[pos++] = static_cast<char>((fileCRC >> 8) & 0xFF);
+    payload[pos++] = static_cast<char>(fileCRC & 0xFF);
+
+    return buildMasterFrame(slaveId, type, ResponseFlag::REQUEST_FLAG, QByteArrayView(payload, pos));
+}
+
+QByteArray BootLoaderProtocol::buildResume(quint8 slaveId, MessageType commandType, quint64 fileSize, quint32 packetCount, quint16 fileCRC, quint32 fromPacket)
+{
+    char payload[19];
+    int pos = 0;
+
+    // 续传的设备（升级命令类型）
+    payload[pos++] = static_cast<char>(commandType);
+
+    // 文件大小（8字节，高字节在前）
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        payload[pos++] = static_cast<char>((fileSize >> shift) & 0xFF);
+    }
+
+    // 数据包总数（4字节，高字节在前）
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        payload[pos++] = static_cast<char>((packetCount >> shift) & 0xFF);
+    }
+
+    // 文件CRC16（高字节在前）
+    payload[pos++] = static_cast<char>((fileCRC >> 8) & 0xFF);
+    payload[pos++] = static_cast<char>(fileCRC & 0xFF);
 
-    return buildMasterFrame(slaveId, type, ResponseFlag::REQUEST_FLAG, payload);
+    // 已累计确认的包数（4字节，高字节在前）
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        payload[pos++] = static_cast<char>((fromPacket >> shift) & 0xFF);
+    }
+
+    return buildMasterFrame(slaveId, MessageType::RESUME, ResponseFlag::REQUEST_FLAG, QByteArrayView(payload, pos));
+}
+
+QByteArray BootLoaderProtocol::buildDeltaCommand(quint8 slaveId, MessageType commandType, quint64 baselineSize, quint16 baselineCRC, quint64 fileSize, quint32 packetCount, quint16 fileCRC, quint16 blockSize)
+{
+    char payload[27];
+    int pos = 0;
+
+    // 目标设备（升级命令类型）
+    payload[pos++] = static_cast<char>(commandType);
+
+    // 基线固件大小（8字节）与CRC16，高字节在前
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        payload[pos++] = static_cast<char>((baselineSize >> shift) & 0xFF);
+    }
+    payload[pos++] = static_cast<char>((baselineCRC >> 8) & 0xFF);
+    payload[pos++] = static_cast<char>(baselineCRC & 0xFF);
+
+    // 新固件大小（8字节）
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        payload[pos++] = static_cast<char>((fileSize >> shift) & 0xFF);
+    }
+
+    // 差分数据包总数（4字节）
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        payload[pos++] = static_cast<char>((packetCount >> shift) & 0xFF);
+    }
+
+    // 新固件CRC16
+    payload[pos++] = static_cast<char>((fileCRC >> 8) & 0xFF);
+    payload[pos++] = static_cast<char>(fileCRC & 0xFF);
+
+    // 块大小（2字节）
+    payload[pos++] = static_cast<char>((blockSize >> 8) & 0xFF);
+    payload[pos++] = static_cast<char>(blockSize & 0xFF);
+
+    return buildMasterFrame(slaveId, MessageType::DELTA_COMMAND, ResponseFlag::REQUEST_FLAG, QByteArrayView(payload, pos));
+}
+
+QByteArray BootLoaderProtocol::buildUpgradeData(quint8 slaveId, MessageType type, quint16 packetNum, const QByteArray &data)
+{
+    QByteArray frame(frameSize(2 + data.size()), Qt::Uninitialized);
+    encodeUpgradeData(frame.data(), slaveId, type, packetNum, data);
+    return frame;
 }
 
 QByteArray BootLoaderProtocol::buildUpgradeEnd(quint8 slaveId, MessageType type)
 {
-    QByteArray payload;
-    payload.append(static_cast<char>(0x00));
-    return buildMasterFrame(slaveId, type, ResponseFlag::REQUEST_FLAG, payload);
+    return controlFrame(slaveId, type);
 }
 
 QByteArray BootLoaderProtocol::buildTotalEnd(quint8 slaveId)
 {
-    QByteArray payload;
-    payload.append(static_cast<char>(0x00));
-    return buildMasterFrame(slaveId, MessageType::TOTAL_END, ResponseFlag::REQUEST_FLAG, payload);
+    return controlFrame(slaveId, MessageType::TOTAL_END);
 }
 
 // ============= 下位机发送接口实现 =============
@@ -190,9 +344,8 @@ QByteArray BootLoaderProtocol::buildResponse(quint8 slaveId, MessageType type, R
 
 QByteArray BootLoaderProtocol::buildDebugInfo(quint8 slaveId, ResponseFlag flag)
 {
-    QByteArray payload;
-    payload.append(static_cast<char>(0x00));
-    return buildSlaveFrame(slaveId, MessageType::DEBUG_INFO, flag, payload);
+    const char payload = 0x00;
+    return buildSlaveFrame(slaveId, MessageType::DEBUG_INFO, flag, QByteArrayView(&payload, 1));
 }
 
 // ============= 接收解析接口实现 =============
@@ -201,85 +354,64 @@ QList<QByteArray> BootLoaderProtocol::parseReceivedData(const QByteArray &data)
 {
     QList<QByteArray> frames;
 
-    // 将新数据追加到接收缓冲区
-    m_receiveBuffer.append(data);
-
-    // 查找并提取完整帧
-    while (m_receiveBuffer.size() >= 5) {
-        bool foundHeader = false;
-        int headerPos = 0;
-
-        // 查找帧头
-        for (int i = 0; i < m_receiveBuffer.size() - 1; i++) {
-            quint8 byte1 = static_cast<quint8>(m_receiveBuffer[i]);
-            quint8 byte2 = static_cast<quint8>(m_receiveBuffer[i + 1]);
-
-            if ((byte1 == MASTER_HEADER1 && byte2 == MASTER_HEADER2) ||
-                (byte1 == SLAVE_HEADER1 && byte2 == SLAVE_HEADER2)) {
-                foundHeader = true;
-                headerPos = i;
-                break;
-            }
-        }
+    const char *input = data.constData();
+    qsizetype remaining = data.size();
 
-        if (!foundHeader) {
-            m_receiveBuffer.clear();
-            break;
-        }
-
-        // 删除帧头之前的无效数据
-        if (headerPos > 0) {
-            m_receiveBuffer.remove(0, headerPos);
-        }
+    // 缓冲区满时先取出帧再继续写入
+    do {
+        const qsizetype written = feedReceivedData(input, remaining);
+        input += written;
+        remaining -= written;
 
-        // 检查长度字段是否完整
-        if (m_receiveBuffer.size() < 5) {
-            break;
+        QByteArrayView frame;
+        while (nextReceivedFrame(frame)) {
+            frames.append(frame.toByteArray());
         }
+    } while (remaining > 0);
 
-        // 获取报文长度（长度字段表示整个报文的总字节数）
-        quint16 length = (static_cast<quint8>(m_receiveBuffer[3]) << 8) |
-                         static_cast<quint8>(m_receiveBuffer[4]);
-        if (length < MIN_FRAME_SIZE) {
-            qWarning().noquote() << QStringLiteral("BootLoaderProtocol: invalid frame length %1, dropping header")
-                                        .arg(length);
-            const int removeCount = m_receiveBuffer.size() >= 2 ? 2 : m_receiveBuffer.size();
-            m_receiveBuffer.remove(0, removeCount);
-            continue;
-        }
-        quint16 totalLength = length;  // 长度字段已经包含了所有内容
+    return frames;
+}
 
-        // 检查完整帧是否接收完毕
-        if (m_receiveBuffer.size() < totalLength) {
-            break;
-        }
+qsizetype BootLoaderProtocol::feedReceivedData(const char *data, qsizetype size)
+{
+    return m_decoder.write(data, size);
+}
 
-        // 提取完整帧
-        QByteArray frame = m_receiveBuffer.left(totalLength);
-        m_receiveBuffer.remove(0, totalLength);
+bool BootLoaderProtocol::nextReceivedFrame(QByteArrayView &frame)
+{
+    return m_decoder.nextFrame(frame);
+}
 
-        frames.append(frame);
+bool BootLoaderProtocol::parseFrame(const QByteArray &frame, quint8 &slaveId, MessageType &type, ResponseFlag &flag, QByteArray &payload)
+{
+    Frame decoded;
+    if (!parseFrame(QByteArrayView(frame), decoded)) {
+        return false;
     }
 
-    return frames;
+    slaveId = decoded.slaveId;
+    type = decoded.type;
+    flag = decoded.flag;
+    payload = decoded.payload.toByteArray();
+
+    return true;
 }
 
-bool BootLoaderProtocol::parseFrame(const QByteArray &frame, quint8 &slaveId, MessageType &type, ResponseFlag &flag, QByteArray &payload)
+bool BootLoaderProtocol::parseFrame(QByteArrayView frame, Frame &decoded)
 {
     if (frame.size() < 10) {
         return false;
     }
 
     // 验证CRC（CRC校验范围：从帧头到数据结束，不包含最后2字节CRC）
-    QByteArray crcData = frame.left(frame.size() - 2);
-    quint16 calculatedCRC = calculateCRC16(crcData);
+    quint16 calculatedCRC = calculateCRC16(frame.data(), frame.size() - 2);
     // 接收到的CRC：低位在前，高位在后
     quint16 receivedCRC = static_cast<quint8>(frame[frame.size() - 2]) |
                           (static_cast<quint8>(frame[frame.size() - 1]) << 8);
 
     if (calculatedCRC != receivedCRC) {
-        const quint8 typeValue = frame.size() > 5 ? static_cast<quint8>(frame[5]) : 0x00;
-        const quint8 flagValue = frame.size() > 6 ? static_cast<quint8>(frame[6]) : 0x00;
+        const quint8 typeValue = static_cast<quint8>(frame[5]);
+        const quint8 flagValue = static_cast<quint8>(frame[6]);
         qWarning().noquote() << QStringLiteral("BootLoaderProtocol: CRC mismatch (type=0x%1 flag=0x%2 len=%3)")
                                     .arg(typeValue, 2, 16, QLatin1Char('0'))
                                     .arg(flagValue, 2, 16, QLatin1Char('0'))
@@ -288,19 +420,15 @@ bool BootLoaderProtocol::parseFrame(const QByteArray &frame, quint8 &slaveId, Me
     }
 
     // 解析字段
-    slaveId = static_cast<quint8>(frame[2]);
-    type = static_cast<MessageType>(frame[5]);
-    flag = static_cast<ResponseFlag>(frame[6]);
+    decoded.raw = frame;
+    decoded.slaveId = static_cast<quint8>(frame[2]);
+    decoded.type = static_cast<MessageType>(frame[5]);
+    decoded.flag = static_cast<ResponseFlag>(frame[6]);
 
     // 提取命令数据
     // 帧结构: 帧头(2) + ID(1) + 长度(2) + 类型(1) + 标识(1) + 数据(N) + CRC(2)
     // 最小帧长度为9字节(无数据)，有数据时为9+N字节
-    int dataLength = frame.size() - 9;  // 减去除数据外的所有字段
-    if (dataLength > 0) {
-        payload = frame.mid(7, dataLength);
-    } else {
-        payload.clear();
-    }
+    decoded.payload = frame.sliced(7, frame.size() - 9);
 
     return true;
 }
@@ -376,7 +504,67 @@ QString BootLoaderProtocol::getMessageTypeDescription(MessageType type)
         case MessageType::DSP2_DATA: return "DSP2升级数据";
         case MessageType::DSP2_END: return "DSP2升级结束";
         case MessageType::TOTAL_END: return "总体结束";
+        case MessageType::RESUME: return "断点续传";
+        case MessageType::DELTA_COMMAND: return "差分升级指令";
+        case MessageType::DELTA_DATA: return "差分升级数据";
+        case MessageType::COMPRESSED_DATA: return "压缩升级数据";
         case MessageType::DEBUG_INFO: return "调试信息";
         default: return QString("未知类型(0x%1)").arg(static_cast<quint8>(type), 2, 16, QChar('0'));
     }
 }
+
+// 上位机报文描述
+QString BootLoaderProtocol::describeMasterFrame(QByteArrayView frame, bool extended)
+{
+    if (frame.size() < FRAME_OVERHEAD) {
+        return QString();
+    }
+
+    const MessageType type = static_cast<MessageType>(frame[5]);
+    const QString description = getMessageTypeDescription(type);
+
+    switch (type) {
+        case MessageType::ARM_DATA:
+        case MessageType::FPGA_DATA:
+        case MessageType::DSP1_DATA:
+        case MessageType::DSP2_DATA:
+            if (frame.size() >= frameSize(packetNumberSize(extended))) {
+                quint32 packetNum = 0;
+                for (qsizetype i = 0; i < packetNumberSize(extended); ++i) {
+                    packetNum = (packetNum << 8) | static_cast<quint8>(frame[7 + i]);
+                }
+                return QStringLiteral("%1 #%2").arg(description).arg(packetNum);
+            }
+            return description;
+        case MessageType::DELTA_DATA:
+            if (frame.size() >= frameSize(DELTA_DATA_FIELDS)) {
+                quint32 packetNum = 0;
+                quint32 block = 0;
+                for (qsizetype i = 0; i < 4; ++i) {
+                    packetNum = (packetNum << 8) | static_cast<quint8>(frame[7 + i]);
+                    block = (block << 8) | static_cast<quint8>(frame[11 + i]);
+                }
+                return QStringLiteral("%1 #%2 (块 %3)").arg(description).arg(packetNum).arg(block);
+            }
+            return description;
+        case MessageType::COMPRESSED_DATA:
+            if (frame.size() >= frameSize(COMPRESSED_DATA_FIELDS)) {
+                quint32 packetNum = 0;
+                quint32 block = 0;
+                for (qsizetype i = 0; i < 4; ++i) {
+                    packetNum = (packetNum << 8) | static_cast<quint8>(frame[7 + i]);
+                    block = (block << 8) | static_cast<quint8>(frame[11 + i]);
+                }
+                const quint16 rawSize = static_cast<quint16>((static_cast<quint8>(frame[15]) << 8) |
+                                                             static_cast<quint8>(frame[16]));
+                // 日志只传入帧的前若干字节，数据长度取自帧中的长度字段（整个报文的总字节数）
+                const qsizetype length = (static_cast<quint8>(frame[3]) << 8) | static_cast<quint8>(frame[4]);
+                const qsizetype dataSize = length - frameSize(COMPRESSED_DATA_FIELDS);
+                return QStringLiteral("%1 #%2 (块 %3, %4/%5 字节)")
+                    .arg(description).arg(packetNum).arg(block).arg(dataSize).arg(rawSize);
+            }
+            return description;
+        default:
+            return description;
+    }
+}
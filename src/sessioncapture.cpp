@@ -0,0 +1,138 @@
+#include "inc/sessioncapture.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+constexpr char MAGIC[4] = {'B', 'L', 'C', 'P'};
+constexpr qsizetype FLUSH_THRESHOLD = 256 * 1024;   // 缓冲区达到该大小时写入文件
+}
+
+SessionCapture::SessionCapture()
+{
+}
+
+SessionCapture::~SessionCapture()
+{
+    close();
+}
+
+bool SessionCapture::open(const QString &path, QString *errorString)
+{
+    close();
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (errorString) {
+            *errorString = m_file.errorString();
+        }
+        return false;
+    }
+
+    char header[FILE_HEADER_SIZE];
+    std::memcpy(header, MAGIC, sizeof(MAGIC));
+    qToLittleEndian<quint16>(VERSION, header + 4);
+    qToLittleEndian<quint16>(FILE_HEADER_SIZE, header + 6);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), header + 8);
+
+    m_buffer.clear();
+    m_buffer.reserve(FLUSH_THRESHOLD + RECORD_HEADER_SIZE + 0xFFFF);
+    m_buffer.append(header, FILE_HEADER_SIZE);
+    m_clock.start();
+    return true;
+}
+
+void SessionCapture::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+    flush();
+    m_file.close();
+}
+
+void SessionCapture::write(Link link, Direction direction, QByteArrayView frame, quint16 flags)
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+
+    char header[RECORD_HEADER_SIZE];
+    qToLittleEndian<quint64>(static_cast<quint64>(m_clock.nsecsElapsed()), header);
+    header[8] = static_cast<char>(link);
+    header[9] = static_cast<char>(direction);
+    qToLittleEndian<quint16>(flags, header + 10);
+    qToLittleEndian<quint32>(static_cast<quint32>(frame.size()), header + 12);
+
+    m_buffer.append(header, RECORD_HEADER_SIZE);
+    m_buffer.append(frame.data(), frame.size());
+
+    if (m_buffer.size() >= FLUSH_THRESHOLD) {
+        flush();
+    }
+}
+
+void SessionCapture::flush()
+{
+    if (!m_buffer.isEmpty()) {
+        m_file.write(m_buffer);
+        m_buffer.clear();
+    }
+    m_file.flush();
+}
+
+// ============= 读取器 =============
+
+bool SessionCaptureReader::open(const QString &path, QString *errorString)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (errorString) {
+            *errorString = m_file.errorString();
+        }
+        return false;
+    }
+
+    char header[SessionCapture::FILE_HEADER_SIZE];
+    if (m_file.read(header, sizeof(header)) != sizeof(header) || std::memcmp(header, MAGIC, sizeof(MAGIC)) != 0) {
+        if (errorString) {
+            *errorString = QStringLiteral("not a session capture file");
+        }
+        m_file.close();
+        return false;
+    }
+
+    const quint16 version = qFromLittleEndian<quint16>(header + 4);
+    const quint16 headerSize = qFromLittleEndian<quint16>(header + 6);
+    if (version != SessionCapture::VERSION || headerSize < SessionCapture::FILE_HEADER_SIZE) {
+        if (errorString) {
+            *errorString = QStringLiteral("unsupported capture version %1").arg(version);
+        }
+        m_file.close();
+        return false;
+    }
+
+    m_startTime = qFromLittleEndian<qint64>(header + 8);
+    m_file.seek(headerSize);
+    return true;
+}
+
+bool SessionCaptureReader::next(SessionCapture::Record &record)
+{
+    char header[SessionCapture::RECORD_HEADER_SIZE];
+    if (m_file.read(header, sizeof(header)) != sizeof(header)) {
+        return false;
+    }
+
+    record.timestampNs = qFromLittleEndian<quint64>(header);
+    record.link = static_cast<SessionCapture::Link>(static_cast<quint8>(header[8]));
+    record.direction = static_cast<SessionCapture::Direction>(static_cast<quint8>(header[9]));
+    record.flags = qFromLittleEndian<quint16>(header + 10);
+
+    const quint32 length = qFromLittleEndian<quint32>(header + 12);
+    record.data = m_file.read(length);
+    return record.data.size() == static_cast<qsizetype>(length);
+}
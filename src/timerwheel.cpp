@@ -0,0 +1,152 @@
+#include "inc/timerwheel.h"
+#include <QThreadStorage>
+
+// ============= 定时器 =============
+
+TimerWheel::Timer::Timer(std::function<void()> callback)
+    : callback(std::move(callback))
+{
+}
+
+TimerWheel::Timer::~Timer()
+{
+    stop();
+}
+
+void TimerWheel::Timer::start(int ms)
+{
+    stop();
+    intervalMs = ms;
+    TimerWheel::forCurrentThread()->add(this, ms);
+}
+
+void TimerWheel::Timer::stop()
+{
+    if (wheel) {
+        wheel->remove(this);
+    }
+}
+
+// ============= 时间轮 =============
+
+TimerWheel::TimerWheel()
+    : QObject(nullptr)
+    , currentTick(0)
+    , activeTimers(0)
+{
+    for (Node &list : slotLists) {
+        list.prev = &list;
+        list.next = &list;
+    }
+    clock.start();
+
+    tickTimer.setTimerType(Qt::PreciseTimer);
+    tickTimer.setInterval(TICK_MS);
+    connect(&tickTimer, &QTimer::timeout, this, &TimerWheel::advance);
+}
+
+TimerWheel::~TimerWheel()
+{
+    // 线程结束时仍挂着的定时器脱离时间轮，之后销毁它们不再访问本对象
+    for (Node &list : slotLists) {
+        while (list.next != &list) {
+            Timer *timer = static_cast<Timer *>(list.next);
+            unlink(timer);
+            timer->wheel = nullptr;
+        }
+    }
+}
+
+TimerWheel *TimerWheel::forCurrentThread()
+{
+    static QThreadStorage<TimerWheel *> wheels;
+    if (!wheels.hasLocalData()) {
+        wheels.setLocalData(new TimerWheel);
+    }
+    return wheels.localData();
+}
+
+void TimerWheel::add(Timer *timer, int ms)
+{
+    const quint64 now = elapsedTicks();
+    if (activeTimers == 0) {
+        // 空闲后重新开始推进，跳过停止期间的刻度
+        currentTick = qMax(currentTick, now);
+    }
+    if (!tickTimer.isActive()) {
+        tickTimer.start();
+    }
+
+    // 向上取整，另加当前已走了一部分的刻度，保证不早于设定时间；至少落在下一个待处理刻度
+    const quint64 ticks = (static_cast<quint64>(qMax(ms, 0)) + TICK_MS - 1) / TICK_MS;
+    timer->expiry = qMax(now + ticks + 1, currentTick + 1);
+    timer->wheel = this;
+    linkTail(slotLists[timer->expiry % SLOT_COUNT], timer);
+    activeTimers++;
+}
+
+void TimerWheel::remove(Timer *timer)
+{
+    unlink(timer);
+    timer->wheel = nullptr;
+    activeTimers--;
+}
+
+void TimerWheel::advance()
+{
+    const quint64 target = elapsedTicks();
+
+    // 落后超过一圈（如系统休眠）时只需再转一圈，到期判断按当前刻度
+    if (target > currentTick + SLOT_COUNT) {
+        currentTick = target - SLOT_COUNT;
+    }
+
+    while (currentTick < target && activeTimers > 0) {
+        currentTick++;
+        Node &list = slotLists[currentTick % SLOT_COUNT];
+        if (list.next == &list) {
+            continue;
+        }
+
+        // 先把槽位整体摘到临时链表，回调中启动/停止任何定时器都不影响遍历
+        Node due;
+        due.next = list.next;
+        due.prev = list.prev;
+        due.next->prev = &due;
+        due.prev->next = &due;
+        list.prev = &list;
+        list.next = &list;
+
+        while (due.next != &due) {
+            Timer *timer = static_cast<Timer *>(due.next);
+            unlink(timer);
+            if (timer->expiry <= target) {
+                timer->wheel = nullptr;
+                activeTimers--;
+                timer->callback();
+            } else {
+                linkTail(list, timer);     // 后面某一圈才到期
+            }
+        }
+    }
+
+    if (activeTimers == 0) {
+        tickTimer.stop();
+    }
+}
+
+void TimerWheel::linkTail(Node &list, Node *node)
+{
+    node->prev = list.prev;
+    node->next = &list;
+    list.prev->next = node;
+    list.prev = node;
+}
+
+void TimerWheel::unlink(Node *node)
+{
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = nullptr;
+    node->next = nullptr;
+}
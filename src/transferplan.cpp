@@ -0,0 +1,259 @@
+#include "inc/transferplan.h"
+#include "inc/crc16.h"
+#include "inc/lz4.h"
+#include <QCryptographicHash>
+#include <QScopedPointer>
+#include <cstring>
+
+namespace {
+constexpr qint64 CANCEL_CHECK_INTERVAL = 256;   // 每计算这么多包检查一次是否取消
+}
+
+TransferPlan::TransferPlan()
+    : m_deltaBytes(0)
+    , m_compressedBytes(0)
+    , m_deltaCompressedBytes(0)
+    , m_compressed(false)
+    , m_compressedMode(false)
+    , m_baselineSize(-1)
+    , m_baselineCRC(0)
+    , m_deltaMode(false)
+    , m_dataType(BootLoaderProtocol::MessageType::FPGA_DATA)
+    , m_fileCRC(0)
+    , m_slaveId(0)
+    , m_extended(false)
+    , m_packetSize(0)
+    , m_packetCount(0)
+{
+}
+
+TransferPlan TransferPlan::build(quint8 slaveId, BootLoaderProtocol::MessageType dataType,
+                                 QSharedPointer<const FirmwareImage> image, int packetSize,
+                                 bool extended, QSharedPointer<const FirmwareImage> baseline,
+                                 bool compress, const std::function<bool()> &isCanceled)
+{
+    TransferPlan plan;
+    if (!image || image->size() == 0 || packetSize <= 0) {
+        return plan;
+    }
+
+    // 在当前（工作）线程独立打开一个读取器
+    FirmwareImage::Reader reader(*image);
+    if (!reader.isValid()) {
+        return plan;
+    }
+
+    // 基线用独立的读取器，与新镜像交替读取互不影响映射窗口
+    QScopedPointer<FirmwareImage::Reader> baselineReader;
+    if (baseline) {
+        baselineReader.reset(new FirmwareImage::Reader(*baseline));
+        if (!baselineReader->isValid()) {
+            return plan;
+        }
+    }
+    const qint64 baselineSize = baseline ? baseline->size() : 0;
+
+    const qint64 packetCount = (image->size() + packetSize - 1) / packetSize;
+    QVector<quint16> frameCRCs(static_cast<qsizetype>(packetCount));
+
+    plan.m_image = image;
+    plan.m_dataType = dataType;
+    plan.m_slaveId = slaveId;
+    plan.m_extended = extended;
+    plan.m_packetSize = packetSize;
+    plan.m_packetCount = packetCount;
+
+    // 压缩报文的原始长度字段只有2字节
+    compress = compress && packetSize <= 0xFFFF;
+    plan.m_compressed = compress;
+    QByteArray scratch;
+    if (compress) {
+        scratch.resize(packetSize);
+        plan.m_compressedOffsets.reserve(static_cast<qsizetype>(packetCount + 1));
+        plan.m_compressedOffsets.append(0);
+        plan.m_compressedCRCs.reserve(static_cast<qsizetype>(packetCount));
+    }
+
+    quint16 fileCRC = Crc16::INIT;
+    quint16 baselineCRC = Crc16::INIT;
+    QCryptographicHash digest(QCryptographicHash::Sha256);
+    char header[BootLoaderProtocol::FRAME_OVERHEAD + BootLoaderProtocol::COMPRESSED_DATA_FIELDS];
+    for (qint64 i = 0; i < packetCount; ++i) {
+        if (isCanceled && i % CANCEL_CHECK_INTERVAL == 0 && isCanceled()) {
+            return TransferPlan();
+        }
+
+        const qsizetype length = plan.dataSize(i);
+        const qsizetype headerSize = BootLoaderProtocol::encodeUpgradeDataHeader(
+            header, slaveId, dataType, static_cast<quint32>(i + 1), length, extended);
+
+        // 报文CRC = 帧头部分 + 数据段，增量计算
+        const QByteArrayView data = reader.read(i * packetSize, length);
+        if (data.size() != length) {
+            return TransferPlan();
+        }
+        quint16 crc = Crc16::update(Crc16::INIT, header, headerSize);
+        crc = Crc16::update(crc, data.data(), data.size());
+        frameCRCs[static_cast<qsizetype>(i)] = crc;
+
+        fileCRC = Crc16::update(fileCRC, data.data(), data.size());
+        digest.addData(data);
+
+        // 容量比原始长度少1字节，压缩后不变小的块直接得到0，按原始内容发送
+        QByteArrayView wire = data;
+        if (compress) {
+            const qsizetype packed = Lz4::compress(data.data(), length, scratch.data(), length - 1);
+            if (packed > 0) {
+                wire = QByteArrayView(scratch.constData(), packed);
+                plan.m_compressedData.append(wire);
+            }
+            plan.m_compressedOffsets.append(plan.m_compressedData.size());
+
+            const qsizetype compressedHeaderSize = BootLoaderProtocol::encodeCompressedDataHeader(
+                header, slaveId, static_cast<quint32>(i + 1), static_cast<quint32>(i),
+                static_cast<quint16>(length), wire.size());
+            quint16 compressedCRC = Crc16::update(Crc16::INIT, header, compressedHeaderSize);
+            compressedCRC = Crc16::update(compressedCRC, wire.data(), wire.size());
+            plan.m_compressedCRCs.append(compressedCRC);
+            plan.m_compressedBytes += static_cast<quint64>(wire.size());
+        }
+
+        if (baselineReader) {
+            // 与基线同一位置的块逐字节比较，基线较短时超出部分都算变化
+            const qint64 offset = i * packetSize;
+            const qsizetype baseLength = static_cast<qsizetype>(qBound<qint64>(0, baselineSize - offset, packetSize));
+            bool changed = baseLength != length;
+            if (baseLength > 0) {
+                const QByteArrayView base = baselineReader->read(offset, baseLength);
+                if (base.size() != baseLength) {
+                    return TransferPlan();
+                }
+                baselineCRC = Crc16::update(baselineCRC, base.data(), base.size());
+                if (!changed) {
+                    changed = std::memcmp(base.data(), data.data(), static_cast<size_t>(length)) != 0;
+                }
+            }
+
+            if (changed) {
+                const quint32 deltaNum = static_cast<quint32>(plan.m_deltaBlocks.size() + 1);
+                const qsizetype deltaHeaderSize = BootLoaderProtocol::encodeDeltaDataHeader(
+                    header, slaveId, deltaNum, static_cast<quint32>(i), length);
+                quint16 deltaCRC = Crc16::update(Crc16::INIT, header, deltaHeaderSize);
+                deltaCRC = Crc16::update(deltaCRC, data.data(), data.size());
+                plan.m_deltaBlocks.append(static_cast<quint32>(i));
+                plan.m_deltaCRCs.append(deltaCRC);
+                plan.m_deltaBytes += static_cast<quint64>(length);
+
+                if (compress) {
+                    const qsizetype compressedHeaderSize = BootLoaderProtocol::encodeCompressedDataHeader(
+                        header, slaveId, deltaNum, static_cast<quint32>(i),
+                        static_cast<quint16>(length), wire.size());
+                    quint16 compressedCRC = Crc16::update(Crc16::INIT, header, compressedHeaderSize);
+                    compressedCRC = Crc16::update(compressedCRC, wire.data(), wire.size());
+                    plan.m_deltaCompressedCRCs.append(compressedCRC);
+                    plan.m_deltaCompressedBytes += static_cast<quint64>(wire.size());
+                }
+            }
+        }
+    }
+
+    // 基线比新镜像长时，剩余部分只计入基线CRC
+    if (baselineReader) {
+        for (qint64 offset = packetCount * packetSize; offset < baselineSize; offset += packetSize) {
+            if (isCanceled && isCanceled()) {
+                return TransferPlan();
+            }
+            const qsizetype length = static_cast<qsizetype>(qMin<qint64>(packetSize, baselineSize - offset));
+            const QByteArrayView base = baselineReader->read(offset, length);
+            if (base.size() != length) {
+                return TransferPlan();
+            }
+            baselineCRC = Crc16::update(baselineCRC, base.data(), base.size());
+        }
+        plan.m_baselineSize = baselineSize;
+        plan.m_baselineCRC = baselineCRC;
+    }
+
+    plan.m_compressedData.squeeze();
+    plan.m_frameCRCs = std::move(frameCRCs);
+    plan.m_fileCRC = fileCRC;
+    plan.m_digest = digest.result();
+    return plan;
+}
+
+qsizetype TransferPlan::blockSize(qint64 block) const
+{
+    if (block < 0 || block >= m_packetCount) {
+        return 0;
+    }
+    const qint64 offset = block * m_packetSize;
+    return static_cast<qsizetype>(qMin<qint64>(m_packetSize, m_image->size() - offset));
+}
+
+qsizetype TransferPlan::dataSize(qint64 index) const
+{
+    if (!m_deltaMode) {
+        return blockSize(index);
+    }
+    if (index < 0 || index >= m_deltaBlocks.size()) {
+        return 0;
+    }
+    return blockSize(m_deltaBlocks[static_cast<qsizetype>(index)]);
+}
+
+qsizetype TransferPlan::wireSize(qint64 index) const
+{
+    if (!m_compressedMode || index < 0 || index >= packetCount()) {
+        return dataSize(index);
+    }
+    const qint64 block = blockAt(index);
+    const qsizetype packed = compressedSize(block);
+    return packed > 0 ? packed : blockSize(block);
+}
+
+qsizetype TransferPlan::assemble(qint64 index, FirmwareImage::Reader &reader, char *out) const
+{
+    if (index < 0 || index >= packetCount()) {
+        return 0;
+    }
+
+    // 差分模式下第 index 包是第 m_deltaBlocks[index] 块
+    const qint64 block = blockAt(index);
+    const qsizetype length = blockSize(block);
+    const qsizetype packed = m_compressedMode ? compressedSize(block) : 0;
+
+    // 压缩过的块从计划中取，其余从镜像读取
+    const QByteArrayView data = packed > 0
+        ? QByteArrayView(m_compressedData.constData() + m_compressedOffsets[block], packed)
+        : reader.read(block * m_packetSize, length);
+    if (data.size() != (packed > 0 ? packed : length)) {
+        return 0;
+    }
+
+    // 包序号从1开始
+    qsizetype pos;
+    if (m_compressedMode) {
+        pos = BootLoaderProtocol::encodeCompressedDataHeader(out, m_slaveId, static_cast<quint32>(index + 1),
+                                                             static_cast<quint32>(block),
+                                                             static_cast<quint16>(length), data.size());
+    } else if (m_deltaMode) {
+        pos = BootLoaderProtocol::encodeDeltaDataHeader(out, m_slaveId, static_cast<quint32>(index + 1),
+                                                        static_cast<quint32>(block), length);
+    } else {
+        pos = BootLoaderProtocol::encodeUpgradeDataHeader(out, m_slaveId, m_dataType,
+                                                          static_cast<quint32>(index + 1), length, m_extended);
+    }
+
+    std::memcpy(out + pos, data.data(), static_cast<size_t>(data.size()));
+    pos += data.size();
+
+    // CRC（低位在前，高位在后）
+    const QVector<quint16> &crcs = m_compressedMode ? (m_deltaMode ? m_deltaCompressedCRCs : m_compressedCRCs)
+                                 : m_deltaMode ? m_deltaCRCs
+                                               : m_frameCRCs;
+    const quint16 crc = crcs[static_cast<qsizetype>(index)];
+    out[pos++] = static_cast<char>(crc & 0xFF);
+    out[pos++] = static_cast<char>((crc >> 8) & 0xFF);
+
+    return pos;
+}
@@ -1,28 +1,314 @@
 #include "inc/upgrade.h"
-#include "inc/mainwindow.h"
+#include <QCryptographicHash>
+#include <QDir>
 #include <QFile>
-#include <QMessageBox>
+#include <QFileInfo>
+#include <QPromise>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentRun>
 #include <limits>
 
-UpgradeManager::UpgradeManager(MainWindow *parent)
+namespace {
+constexpr int MAX_WINDOW_SIZE = 64;          // 滑动窗口上限
+constexpr int FAST_RETRANSMIT_THRESHOLD = 3; // 越序应答达到该次数后立即重传缺失包
+
+// 各阶段超时预算(ms)
+constexpr int CONTROL_TIMEOUT_MS = 15000;     // 升级请求/总体结束
+constexpr int RESET_TIMEOUT_MS = 15000;       // 系统复位（含重启进入BootLoader）
+constexpr int ERASE_BASE_TIMEOUT_MS = 5000;   // 擦除Flash基础时间
+constexpr int ERASE_MS_PER_MB = 20000;        // 擦除Flash按镜像大小追加的时间
+constexpr int END_BASE_TIMEOUT_MS = 5000;     // 升级结束（整体校验/FPGA配置）基础时间
+constexpr int END_MS_PER_MB = 10000;          // 升级结束按镜像大小追加的时间
+constexpr int MAX_PHASE_TIMEOUT_MS = 120000;  // 任意阶段的超时上限
+
+// 数据包超时（自适应）
+constexpr int DATA_INITIAL_TIMEOUT_MS = 3000; // 尚无RTT样本时的超时
+constexpr int DATA_MIN_TIMEOUT_MS = 20;
+constexpr int DATA_MAX_TIMEOUT_MS = 15000;
+
+constexpr int MAX_PACKET_SIZE = 4096;         // 界面可设置的最大分包大小
+
+constexpr int PROGRESS_INTERVAL_MS = 100;     // 进度采样间隔
+constexpr int CHECKPOINT_INTERVAL_MS = 1000;  // 数据传输中写入断点记录的最小间隔
+constexpr double RATE_SMOOTHING = 0.3;        // 吞吐指数平滑系数（新样本权重）
+constexpr qint64 BASELINE_CHUNK_SIZE = 1 << 20; // 保存基线时每次读取的长度
+
+constexpr int MAX_RETRIES = 3;
+constexpr int MAX_DATA_RETRIES = 6;           // 数据包超时很短，允许更多次指数退避重传
+
+// FPGA固定使用1024字节分包，其他设备使用界面设置值
+int packetSizeForDevice(UpgradeManager::DeviceType device, int packetSize)
+{
+    return device == UpgradeManager::DeviceType::FPGA ? 1024 : packetSize;
+}
+
+// 超出16位包序号或32位文件大小时需要扩展寻址
+bool needsExtendedAddressing(quint64 fileSize, int packetSize)
+{
+    const quint64 packetCount = (fileSize + packetSize - 1) / packetSize;
+    return packetCount > BootLoaderProtocol::MAX_PACKET_COUNT ||
+           fileSize > BootLoaderProtocol::MAX_FILE_SIZE;
+}
+
+// 累计确认的包数对应的字节数（最后一包可能不满）
+quint64 ackedBytes(const UpgradeManager::FirmwareInfo &fw)
+{
+    return qMin<quint64>(static_cast<quint64>(fw.currentPacket) * fw.packetSize, fw.transferSize);
+}
+
+// 已结束但没有得到可用计划（被取消或读取失败），不能再复用，下次重新准备
+bool planFailed(const QFuture<TransferPlan> &future)
+{
+    if (future.isCanceled()) {
+        return true;
+    }
+    return future.isFinished() && (future.resultCount() == 0 || future.result().isEmpty());
+}
+
+int scaledBudget(int baseMs, int msPerMB, quint64 bytes)
+{
+    const quint64 megabytes = qMin<quint64>(bytes / (1024 * 1024), MAX_PHASE_TIMEOUT_MS);
+    const qint64 budget = baseMs + static_cast<qint64>(megabytes) * msPerMB;
+    return static_cast<int>(qMin<qint64>(budget, MAX_PHASE_TIMEOUT_MS));
+}
+
+// 把镜像写为基线，SHA-256 与 expected 一致才替换；返回失败原因，成功时为空
+QString writeBaseline(const FirmwareImage &image, const QByteArray &expected, const QString &target)
+{
+    FirmwareImage::Reader reader(image);
+    if (!reader.isValid()) {
+        return UpgradeManager::tr("无法读取固件：%1").arg(reader.errorString());
+    }
+
+    QDir().mkpath(QFileInfo(target).absolutePath());
+    QSaveFile file(target);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return UpgradeManager::tr("无法写入 %1：%2").arg(target, file.errorString());
+    }
+
+    QCryptographicHash digest(QCryptographicHash::Sha256);
+    for (qint64 offset = 0; offset < image.size(); offset += BASELINE_CHUNK_SIZE) {
+        const qsizetype length = static_cast<qsizetype>(qMin<qint64>(BASELINE_CHUNK_SIZE, image.size() - offset));
+        const QByteArrayView data = reader.read(offset, length);
+        if (data.size() != length) {
+            file.cancelWriting();
+            return UpgradeManager::tr("读取固件失败");
+        }
+        if (file.write(data.data(), length) != length) {
+            file.cancelWriting();
+            return UpgradeManager::tr("写入 %1 失败：%2").arg(target, file.errorString());
+        }
+        digest.addData(data);
+    }
+
+    if (digest.result() != expected) {
+        file.cancelWriting();
+        return UpgradeManager::tr("固件文件在升级期间被修改");
+    }
+    if (!file.commit()) {
+        return UpgradeManager::tr("写入 %1 失败：%2").arg(target, file.errorString());
+    }
+    return QString();
+}
+}
+
+QString UpgradeManager::deviceName(DeviceType device)
+{
+    switch (device) {
+        case DeviceType::FPGA: return QStringLiteral("FPGA");
+        case DeviceType::DSP1: return QStringLiteral("DSP1");
+        case DeviceType::DSP2: return QStringLiteral("DSP2");
+        case DeviceType::ARM: return QStringLiteral("ARM");
+    }
+    return QString();
+}
+
+BootLoaderProtocol::MessageType UpgradeManager::commandType(DeviceType device)
+{
+    switch (device) {
+        case DeviceType::FPGA: return BootLoaderProtocol::MessageType::FPGA_COMMAND;
+        case DeviceType::DSP1: return BootLoaderProtocol::MessageType::DSP1_COMMAND;
+        case DeviceType::DSP2: return BootLoaderProtocol::MessageType::DSP2_COMMAND;
+        case DeviceType::ARM: return BootLoaderProtocol::MessageType::ARM_COMMAND;
+    }
+    return BootLoaderProtocol::MessageType::FPGA_COMMAND;
+}
+
+BootLoaderProtocol::MessageType UpgradeManager::dataType(DeviceType device)
+{
+    switch (device) {
+        case DeviceType::FPGA: return BootLoaderProtocol::MessageType::FPGA_DATA;
+        case DeviceType::DSP1: return BootLoaderProtocol::MessageType::DSP1_DATA;
+        case DeviceType::DSP2: return BootLoaderProtocol::MessageType::DSP2_DATA;
+        case DeviceType::ARM: return BootLoaderProtocol::MessageType::ARM_DATA;
+    }
+    return BootLoaderProtocol::MessageType::FPGA_DATA;
+}
+
+BootLoaderProtocol::MessageType UpgradeManager::endType(DeviceType device)
+{
+    switch (device) {
+        case DeviceType::FPGA: return BootLoaderProtocol::MessageType::FPGA_END;
+        case DeviceType::DSP1: return BootLoaderProtocol::MessageType::DSP1_END;
+        case DeviceType::DSP2: return BootLoaderProtocol::MessageType::DSP2_END;
+        case DeviceType::ARM: return BootLoaderProtocol::MessageType::ARM_END;
+    }
+    return BootLoaderProtocol::MessageType::FPGA_END;
+}
+
+/**
+ * @brief 加入一个RTT样本
+ */
+void UpgradeManager::RttEstimator::addSample(qint64 rttMs)
+{
+    const double sample = static_cast<double>(qMax<qint64>(rttMs, 0));
+    if (!hasSample) {
+        srtt = sample;
+        rttvar = sample / 2.0;
+        hasSample = true;
+    } else {
+        rttvar = 0.75 * rttvar + 0.25 * qAbs(srtt - sample);
+        srtt = 0.875 * srtt + 0.125 * sample;
+    }
+}
+
+/**
+ * @brief 当前数据包超时 RTO = SRTT + 4 * RTTVAR
+ */
+int UpgradeManager::RttEstimator::timeout() const
+{
+    if (!hasSample) {
+        return DATA_INITIAL_TIMEOUT_MS;
+    }
+    const int rto = static_cast<int>(srtt + 4.0 * rttvar + 0.5);
+    return qBound(DATA_MIN_TIMEOUT_MS, rto, DATA_MAX_TIMEOUT_MS);
+}
+
+UpgradeManager::UpgradeManager(QObject *parent)
     : QObject(parent)
-    , mainWindow(parent)
     , upgradeState(UpgradeState::IDLE)
     , currentFirmwareIndex(-1)
     , slaveId(0)
     , retryCount(0)
-    , upgradeTimer(new QTimer(this))
+    , upgradeTimer([this]() { onTimeout(); })
+    , extendedAddressing(false)
     , totalPackets(0)
     , sentPackets(0)
+    , totalBytes(0)
+    , completedBytes(0)
+    , lastProgressTime(0)
+    , rateSampleTime(0)
+    , rateSampleBytes(0)
+    , rateSamplePackets(0)
+    , bytesRate(0.0)
+    , packetRate(0.0)
+    , currentPhase(UpgradeTelemetry::Phase::Request)
+    , phaseDevice(-1)
+    , phaseStartUs(0)
+    , phaseActive(false)
+    , transferWindow(1)
+    , activeWindow(1)
+    , lastCheckpointTime(0)
+    , journalError(false)
+    , deltaSupported(false)
+    , compressFirmware(true)
+    , compressionSupported(false)
 {
-    // 设置15秒超时
-    upgradeTimer->setInterval(15000);
-    connect(upgradeTimer, &QTimer::timeout, this, &UpgradeManager::onTimeout);
+    txBuffer.reserve(BootLoaderProtocol::frameSize(BootLoaderProtocol::COMPRESSED_DATA_FIELDS + MAX_PACKET_SIZE));
 }
 
 UpgradeManager::~UpgradeManager()
 {
     stopUpgrade();
+
+    for (PreparedFirmware &prepared : preparedFirmware) {
+        prepared.planFuture.cancel();
+    }
+
+    // 基线写入只做有限的磁盘拷贝，等待完成，不留下半途而废的基线
+    for (QFuture<void> &writer : baselineWriters) {
+        writer.waitForFinished();
+    }
+}
+
+/**
+ * @brief 设置滑动窗口大小
+ */
+void UpgradeManager::setWindowSize(int size)
+{
+    transferWindow = qBound(1, size, MAX_WINDOW_SIZE);
+}
+
+/**
+ * @brief 在线程池中读取镜像，计算文件CRC和全部数据包报文的CRC
+ *
+ * 有基线时同一遍读取中逐块与基线比较，得到差分升级需要传输的块；要求压缩时同时逐块压缩，
+ * 多个镜像的计算在线程池中并行进行。
+ */
+QFuture<TransferPlan> UpgradeManager::startTransferPlan(DeviceType device, const QSharedPointer<FirmwareImage> &image,
+                                                        quint8 slaveId, int packetSize, bool extended,
+                                                        const QSharedPointer<FirmwareImage> &baseline, bool compress)
+{
+    const BootLoaderProtocol::MessageType type = dataType(device);
+
+    const QSharedPointer<const FirmwareImage> source = image;
+    const QSharedPointer<const FirmwareImage> reference = baseline;
+    return QtConcurrent::run([slaveId, type, source, packetSize, extended, reference, compress](QPromise<TransferPlan> &promise) {
+        promise.addResult(TransferPlan::build(slaveId, type, source, packetSize, extended, reference, compress,
+                                              [&promise]() { return promise.isCanceled(); }));
+    });
+}
+
+/**
+ * @brief 选择固件文件后在后台准备
+ */
+void UpgradeManager::preloadFirmware(DeviceType device, const QString &path, quint8 slaveId, int packetSize)
+{
+    // 重新选择后旧的准备结果作废；升级中该设备仍在使用时只从缓存移除，不取消计算
+    auto existing = preparedFirmware.find(device);
+    if (existing != preparedFirmware.end()) {
+        if (!planInUse(device)) {
+            existing->planFuture.cancel();
+        }
+        preparedFirmware.erase(existing);
+    }
+
+    // 参数无效时不预先准备，启动升级时再报告错误
+    if (path.isEmpty() || packetSize <= 0 || packetSize > MAX_PACKET_SIZE) {
+        return;
+    }
+
+    QString errorString;
+    const QSharedPointer<FirmwareImage> image = FirmwareImage::open(path, &errorString);
+    if (!image) {
+        emit showInfo(tr(">>> 错误：无法打开固件文件：%1").arg(errorString));
+        return;
+    }
+    if (image->size() == 0) {
+        return;
+    }
+
+    const int imagePacketSize = packetSizeForDevice(device, packetSize);
+
+    PreparedFirmware prepared;
+    prepared.image = image;
+    prepared.lastModified = QFileInfo(path).lastModified();
+    prepared.slaveId = slaveId;
+    prepared.packetSize = imagePacketSize;
+    prepared.extended = needsExtendedAddressing(static_cast<quint64>(image->size()), imagePacketSize);
+    prepared.baselinePath = baselinePathFor(device);
+    prepared.compress = compressFirmware;
+
+    // 基线不存在或无法打开时只做完整升级
+    QSharedPointer<FirmwareImage> baseline;
+    if (!prepared.baselinePath.isEmpty() && QFileInfo::exists(prepared.baselinePath)) {
+        prepared.baselineModified = QFileInfo(prepared.baselinePath).lastModified();
+        baseline = FirmwareImage::open(prepared.baselinePath);
+    }
+
+    prepared.planFuture = startTransferPlan(device, image, slaveId, imagePacketSize, prepared.extended, baseline,
+                                            prepared.compress);
+    preparedFirmware.insert(device, prepared);
 }
 
 /**
@@ -35,19 +321,54 @@ bool UpgradeManager::startUpgrade(quint8 slaveId, int packetSize, bool upgradeFP
         return false;
     }
 
+    // 保存从机ID（传输计划按从机ID编码）
+    this->slaveId = slaveId;
+
     // 准备固件文件
     if (!prepareFirmware(packetSize, upgradeFPGA, upgradeDSP1, upgradeDSP2, upgradeARM,
                         fpgaPath, dsp1Path, dsp2Path, armPath)) {
         return false;
     }
 
-    // 保存从机ID
-    this->slaveId = slaveId;
     currentFirmwareIndex = -1;
+    dataRtt = RttEstimator();
+    rttClock.start();
+    bytesRate = 0.0;
+    packetRate = 0.0;
+    deltaSupported = false;
+    compressionSupported = false;
+    activeWindow = 1;
+
+    telemetry.startTime = QDateTime::currentMSecsSinceEpoch();
+    telemetry.packetSize = packetSize;
+    telemetry.windowSize = activeWindow;
+    telemetry.extended = extendedAddressing;
 
     emit showInfo(tr("========================================"));
     emit showInfo(tr(">>> 开始升级流程"));
 
+    // 同一组固件留有未完成的断点记录时请求续传
+    resumeJournal = UpgradeJournal();
+    lastCheckpointTime = 0;
+    journalError = false;
+    if (!journalFile.isEmpty()) {
+        // 上次升级最后一次写入可能仍在进行，其失败已与本次无关
+        journalWriter.flush();
+        journalWriter.takeError();
+        const UpgradeJournal journal = UpgradeJournal::load(journalFile);
+        if (journalMatches(journal)) {
+            resumeJournal = journal;
+            if (journal.deviceIndex < firmwareList.size()) {
+                emit showInfo(tr(">>> 发现未完成的升级记录：%1 已确认 %2/%3 包，请求断点续传")
+                                  .arg(journal.images[journal.deviceIndex].device)
+                                  .arg(journal.ackedPackets)
+                                  .arg(journal.images[journal.deviceIndex].packetCount));
+            } else {
+                emit showInfo(tr(">>> 发现未完成的升级记录：全部设备已完成，请求断点续传"));
+            }
+        }
+    }
+
     // 发送升级请求
     sendUpgradeRequest();
 
@@ -62,8 +383,12 @@ bool UpgradeManager::prepareFirmware(int packetSize, bool upgradeFPGA, bool upgr
     firmwareList.clear();
     totalPackets = 0;
     sentPackets = 0;
+    totalBytes = 0;
+    completedBytes = 0;
+    telemetry = UpgradeTelemetry();
+    extendedAddressing = false;
 
-    if (packetSize <= 0 || packetSize > 4096) {
+    if (packetSize <= 0 || packetSize > MAX_PACKET_SIZE) {
         emit showInfo(tr(">>> 错误：数据包大小无效！"));
         return false;
     }
@@ -93,50 +418,60 @@ bool UpgradeManager::prepareFirmware(int packetSize, bool upgradeFPGA, bool upgr
             return false;
         }
 
-        QFile file(dev.path);
-        if (!file.open(QIODevice::ReadOnly)) {
-            emit showInfo(tr(">>> 错误：无法打开 %1 固件文件：%2").arg(dev.name, file.errorString()));
+        QString errorString;
+        const QSharedPointer<FirmwareImage> image = FirmwareImage::open(dev.path, &errorString);
+        if (!image) {
+            emit showInfo(tr(">>> 错误：无法打开 %1 固件文件：%2").arg(dev.name, errorString));
             return false;
         }
 
         FirmwareInfo info;
         info.filePath = dev.path;
-        info.fileData = file.readAll();
-        info.fileSize = info.fileData.size();
+        info.image = image;
+        info.fileSize = static_cast<quint64>(image->size());
+        info.transferSize = info.fileSize;
         info.deviceType = dev.type;
+        info.fileCRC = 0;
         info.currentPacket = 0;
+        info.nextPacket = 0;
+        info.gapAckCount = 0;
 
         if (info.fileSize == 0) {
             emit showInfo(tr(">>> 错误：%1 固件文件为空！").arg(dev.name));
             return false;
         }
 
-        // FPGA固定使用1024字节分包，其他设备使用界面设置值
-        int actualPacketSize = (dev.type == DeviceType::FPGA) ? 1024 : packetSize;
+        const int actualPacketSize = packetSizeForDevice(dev.type, packetSize);
         info.packetSize = static_cast<quint16>(actualPacketSize);
 
-        // 计算数据包总数
-        const quint32 computedPacketCount = (info.fileSize + actualPacketSize - 1) / actualPacketSize;
-        if (computedPacketCount == 0 ||
-            computedPacketCount > std::numeric_limits<quint16>::max()) {
+        // 计算数据包总数，超过16位包序号时需要扩展寻址
+        const quint64 computedPacketCount = (info.fileSize + actualPacketSize - 1) / actualPacketSize;
+        if (computedPacketCount > BootLoaderProtocol::MAX_EXTENDED_PACKET_COUNT) {
             emit showInfo(tr(">>> 错误：%1 固件需要的数据包数量超出协议限制！").arg(dev.name));
             return false;
         }
-        info.packetCount = static_cast<quint16>(computedPacketCount);
+        info.packetCount = static_cast<quint32>(computedPacketCount);
 
-        // 计算文件CRC16
-        info.fileCRC = BootLoaderProtocol::calculateCRC16(info.fileData);
-
-        file.close();
+        if (needsExtendedAddressing(info.fileSize, actualPacketSize)) {
+            extendedAddressing = true;
+        }
 
         firmwareList.append(info);
         totalPackets += info.packetCount;
+        totalBytes += info.fileSize;
+
+        UpgradeTelemetry::Device deviceStats;
+        deviceStats.name = dev.name;
+        deviceStats.fileSize = info.fileSize;
+        deviceStats.packetCount = info.packetCount;
+        deviceStats.packetSize = info.packetSize;
+        deviceStats.transferBytes = info.fileSize;
+        telemetry.devices.append(deviceStats);
 
-        emit showInfo(tr("加载 %1 固件: %2 字节, %3 包, CRC16=0x%4")
+        emit showInfo(tr("加载 %1 固件: %2 字节, %3 包")
             .arg(dev.name)
             .arg(info.fileSize)
-            .arg(info.packetCount)
-            .arg(info.fileCRC, 4, 16, QLatin1Char('0')));
+            .arg(info.packetCount));
     }
 
     if (firmwareList.isEmpty()) {
@@ -144,6 +479,53 @@ bool UpgradeManager::prepareFirmware(int packetSize, bool upgradeFPGA, bool upgr
         return false;
     }
 
+    if (extendedAddressing) {
+        emit showInfo(tr(">>> 固件超出16位包序号范围，使用扩展寻址"));
+    }
+
+    // 优先使用选择文件时已在后台准备好的结果；文件、基线或参数变化后重新准备，
+    // 各镜像在线程池中并行计算，等待设备允许升级和复位期间即可完成
+    for (FirmwareInfo &info : firmwareList) {
+        const QString baselinePath = baselinePathFor(info.deviceType);
+        auto prepared = preparedFirmware.find(info.deviceType);
+        const bool reusable = prepared != preparedFirmware.end() &&
+                              prepared->image->filePath() == info.filePath &&
+                              prepared->image->size() == info.image->size() &&
+                              prepared->lastModified == QFileInfo(info.filePath).lastModified() &&
+                              prepared->slaveId == slaveId &&
+                              prepared->packetSize == info.packetSize &&
+                              prepared->extended == extendedAddressing &&
+                              prepared->baselinePath == baselinePath &&
+                              prepared->baselineModified == QFileInfo(baselinePath).lastModified() &&
+                              prepared->compress == compressFirmware &&
+                              !planFailed(prepared->planFuture);
+        if (!reusable) {
+            preloadFirmware(info.deviceType, info.filePath, slaveId, packetSize);
+            prepared = preparedFirmware.find(info.deviceType);
+
+            // 其他镜像需要扩展寻址时，本镜像也按扩展格式重新准备
+            if (prepared != preparedFirmware.end() && prepared->extended != extendedAddressing) {
+                prepared->planFuture.cancel();
+                prepared->extended = extendedAddressing;
+                QSharedPointer<FirmwareImage> baseline;
+                if (prepared->baselineModified.isValid()) {
+                    baseline = FirmwareImage::open(prepared->baselinePath);
+                }
+                prepared->planFuture = startTransferPlan(info.deviceType, prepared->image, slaveId,
+                                                         info.packetSize, extendedAddressing, baseline,
+                                                         prepared->compress);
+            }
+        }
+
+        if (prepared == preparedFirmware.end()) {
+            emit showInfo(tr(">>> 错误：无法打开固件文件：%1").arg(info.filePath));
+            return false;
+        }
+
+        info.image = prepared->image;
+        info.planFuture = prepared->planFuture;
+    }
+
     return true;
 }
 
@@ -153,6 +535,7 @@ bool UpgradeManager::prepareFirmware(int packetSize, bool upgradeFPGA, bool upgr
 void UpgradeManager::sendUpgradeRequest()
 {
     upgradeState = UpgradeState::WAIT_UPGRADE_REQUEST;
+    enterPhase(UpgradeTelemetry::Phase::Request);
 
     BootLoaderProtocol::UpgradeFlags flags;
     for (const auto &fw : firmwareList) {
@@ -163,11 +546,13 @@ void UpgradeManager::sendUpgradeRequest()
             case DeviceType::ARM: flags.arm = true; break;
         }
     }
+    flags.resume = resumeJournal.isValid();
+    flags.extended = extendedAddressing;
 
     QByteArray request = protocol.buildUpgradeRequest(slaveId, flags);
     emit sendData(request, tr("发送升级请求"));
 
-    upgradeTimer->start();
+    armTimer();
 }
 
 /**
@@ -176,11 +561,37 @@ void UpgradeManager::sendUpgradeRequest()
 void UpgradeManager::sendSystemReset()
 {
     upgradeState = UpgradeState::WAIT_SYSTEM_RESET;
+    enterPhase(UpgradeTelemetry::Phase::Reset);
 
     QByteArray reset = protocol.buildSystemReset(slaveId);
     emit sendData(reset, tr("发送系统复位命令"));
 
-    upgradeTimer->start();
+    armTimer();
+}
+
+/**
+ * @brief 发送断点续传报文，请求下位机从断点记录的位置继续接收当前设备的数据
+ */
+void UpgradeManager::sendResume()
+{
+    if (currentFirmwareIndex < 0 || currentFirmwareIndex >= firmwareList.size()) {
+        upgradeComplete(false, tr("内部错误：固件索引无效"));
+        return;
+    }
+
+    upgradeState = UpgradeState::WAIT_RESUME;
+    enterPhase(UpgradeTelemetry::Phase::Erase);
+
+    FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
+    if (!resolveTransferPlan(fw)) {
+        return;
+    }
+
+    QByteArray resume = protocol.buildResume(slaveId, commandType(fw.deviceType), fw.fileSize,
+                                             fw.packetCount, fw.fileCRC, resumeJournal.ackedPackets);
+    emit sendData(resume, tr("发送断点续传"));
+
+    armTimer();
 }
 
 /**
@@ -213,17 +624,20 @@ void UpgradeManager::startDeviceUpgrade(DeviceType device)
         return;
     }
 
-    QString deviceName;
-    switch (device) {
-        case DeviceType::FPGA: deviceName = "FPGA"; break;
-        case DeviceType::DSP1: deviceName = "DSP1"; break;
-        case DeviceType::DSP2: deviceName = "DSP2"; break;
-        case DeviceType::ARM: deviceName = "ARM"; break;
-    }
+    emit showInfo(tr(">>> 准备升级 %1").arg(deviceName(device)));
 
-    emit showInfo(tr(">>> 准备升级 %1").arg(deviceName));
+    // 固件列表与升级顺序一致，之前的设备都已完成
+    completedBytes = 0;
+    for (int i = 0; i < currentFirmwareIndex; ++i) {
+        completedBytes += firmwareList[i].transferSize;
+    }
 
-    firmwareList[currentFirmwareIndex].currentPacket = 0;
+    FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
+    fw.currentPacket = 0;
+    fw.nextPacket = 0;
+    fw.gapAckCount = 0;
+    fw.inFlight = QVector<InFlightPacket>(MAX_WINDOW_SIZE);
+    dataReader.reset();
 
     sendUpgradeCommand();
 }
@@ -238,28 +652,111 @@ void UpgradeManager::sendUpgradeCommand()
         return;
     }
 
+    // 超时重发和差分被拒后的重发都处于等待升级指令状态，只在首次发送时选择差分
+    const bool firstAttempt = upgradeState != UpgradeState::WAIT_UPGRADE_COMMAND;
     upgradeState = UpgradeState::WAIT_UPGRADE_COMMAND;
+    enterPhase(UpgradeTelemetry::Phase::Erase);
 
-    const FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
+    FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
+
+    // 升级指令需要文件CRC，取出后台计算好的传输计划
+    if (!resolveTransferPlan(fw)) {
+        return;
+    }
 
-    BootLoaderProtocol::MessageType cmdType = BootLoaderProtocol::MessageType::FPGA_COMMAND;
-    switch (fw.deviceType) {
-        case DeviceType::FPGA: cmdType = BootLoaderProtocol::MessageType::FPGA_COMMAND; break;
-        case DeviceType::DSP1: cmdType = BootLoaderProtocol::MessageType::DSP1_COMMAND; break;
-        case DeviceType::DSP2: cmdType = BootLoaderProtocol::MessageType::DSP2_COMMAND; break;
-        case DeviceType::ARM: cmdType = BootLoaderProtocol::MessageType::ARM_COMMAND; break;
-        default: break;
+    if (firstAttempt && deltaSupported && fw.plan.hasBaseline() &&
+        fw.plan.deltaPacketCount() < fw.plan.blockCount()) {
+        selectDeltaMode(fw, true);
+        emit showInfo(tr(">>> 与基线相比 %1/%2 块有变化，使用差分升级")
+                          .arg(fw.packetCount)
+                          .arg(fw.plan.blockCount()));
     }
 
-    QByteArray command = protocol.buildUpgradeCommand(slaveId, cmdType,
-                                                     fw.fileSize, fw.packetCount, fw.fileCRC);
+    const BootLoaderProtocol::MessageType cmdType = commandType(fw.deviceType);
+
+    if (fw.plan.isDeltaMode()) {
+        QByteArray command = protocol.buildDeltaCommand(slaveId, cmdType, static_cast<quint64>(fw.plan.baselineSize()),
+                                                         fw.plan.baselineCRC(), fw.fileSize, fw.packetCount,
+                                                         fw.fileCRC, fw.packetSize);
+        emit sendData(command, tr("发送差分升级指令"));
+        armTimer();
+        return;
+    }
+
+    QByteArray command = extendedAddressing
+        ? protocol.buildUpgradeCommandExtended(slaveId, cmdType, fw.fileSize, fw.packetCount, fw.fileCRC)
+        : protocol.buildUpgradeCommand(slaveId, cmdType, static_cast<quint32>(fw.fileSize),
+                                       static_cast<quint16>(fw.packetCount), fw.fileCRC);
     emit sendData(command, tr("发送升级指令"));
 
-    upgradeTimer->start();
+    armTimer();
+}
+
+/**
+ * @brief 取出后台计算的传输计划并打开数据读取器
+ * @return 失败时已结束升级
+ */
+bool UpgradeManager::resolveTransferPlan(FirmwareInfo &fw)
+{
+    if (!takeTransferPlan(fw)) {
+        upgradeComplete(false, tr("读取固件文件失败：%1").arg(fw.filePath));
+        return false;
+    }
+
+    if (!dataReader) {
+        dataReader.reset(new FirmwareImage::Reader(*fw.image));
+        if (!dataReader->isValid()) {
+            const QString reason = dataReader->errorString();
+            dataReader.reset();
+            upgradeComplete(false, tr("读取固件文件失败：%1").arg(reason));
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief 正在进行的升级是否还会从该设备的准备结果中取传输计划
+ */
+bool UpgradeManager::planInUse(DeviceType device) const
+{
+    if (upgradeState == UpgradeState::IDLE) {
+        return false;
+    }
+    for (const FirmwareInfo &fw : firmwareList) {
+        if (fw.deviceType == device && fw.plan.isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 等待并取出后台计算的传输计划（不打开读取器）
+ * @return 计划与固件信息不符时返回 false，不结束升级
+ */
+bool UpgradeManager::takeTransferPlan(FirmwareInfo &fw)
+{
+    if (fw.plan.isEmpty()) {
+        // 被取消的计算没有结果，不能取 result()
+        fw.planFuture.waitForFinished();
+        if (fw.planFuture.isCanceled() || fw.planFuture.resultCount() == 0) {
+            return false;
+        }
+        const TransferPlan plan = fw.planFuture.result();
+        if (plan.packetCount() != fw.packetCount || plan.isExtended() != extendedAddressing) {
+            return false;
+        }
+        fw.plan = plan;
+        fw.fileCRC = fw.plan.fileCRC();
+        emit showInfo(tr("固件CRC16=0x%1").arg(fw.fileCRC, 4, 16, QLatin1Char('0')));
+    }
+    return true;
 }
 
 /**
- * @brief 发送升级数据包
+ * @brief 发送升级数据包（填满发送窗口）
  */
 void UpgradeManager::sendUpgradeData()
 {
@@ -269,6 +766,7 @@ void UpgradeManager::sendUpgradeData()
     }
 
     upgradeState = UpgradeState::WAIT_UPGRADE_DATA;
+    enterPhase(UpgradeTelemetry::Phase::Data);
 
     FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
 
@@ -277,33 +775,144 @@ void UpgradeManager::sendUpgradeData()
         return;
     }
 
-    const int packetSize = fw.packetSize;
-    const int offset = fw.currentPacket * packetSize;
-    const int remaining = static_cast<int>(fw.fileSize) - offset;
+    if (!resolveTransferPlan(fw)) {
+        return;
+    }
+
+    // 完整/差分模式已定（差分被拒或断点续传都在此之前），再决定是否压缩
+    if (!fw.plan.isCompressedMode()) {
+        selectCompression(fw);
+    }
+
+    // 擦除等待不计入吞吐，从首包发送开始采样
+    if (fw.nextPacket == 0) {
+        resetRateSample();
+        updateProgress(true);
+    }
 
-    if (remaining <= 0) {
-        upgradeComplete(false, tr("内部错误：数据包偏移无效"));
+    // 停等模式下窗口为1，即只有 currentPacket 在途
+    while (fw.nextPacket < fw.packetCount &&
+           fw.nextPacket - fw.currentPacket < static_cast<quint32>(activeWindow)) {
+        sendDataPacket(fw.nextPacket, false);
+        if (upgradeState != UpgradeState::WAIT_UPGRADE_DATA) {
+            return;
+        }
+        fw.nextPacket++;
+    }
+
+    armTimer();
+}
+
+/**
+ * @brief 发送单个数据包
+ * @param index 数据包索引（从0开始）
+ * @param retransmit 是否为重传
+ */
+void UpgradeManager::sendDataPacket(quint32 index, bool retransmit)
+{
+    FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
+
+    // 组装到复用的发送缓冲区：帧头 + 读取器当前窗口中的数据段 + 预先算好的CRC
+    txBuffer.resize(fw.plan.frameSize(index));
+    if (fw.plan.assemble(index, *dataReader, txBuffer.data()) == 0) {
+        upgradeComplete(false, tr("读取固件文件失败：数据包 %1 偏移无效").arg(index + 1));
         return;
     }
 
-    const int dataSize = qMin(packetSize, remaining);
-    const quint16 packetNum = fw.currentPacket + 1; // 从1开始
+    const quint32 packetNum = index + 1; // 从1开始
+
+    InFlightPacket &slot = fw.inFlight[index % MAX_WINDOW_SIZE];
+    UpgradeTelemetry::Device &stats = telemetry.devices[currentFirmwareIndex];
+    stats.packetsSent++;
+    if (!retransmit) {
+        slot = InFlightPacket();
+        stats.payloadBytes += static_cast<quint64>(fw.plan.dataSize(index));
+        stats.wireBytes += static_cast<quint64>(fw.plan.wireSize(index));
+    } else {
+        slot.retransmitted = true;
+        stats.retransmits++;
+        telemetry.retransmits++;
+    }
+    slot.sendTime = elapsedUs();
 
-    QByteArray packetData = fw.fileData.mid(offset, dataSize);
+    // 首发包描述留空，日志需要时由接收方根据报文内容生成
+    const QString description = retransmit ? tr("重发数据包 %1/%2").arg(packetNum).arg(fw.packetCount) : QString();
+    emit sendData(txBuffer, description);
+}
 
-    BootLoaderProtocol::MessageType dataType = BootLoaderProtocol::MessageType::FPGA_DATA;
-    switch (fw.deviceType) {
-        case DeviceType::FPGA: dataType = BootLoaderProtocol::MessageType::FPGA_DATA; break;
-        case DeviceType::DSP1: dataType = BootLoaderProtocol::MessageType::DSP1_DATA; break;
-        case DeviceType::DSP2: dataType = BootLoaderProtocol::MessageType::DSP2_DATA; break;
-        case DeviceType::ARM: dataType = BootLoaderProtocol::MessageType::ARM_DATA; break;
-        default: break;
+/**
+ * @brief 重传窗口内尚未确认的数据包
+ * @param limit 只重传索引小于该值的数据包
+ */
+void UpgradeManager::retransmitMissingPackets(quint32 limit)
+{
+    FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
+    const quint32 end = qMin(limit, fw.nextPacket);
+
+    for (quint32 i = fw.currentPacket; i < end; ++i) {
+        if (!fw.inFlight[i % MAX_WINDOW_SIZE].acked) {
+            sendDataPacket(i, true);
+            if (upgradeState != UpgradeState::WAIT_UPGRADE_DATA) {
+                return;
+            }
+        }
     }
 
-    QByteArray data = protocol.buildUpgradeData(slaveId, dataType, packetNum, packetData);
-    emit sendData(data, tr("发送数据包 %1/%2").arg(packetNum).arg(fw.packetCount));
+    armTimer();
+}
 
-    upgradeTimer->start();
+/**
+ * @brief 处理数据包应答，推进发送窗口
+ * @param packetNum 应答的包序号（从1开始）
+ * @param receivedCount 下位机已连续接收的包数（累计确认）
+ */
+void UpgradeManager::handleDataAck(FirmwareInfo &fw, quint32 packetNum, quint32 receivedCount)
+{
+    // 窗口下沿之前的包已经滑出窗口，其状态槽可能已被后续包复用
+    const quint32 ackedIndex = packetNum - 1;
+    if (ackedIndex >= fw.currentPacket && ackedIndex < fw.nextPacket) {
+        InFlightPacket &slot = fw.inFlight[ackedIndex % MAX_WINDOW_SIZE];
+        if (!slot.acked) {
+            slot.acked = true;
+            // 重传包的应答无法区分对应哪一次发送，不作为RTT样本
+            if (!slot.retransmitted) {
+                const qint64 rttUs = elapsedUs() - slot.sendTime;
+                dataRtt.addSample((rttUs + 500) / 1000);
+                telemetry.devices[currentFirmwareIndex].rtt.add(rttUs);
+                telemetry.rtt.add(rttUs);
+            }
+        }
+    }
+
+    // 累计确认：receivedCount 之前的包都已被下位机接收
+    const quint32 cumulative = qMin(receivedCount, fw.nextPacket);
+    for (quint32 i = fw.currentPacket; i < cumulative; ++i) {
+        fw.inFlight[i % MAX_WINDOW_SIZE].acked = true;
+    }
+
+    const quint32 previous = fw.currentPacket;
+    while (fw.currentPacket < fw.nextPacket && fw.inFlight[fw.currentPacket % MAX_WINDOW_SIZE].acked) {
+        fw.currentPacket++;
+    }
+
+    if (fw.currentPacket != previous) {
+        sentPackets += fw.currentPacket - previous;
+        fw.gapAckCount = 0;
+        updateProgress(fw.currentPacket == fw.packetCount);
+
+        // 断点按间隔写入；数据全部确认时立即写入，结束阶段中断后可直接续传到升级结束
+        const qint64 now = rttClock.elapsed();
+        if (fw.currentPacket == fw.packetCount || now - lastCheckpointTime >= CHECKPOINT_INTERVAL_MS) {
+            lastCheckpointTime = now;
+            writeCheckpoint(currentFirmwareIndex, fw.currentPacket);
+        }
+    } else if (ackedIndex > fw.currentPacket &&
+               ++fw.gapAckCount == FAST_RETRANSMIT_THRESHOLD) {
+        // 后续包已到达而窗口下沿仍缺失，不等超时直接补发缺失包
+        emit showInfo(tr(">>> 检测到丢包，快速重传第 %1 包").arg(fw.currentPacket + 1));
+        telemetry.devices[currentFirmwareIndex].fastRetransmits++;
+        retransmitMissingPackets(ackedIndex);
+    }
 }
 
 /**
@@ -317,22 +926,14 @@ void UpgradeManager::sendUpgradeEnd()
     }
 
     upgradeState = UpgradeState::WAIT_UPGRADE_END;
+    enterPhase(UpgradeTelemetry::Phase::End);
 
     const FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
 
-    BootLoaderProtocol::MessageType endType = BootLoaderProtocol::MessageType::FPGA_END;
-    switch (fw.deviceType) {
-        case DeviceType::FPGA: endType = BootLoaderProtocol::MessageType::FPGA_END; break;
-        case DeviceType::DSP1: endType = BootLoaderProtocol::MessageType::DSP1_END; break;
-        case DeviceType::DSP2: endType = BootLoaderProtocol::MessageType::DSP2_END; break;
-        case DeviceType::ARM: endType = BootLoaderProtocol::MessageType::ARM_END; break;
-        default: break;
-    }
-
-    QByteArray end = protocol.buildUpgradeEnd(slaveId, endType);
+    QByteArray end = protocol.buildUpgradeEnd(slaveId, endType(fw.deviceType));
     emit sendData(end, tr("发送升级结束"));
 
-    upgradeTimer->start();
+    armTimer();
 }
 
 /**
@@ -341,17 +942,18 @@ void UpgradeManager::sendUpgradeEnd()
 void UpgradeManager::sendTotalEnd()
 {
     upgradeState = UpgradeState::WAIT_TOTAL_END;
+    enterPhase(UpgradeTelemetry::Phase::TotalEnd);
 
     QByteArray totalEnd = protocol.buildTotalEnd(slaveId);
     emit sendData(totalEnd, tr("发送总体结束"));
 
-    upgradeTimer->start();
+    armTimer();
 }
 
 /**
  * @brief 处理接收到的响应
  */
-void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, BootLoaderProtocol::ResponseFlag flag, const QByteArray &payload)
+void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, BootLoaderProtocol::ResponseFlag flag, QByteArrayView payload)
 {
     // 处理调试信息 - 调试信息在任何状态下都应该显示
     if (msgType == BootLoaderProtocol::MessageType::DEBUG_INFO) {
@@ -362,13 +964,13 @@ void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, Boo
         if (upgradeState != UpgradeState::IDLE &&
             upgradeState != UpgradeState::UPGRADE_SUCCESS &&
             upgradeState != UpgradeState::UPGRADE_FAILED) {
-            upgradeTimer->start();
+            armTimer();
         }
         return;
     }
 
     // 重置超时
-    upgradeTimer->stop();
+    upgradeTimer.stop();
     retryCount = 0;
 
     switch (upgradeState) {
@@ -376,8 +978,35 @@ void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, Boo
             if (msgType == BootLoaderProtocol::MessageType::UPGRADE_REQUEST) {
                 if (flag == BootLoaderProtocol::ResponseFlag::ALLOW_UPGRADE &&
                     !payload.isEmpty() && payload[0] == 0x00) {
+                    // 旧版下位机只回复状态字节，视为不支持扩展寻址
+                    const quint8 capabilities = payload.size() > 1 ? static_cast<quint8>(payload[1]) : 0;
+                    if (extendedAddressing &&
+                        !(capabilities & BootLoaderProtocol::CAPABILITY_EXTENDED_ADDRESSING)) {
+                        upgradeComplete(false, tr("设备不支持扩展寻址，无法传输超过 %1 包的固件")
+                                                   .arg(BootLoaderProtocol::MAX_PACKET_COUNT));
+                        return;
+                    }
                     emit showInfo(tr(">>> 设备允许升级"));
-                    sendSystemReset();
+                    deltaSupported = (capabilities & BootLoaderProtocol::CAPABILITY_DELTA) != 0;
+                    compressionSupported = (capabilities & BootLoaderProtocol::CAPABILITY_COMPRESSION) != 0;
+
+                    // 未声明连续接收计数的下位机按停等方式传输，其接收计数不能作为累计确认
+                    activeWindow = (capabilities & BootLoaderProtocol::CAPABILITY_WINDOW) ? transferWindow : 1;
+                    telemetry.windowSize = activeWindow;
+                    if (activeWindow < transferWindow) {
+                        emit showInfo(tr(">>> 设备不支持滑动窗口，按停等方式传输"));
+                    }
+                    if (resumeJournal.isValid() &&
+                        (capabilities & BootLoaderProtocol::CAPABILITY_RESUME) &&
+                        journalDigestsMatch()) {
+                        resumeUpgrade();
+                    } else {
+                        if (resumeJournal.isValid()) {
+                            emit showInfo(tr(">>> 设备不支持断点续传或固件已改变，重新完整升级"));
+                        }
+                        discardJournal();
+                        sendSystemReset();
+                    }
                 } else {
                     upgradeComplete(false, tr("设备禁止升级或状态异常"));
                 }
@@ -396,18 +1025,65 @@ void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, Boo
             }
             break;
 
+        case UpgradeState::WAIT_RESUME:
+            if (msgType == BootLoaderProtocol::MessageType::RESUME) {
+                if (currentFirmwareIndex < 0) break;
+
+                FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
+
+                // 状态(1) + 下位机从第1包起连续收到的包数(4)，以下位机为准
+                quint32 receivedCount = 0;
+                bool accepted = flag == BootLoaderProtocol::ResponseFlag::SUCCESS &&
+                                payload.size() >= 5 && payload[0] == 0x00;
+                if (accepted) {
+                    for (qsizetype i = 1; i < 5; ++i) {
+                        receivedCount = (receivedCount << 8) | static_cast<quint8>(payload[i]);
+                    }
+                    accepted = receivedCount <= fw.packetCount;
+                }
+
+                if (!accepted) {
+                    // 下位机已丢失断点或与记录不符，复位后完整升级
+                    emit showInfo(tr(">>> 设备拒绝断点续传，重新完整升级"));
+                    discardJournal();
+                    currentFirmwareIndex = -1;
+                    sentPackets = 0;
+                    telemetry.resumedPackets = 0;
+                    dataReader.reset();
+                    sendSystemReset();
+                    break;
+                }
+
+                fw.currentPacket = receivedCount;
+                fw.nextPacket = receivedCount;
+                sentPackets += receivedCount;
+                telemetry.resumedPackets += receivedCount;
+                emit showInfo(tr(">>> 断点续传：%1 从第 %2/%3 包继续")
+                                  .arg(deviceName(fw.deviceType))
+                                  .arg(receivedCount + 1)
+                                  .arg(fw.packetCount));
+
+                // 续传前已确认的数据不计入吞吐
+                resetRateSample();
+                updateProgress(true);
+
+                if (fw.currentPacket < fw.packetCount) {
+                    sendUpgradeData();
+                } else {
+                    emit showInfo(tr(">>> 所有数据包发送完成"));
+                    sendUpgradeEnd();
+                }
+            }
+            break;
+
         case UpgradeState::WAIT_UPGRADE_COMMAND:
             {
                 if (currentFirmwareIndex < 0) break;
 
-                const FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
-                BootLoaderProtocol::MessageType expectedType = BootLoaderProtocol::MessageType::FPGA_COMMAND;
-                switch (fw.deviceType) {
-                    case DeviceType::FPGA: expectedType = BootLoaderProtocol::MessageType::FPGA_COMMAND; break;
-                    case DeviceType::DSP1: expectedType = BootLoaderProtocol::MessageType::DSP1_COMMAND; break;
-                    case DeviceType::DSP2: expectedType = BootLoaderProtocol::MessageType::DSP2_COMMAND; break;
-                    case DeviceType::ARM: expectedType = BootLoaderProtocol::MessageType::ARM_COMMAND; break;
-                    default: break;
+                FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
+                BootLoaderProtocol::MessageType expectedType = commandType(fw.deviceType);
+                if (fw.plan.isDeltaMode()) {
+                    expectedType = BootLoaderProtocol::MessageType::DELTA_COMMAND;
                 }
 
                 if (msgType == expectedType) {
@@ -419,8 +1095,22 @@ void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, Boo
                     // 处理擦除成功标志（0x0A）
                     else if (flag == BootLoaderProtocol::ResponseFlag::ERASE_SUCCESS &&
                         !payload.isEmpty() && payload[0] == 0x00) {
-                        emit showInfo(tr(">>> 擦除Flash成功，开始传输数据"));
-                        sendUpgradeData();
+                        if (fw.packetCount == 0) {
+                            // 与基线完全相同，只需让下位机校验
+                            emit showInfo(tr(">>> 固件与基线相同，无需传输数据"));
+                            sendUpgradeEnd();
+                        } else {
+                            emit showInfo(tr(">>> 擦除Flash成功，开始传输数据"));
+                            sendUpgradeData();
+                        }
+                    }
+                    else if (fw.plan.isDeltaMode()) {
+                        // 下位机当前固件与基线不符（或不接受差分），退回完整升级
+                        emit showInfo(tr(">>> 设备拒绝差分升级（%1），改为完整升级")
+                                          .arg(BootLoaderProtocol::getResponseDescription(flag)));
+                        selectDeltaMode(fw, false);
+                        sendUpgradeCommand();
+                        return;
                     }
                     else {
                         const QString reason = BootLoaderProtocol::getResponseDescription(flag);
@@ -435,51 +1125,73 @@ void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, Boo
                 if (currentFirmwareIndex < 0) break;
 
                 FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
-                BootLoaderProtocol::MessageType expectedType = BootLoaderProtocol::MessageType::FPGA_DATA;
-                switch (fw.deviceType) {
-                    case DeviceType::FPGA: expectedType = BootLoaderProtocol::MessageType::FPGA_DATA; break;
-                    case DeviceType::DSP1: expectedType = BootLoaderProtocol::MessageType::DSP1_DATA; break;
-                    case DeviceType::DSP2: expectedType = BootLoaderProtocol::MessageType::DSP2_DATA; break;
-                    case DeviceType::ARM: expectedType = BootLoaderProtocol::MessageType::ARM_DATA; break;
-                    default: break;
+                BootLoaderProtocol::MessageType expectedType = dataType(fw.deviceType);
+                if (fw.plan.isCompressedMode()) {
+                    expectedType = BootLoaderProtocol::MessageType::COMPRESSED_DATA;
+                } else if (fw.plan.isDeltaMode()) {
+                    expectedType = BootLoaderProtocol::MessageType::DELTA_DATA;
                 }
 
                 if (msgType == expectedType) {
                     if (flag == BootLoaderProtocol::ResponseFlag::SUCCESS) {
-                        if (payload.size() < 5) {
+                        // status(1) + 包序号 + 已接收包数，扩展寻址、差分和压缩传输时后两者各4字节
+                        const qsizetype fieldSize = fw.plan.isDeltaMode() || fw.plan.isCompressedMode()
+                            ? 4 : BootLoaderProtocol::packetNumberSize(extendedAddressing);
+                        if (payload.size() < 1 + 2 * fieldSize) {
                             upgradeComplete(false, tr("数据传输失败：应答长度异常"));
                             return;
                         }
 
+                        auto readField = [&payload, fieldSize](qsizetype pos) {
+                            quint32 value = 0;
+                            for (qsizetype i = 0; i < fieldSize; ++i) {
+                                value = (value << 8) | static_cast<quint8>(payload[pos + i]);
+                            }
+                            return value;
+                        };
+
                         const quint8 status = static_cast<quint8>(payload[0]);
-                        const quint16 packetNum = static_cast<quint16>((static_cast<quint8>(payload[1]) << 8) |
-                                                                       static_cast<quint8>(payload[2]));
-                        const quint16 receivedCount = static_cast<quint16>((static_cast<quint8>(payload[3]) << 8) |
-                                                                            static_cast<quint8>(payload[4]));
-                        const quint16 expectedPacket = fw.currentPacket + 1;
+                        const quint32 packetNum = readField(1);
+                        const quint32 receivedCount = readField(1 + fieldSize);
+                        const quint32 expectedPacket = fw.currentPacket + 1;
 
                         if (status != 0x00) {
                             upgradeComplete(false, tr("数据传输失败：目标设备上报错误状态"));
                             return;
                         }
 
-                        if (packetNum != expectedPacket) {
-                            upgradeComplete(false, tr("数据传输失败：包序号不匹配 (期望 %1, 实际 %2)")
-                                                           .arg(expectedPacket)
-                                                           .arg(packetNum));
-                            return;
+                        if (activeWindow <= 1) {
+                            if (packetNum != expectedPacket) {
+                                upgradeComplete(false, tr("数据传输失败：包序号不匹配 (期望 %1, 实际 %2)")
+                                                               .arg(expectedPacket)
+                                                               .arg(packetNum));
+                                return;
+                            }
+
+                            if (receivedCount < packetNum || receivedCount > fw.packetCount) {
+                                upgradeComplete(false, tr("数据传输失败：目标设备接收计数异常"));
+                                return;
+                            }
+                        } else {
+                            // 窗口模式：应答可能越序或重复，只要求包序号落在已发送范围内
+                            if (packetNum == 0 || packetNum > fw.nextPacket) {
+                                upgradeComplete(false, tr("数据传输失败：包序号不匹配 (已发送 %1, 实际 %2)")
+                                                               .arg(fw.nextPacket)
+                                                               .arg(packetNum));
+                                return;
+                            }
+
+                            if (receivedCount > fw.packetCount) {
+                                upgradeComplete(false, tr("数据传输失败：目标设备接收计数异常"));
+                                return;
+                            }
                         }
 
-                        if (receivedCount < packetNum || receivedCount > fw.packetCount) {
-                            upgradeComplete(false, tr("数据传输失败：目标设备接收计数异常"));
+                        handleDataAck(fw, packetNum, receivedCount);
+                        if (upgradeState != UpgradeState::WAIT_UPGRADE_DATA) {
                             return;
                         }
 
-                        fw.currentPacket++;
-                        sentPackets++;
-
-                        updateProgress();
-
                         if (fw.currentPacket < fw.packetCount) {
                             sendUpgradeData();
                         } else {
@@ -500,14 +1212,7 @@ void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, Boo
                 if (currentFirmwareIndex < 0) break;
 
                 const FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
-                BootLoaderProtocol::MessageType expectedType = BootLoaderProtocol::MessageType::FPGA_END;
-                switch (fw.deviceType) {
-                    case DeviceType::FPGA: expectedType = BootLoaderProtocol::MessageType::FPGA_END; break;
-                    case DeviceType::DSP1: expectedType = BootLoaderProtocol::MessageType::DSP1_END; break;
-                    case DeviceType::DSP2: expectedType = BootLoaderProtocol::MessageType::DSP2_END; break;
-                    case DeviceType::ARM: expectedType = BootLoaderProtocol::MessageType::ARM_END; break;
-                    default: break;
-                }
+                const BootLoaderProtocol::MessageType expectedType = endType(fw.deviceType);
 
                 if (msgType == expectedType) {
                     const bool successFlag = (flag == BootLoaderProtocol::ResponseFlag::SUCCESS ||
@@ -517,6 +1222,8 @@ void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, Boo
                     if (successFlag) {
                         if (!payload.isEmpty() && static_cast<quint8>(payload[0]) == 0x00) {
                             emit showInfo(tr(">>> 设备升级完成\n"));
+                            writeCheckpoint(currentFirmwareIndex + 1, 0);
+                            storeBaseline(fw);
 
                             // 升级下一个设备
                             DeviceType nextDevice = DeviceType::FPGA;
@@ -530,10 +1237,13 @@ void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, Boo
                             }
                             startDeviceUpgrade(nextDevice);
                         } else {
+                            // 校验未通过，数据需要重新传输
+                            discardJournal();
                             upgradeComplete(false, tr("设备升级校验失败：目标设备状态异常"));
                             return;
                         }
                     } else {
+                        discardJournal();
                         const QString reason = failureMessageForFlag(flag);
                         upgradeComplete(false, tr("设备升级失败：%1").arg(reason));
                         return;
@@ -566,7 +1276,7 @@ void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, Boo
     if (upgradeState != UpgradeState::IDLE &&
         upgradeState != UpgradeState::UPGRADE_SUCCESS &&
         upgradeState != UpgradeState::UPGRADE_FAILED) {
-        upgradeTimer->start();
+        armTimer();
     }
 }
 
@@ -575,12 +1285,18 @@ void UpgradeManager::handleResponse(BootLoaderProtocol::MessageType msgType, Boo
  */
 void UpgradeManager::onTimeout()
 {
-    upgradeTimer->stop();
+    upgradeTimer.stop();
 
     retryCount++;
+    telemetry.timeouts++;
+    if (phaseActive && phaseDevice >= 0) {
+        telemetry.devices[phaseDevice].timeouts++;
+    }
 
-    if (retryCount <= 3) {
-        emit showInfo(tr(">>> 通信超时，第 %1 次重发...").arg(retryCount));
+    if (retryCount <= maxRetries()) {
+        emit showInfo(tr(">>> 通信超时(%1 ms)，第 %2 次重发...")
+                          .arg(upgradeTimer.interval())
+                          .arg(retryCount));
 
         // 根据当前状态重发相应的报文
         switch (upgradeState) {
@@ -590,11 +1306,15 @@ void UpgradeManager::onTimeout()
             case UpgradeState::WAIT_SYSTEM_RESET:
                 sendSystemReset();
                 break;
+            case UpgradeState::WAIT_RESUME:
+                sendResume();
+                break;
             case UpgradeState::WAIT_UPGRADE_COMMAND:
                 sendUpgradeCommand();
                 break;
             case UpgradeState::WAIT_UPGRADE_DATA:
-                sendUpgradeData();
+                // 只重传尚未确认的数据包
+                retransmitMissingPackets(std::numeric_limits<quint32>::max());
                 break;
             case UpgradeState::WAIT_UPGRADE_END:
                 sendUpgradeEnd();
@@ -610,23 +1330,85 @@ void UpgradeManager::onTimeout()
     }
 }
 
+/**
+ * @brief 按当前阶段的超时预算启动计时器
+ */
+void UpgradeManager::armTimer()
+{
+    upgradeTimer.start(phaseTimeout());
+}
+
+/**
+ * @brief 计算当前阶段的超时时间（含指数退避）
+ */
+int UpgradeManager::phaseTimeout() const
+{
+    const bool validFirmware = currentFirmwareIndex >= 0 && currentFirmwareIndex < firmwareList.size();
+    const quint64 imageSize = validFirmware ? firmwareList[currentFirmwareIndex].fileSize : 0;
+
+    int base = CONTROL_TIMEOUT_MS;
+    int ceiling = MAX_PHASE_TIMEOUT_MS;
+    switch (upgradeState) {
+        case UpgradeState::WAIT_SYSTEM_RESET:
+            base = RESET_TIMEOUT_MS;
+            break;
+        case UpgradeState::WAIT_UPGRADE_COMMAND:
+            base = scaledBudget(ERASE_BASE_TIMEOUT_MS, ERASE_MS_PER_MB, imageSize);
+            break;
+        case UpgradeState::WAIT_UPGRADE_DATA:
+            base = dataRtt.timeout();
+            ceiling = DATA_MAX_TIMEOUT_MS;
+            break;
+        case UpgradeState::WAIT_UPGRADE_END:
+            base = scaledBudget(END_BASE_TIMEOUT_MS, END_MS_PER_MB, imageSize);
+            break;
+        default:
+            break;
+    }
+
+    // 每次超时重发后超时时间翻倍
+    const qint64 backedOff = static_cast<qint64>(base) << qMin(retryCount, 16);
+    return static_cast<int>(qMin<qint64>(backedOff, qMax(base, ceiling)));
+}
+
+/**
+ * @brief 当前阶段允许的最大重发次数
+ */
+int UpgradeManager::maxRetries() const
+{
+    return upgradeState == UpgradeState::WAIT_UPGRADE_DATA ? MAX_DATA_RETRIES : MAX_RETRIES;
+}
+
 /**
  * @brief 升级完成
  */
 void UpgradeManager::upgradeComplete(bool success, const QString &message)
 {
-    upgradeTimer->stop();
+    upgradeTimer.stop();
+
+    // 成功后断点失去意义；数据传输中失败则记下当前进度，下次从这里续传
+    if (success) {
+        discardJournal();
+    } else if (upgradeState == UpgradeState::WAIT_UPGRADE_DATA) {
+        writeCheckpoint(currentFirmwareIndex, firmwareList[currentFirmwareIndex].currentPacket);
+    }
+
+    closePhase();
+    telemetry.totalUs = elapsedUs();
+    telemetry.success = success;
+    telemetry.message = message;
 
     if (success) {
         upgradeState = UpgradeState::UPGRADE_SUCCESS;
         emit showInfo(tr(">>> 升级完成！%1").arg(message));
-        emit showInfo(tr("========================================"));
     } else {
         upgradeState = UpgradeState::UPGRADE_FAILED;
         emit showInfo(tr(">>> 升级失败：%1").arg(message));
-        emit showInfo(tr("========================================"));
     }
 
+    emit telemetryReady(telemetry);
+    emit showInfo(tr("========================================"));
+
     emit upgradeFinished(success, message);
 
     resetState();
@@ -640,27 +1422,121 @@ void UpgradeManager::resetState()
     upgradeState = UpgradeState::IDLE;
     currentFirmwareIndex = -1;
     retryCount = 0;
-    upgradeTimer->stop();
+    upgradeTimer.stop();
+    dataReader.reset();
+    phaseActive = false;
+}
+
+/**
+ * @brief 进入升级阶段，结束并记录上一阶段的耗时
+ *
+ * 超时重发会再次调用发送函数，同一设备的同一阶段不重新计时。
+ */
+void UpgradeManager::enterPhase(UpgradeTelemetry::Phase phase)
+{
+    const bool devicePhase = phase == UpgradeTelemetry::Phase::Erase ||
+                             phase == UpgradeTelemetry::Phase::Data ||
+                             phase == UpgradeTelemetry::Phase::End;
+    const int device = devicePhase ? currentFirmwareIndex : -1;
+    if (phaseActive && currentPhase == phase && phaseDevice == device) {
+        return;
+    }
+
+    closePhase();
+    currentPhase = phase;
+    phaseDevice = device;
+    phaseStartUs = elapsedUs();
+    phaseActive = true;
+}
+
+/**
+ * @brief 结束当前阶段，耗时计入本次升级和所属设备
+ */
+void UpgradeManager::closePhase()
+{
+    if (!phaseActive) {
+        return;
+    }
+
+    const qint64 duration = elapsedUs() - phaseStartUs;
+    const int index = static_cast<int>(currentPhase);
+    telemetry.phaseUs[index] += duration;
+    if (phaseDevice >= 0 && phaseDevice < telemetry.devices.size()) {
+        telemetry.devices[phaseDevice].phaseUs[index] += duration;
+    }
+    phaseActive = false;
+}
+
+/**
+ * @brief 从当前时刻重新开始吞吐采样（保留已有的平滑值）
+ */
+void UpgradeManager::resetRateSample()
+{
+    rateSampleTime = rttClock.elapsed();
+    rateSampleBytes = completedBytes;
+    rateSamplePackets = sentPackets;
+    if (currentFirmwareIndex >= 0 && currentFirmwareIndex < firmwareList.size()) {
+        rateSampleBytes += ackedBytes(firmwareList[currentFirmwareIndex]);
+    }
 }
 
 /**
  * @brief 更新进度
+ * @param force 不受采样间隔限制，立即发出
  */
-void UpgradeManager::updateProgress()
+void UpgradeManager::updateProgress(bool force)
 {
     if (currentFirmwareIndex < 0 || currentFirmwareIndex >= firmwareList.size()) {
         return;
     }
 
+    const qint64 now = rttClock.elapsed();
+    if (!force && now - lastProgressTime < PROGRESS_INTERVAL_MS) {
+        return;
+    }
+    lastProgressTime = now;
+
     const FirmwareInfo &fw = firmwareList[currentFirmwareIndex];
 
+    Progress progress;
+    progress.device = fw.deviceType;
+    progress.deviceBytes = ackedBytes(fw);
+    progress.deviceTotalBytes = fw.transferSize;
+    progress.overallBytes = completedBytes + progress.deviceBytes;
+    progress.overallTotalBytes = totalBytes;
+
     // 计算当前设备进度
-    int currentProgress = fw.packetCount > 0 ? (fw.currentPacket * 100) / fw.packetCount : 0;
+    progress.devicePercent = fw.packetCount > 0 ? static_cast<int>(static_cast<qint64>(fw.currentPacket) * 100 / fw.packetCount) : 0;
 
     // 计算总体进度
-    int totalProgress = totalPackets > 0 ? (sentPackets * 100) / totalPackets : 0;
+    progress.totalPercent = totalPackets > 0 ? static_cast<int>(sentPackets * 100 / totalPackets) : 0;
+
+    // 每个采样间隔计算一次瞬时吞吐，再做指数平滑
+    const qint64 elapsed = now - rateSampleTime;
+    if (elapsed >= PROGRESS_INTERVAL_MS) {
+        const double seconds = elapsed / 1000.0;
+        const double byteSample = (progress.overallBytes - rateSampleBytes) / seconds;
+        const double packetSample = (sentPackets - rateSamplePackets) / seconds;
+        if (bytesRate <= 0.0) {
+            bytesRate = byteSample;
+            packetRate = packetSample;
+        } else {
+            bytesRate += RATE_SMOOTHING * (byteSample - bytesRate);
+            packetRate += RATE_SMOOTHING * (packetSample - packetRate);
+        }
+        resetRateSample();
+    }
 
-    emit progressUpdated(currentProgress, totalProgress);
+    progress.bytesPerSecond = bytesRate;
+    progress.packetsPerSecond = packetRate;
+    if (bytesRate > 0.0) {
+        progress.deviceEtaMs = static_cast<qint64>((progress.deviceTotalBytes - progress.deviceBytes) * 1000.0 / bytesRate);
+        progress.totalEtaMs = static_cast<qint64>((progress.overallTotalBytes - progress.overallBytes) * 1000.0 / bytesRate);
+    }
+    progress.retransmits = telemetry.retransmits;
+    progress.timeouts = telemetry.timeouts;
+
+    emit progressUpdated(progress);
 }
 
 QString UpgradeManager::failureMessageForFlag(BootLoaderProtocol::ResponseFlag flag) const
@@ -704,8 +1580,251 @@ QString UpgradeManager::failureMessageForFlag(BootLoaderProtocol::ResponseFlag f
 void UpgradeManager::stopUpgrade()
 {
     if (upgradeState != UpgradeState::IDLE) {
-        upgradeTimer->stop();
+        upgradeTimer.stop();
+        if (upgradeState == UpgradeState::WAIT_UPGRADE_DATA) {
+            writeCheckpoint(currentFirmwareIndex, firmwareList[currentFirmwareIndex].currentPacket);
+        }
         emit showInfo(tr(">>> 升级已取消"));
         resetState();
     }
 }
+
+// ========================================================================
+// 断点续传
+// ========================================================================
+
+/**
+ * @brief 断点记录是否属于本次升级的同一组固件（路径、大小、分包、寻址方式均一致）
+ *
+ * 镜像内容在设备允许升级后、传输计划算出时再按SHA-256比较。
+ */
+bool UpgradeManager::journalMatches(const UpgradeJournal &journal) const
+{
+    if (!journal.isValid() || journal.slaveId != slaveId || journal.extended != extendedAddressing ||
+        journal.images.size() != firmwareList.size()) {
+        return false;
+    }
+
+    for (int i = 0; i < firmwareList.size(); ++i) {
+        const FirmwareInfo &fw = firmwareList[i];
+        const UpgradeJournal::Image &image = journal.images[i];
+        if (image.device != deviceName(fw.deviceType) || image.path != fw.filePath ||
+            image.size != fw.fileSize || image.packetSize != fw.packetSize ||
+            image.packetCount != fw.packetCount) {
+            return false;
+        }
+    }
+
+    // 尚未确认任何数据时没有可续传的内容
+    if (journal.deviceIndex == 0 && journal.ackedPackets == 0) {
+        return false;
+    }
+    return journal.deviceIndex == firmwareList.size() ||
+           journal.ackedPackets <= firmwareList[journal.deviceIndex].packetCount;
+}
+
+/**
+ * @brief 比较已完成和正在传输的固件与断点记录中的SHA-256
+ */
+bool UpgradeManager::journalDigestsMatch()
+{
+    const int last = qMin(resumeJournal.deviceIndex, static_cast<int>(firmwareList.size()) - 1);
+    for (int i = 0; i <= last; ++i) {
+        FirmwareInfo &fw = firmwareList[i];
+        if (!takeTransferPlan(fw)) {
+            return false;
+        }
+        const QByteArray &digest = resumeJournal.images[i].digest;
+        if (digest.isEmpty() || digest != fw.plan.digest()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 跳过复位，从断点记录的设备继续
+ */
+void UpgradeManager::resumeUpgrade()
+{
+    const int index = resumeJournal.deviceIndex;
+
+    // 固件列表与升级顺序一致，断点之前的设备都已完成
+    sentPackets = 0;
+    for (int i = 0; i < index; ++i) {
+        sentPackets += firmwareList[i].packetCount;
+    }
+    telemetry.resumedPackets = static_cast<quint64>(sentPackets);
+
+    if (index >= firmwareList.size()) {
+        emit showInfo(tr(">>> 断点续传：全部设备已完成"));
+        sendTotalEnd();
+        return;
+    }
+
+    if (resumeJournal.ackedPackets == 0) {
+        // 上一设备已完成而本设备尚未开始传输，从升级指令（擦除）开始
+        emit showInfo(tr(">>> 断点续传：从 %1 开始").arg(deviceName(firmwareList[index].deviceType)));
+        startDeviceUpgrade(firmwareList[index].deviceType);
+        return;
+    }
+
+    currentFirmwareIndex = index;
+    completedBytes = 0;
+    for (int i = 0; i < index; ++i) {
+        completedBytes += firmwareList[i].transferSize;
+    }
+
+    FirmwareInfo &fw = firmwareList[index];
+    fw.currentPacket = 0;
+    fw.nextPacket = 0;
+    fw.gapAckCount = 0;
+    fw.inFlight = QVector<InFlightPacket>(MAX_WINDOW_SIZE);
+    dataReader.reset();
+
+    sendResume();
+}
+
+/**
+ * @brief 写入断点记录
+ * @param deviceIndex 正在传输的固件索引
+ * @param ackedPackets 该固件已被累计确认的包数
+ */
+void UpgradeManager::writeCheckpoint(int deviceIndex, quint32 ackedPackets)
+{
+    if (journalFile.isEmpty()) {
+        return;
+    }
+
+    // 差分传输的包序号只对应变化的块，续传时无法与完整分包对照，数据阶段不记录
+    if (ackedPackets > 0 && deviceIndex < firmwareList.size() && firmwareList[deviceIndex].plan.isDeltaMode()) {
+        return;
+    }
+
+    UpgradeJournal journal;
+    journal.slaveId = slaveId;
+    journal.extended = extendedAddressing;
+    journal.deviceIndex = deviceIndex;
+    journal.ackedPackets = ackedPackets;
+    journal.updated = QDateTime::currentMSecsSinceEpoch();
+    for (const FirmwareInfo &fw : firmwareList) {
+        UpgradeJournal::Image image;
+        image.device = deviceName(fw.deviceType);
+        image.path = fw.filePath;
+        image.size = fw.fileSize;
+        image.digest = fw.plan.digest();
+        image.packetSize = fw.packetSize;
+        image.packetCount = static_cast<quint32>((fw.fileSize + fw.packetSize - 1) / fw.packetSize);
+        journal.images.append(image);
+    }
+
+    // 在线程池中写入，应答处理不等待磁盘；失败在下一次写入时报告
+    const QString errorString = journalWriter.takeError();
+    if (!errorString.isEmpty() && !journalError) {
+        journalError = true;
+        emit showInfo(tr(">>> 无法写入断点记录：%1").arg(errorString));
+    }
+    journalWriter.save(journalFile, journal);
+}
+
+/**
+ * @brief 删除断点记录，下次升级从头开始
+ */
+void UpgradeManager::discardJournal()
+{
+    resumeJournal = UpgradeJournal();
+    if (!journalFile.isEmpty()) {
+        journalWriter.remove(journalFile);
+    }
+}
+
+// ========================================================================
+// 差分升级
+// ========================================================================
+
+/**
+ * @brief 设备的基线固件文件，未设置基线目录时为空
+ */
+QString UpgradeManager::baselinePathFor(DeviceType device) const
+{
+    if (baselineDirectory.isEmpty()) {
+        return QString();
+    }
+    return QDir(baselineDirectory).filePath(deviceName(device) + QStringLiteral(".bin"));
+}
+
+/**
+ * @brief 在完整升级和差分升级之间切换当前固件，同步调整包数和进度总量
+ */
+void UpgradeManager::selectDeltaMode(FirmwareInfo &fw, bool delta)
+{
+    const quint32 previousCount = fw.packetCount;
+    const quint64 previousSize = fw.transferSize;
+
+    fw.plan.setDeltaMode(delta);
+    fw.packetCount = static_cast<quint32>(fw.plan.packetCount());
+    fw.transferSize = fw.plan.isDeltaMode() ? fw.plan.deltaBytes() : fw.fileSize;
+
+    totalPackets += static_cast<qint64>(fw.packetCount) - previousCount;
+    totalBytes = totalBytes - previousSize + fw.transferSize;
+
+    UpgradeTelemetry::Device &stats = telemetry.devices[currentFirmwareIndex];
+    stats.delta = fw.plan.isDeltaMode();
+    stats.deltaPackets = stats.delta ? fw.packetCount : 0;
+    stats.transferBytes = fw.transferSize;
+}
+
+/**
+ * @brief 下位机支持压缩且当前模式下压缩后总量变小时，改用压缩报文传输
+ *
+ * 按链路上的总字节数比较：压缩报文每包多出块号和原始长度字段，块很小或压缩率很低时可能得不偿失。
+ */
+void UpgradeManager::selectCompression(FirmwareInfo &fw)
+{
+    if (!compressionSupported || !fw.plan.hasCompression()) {
+        return;
+    }
+    const quint64 plainBytes = fw.plan.frameBytes(false);
+    const quint64 compressedBytes = fw.plan.frameBytes(true);
+    if (compressedBytes >= plainBytes) {
+        return;
+    }
+
+    fw.plan.setCompressedMode(true);
+    telemetry.devices[currentFirmwareIndex].compressed = true;
+    emit showInfo(tr(">>> 压缩传输：%1 → %2 字节（含帧头，压缩比 %3）")
+                      .arg(plainBytes)
+                      .arg(compressedBytes)
+                      .arg(static_cast<double>(plainBytes) / compressedBytes, 0, 'f', 2));
+}
+
+/**
+ * @brief 设备升级成功后把写入的固件保存为基线
+ *
+ * 内容取自本次发送所用的镜像，按窗口读取并计算SHA-256，与传输计划的摘要一致才替换基线，
+ * 升级期间文件被改写时不会把设备上没有的内容当作基线。写入经 QSaveFile 原子替换，
+ * 复制在线程池中进行，不阻塞本线程上的其他链路；失败原因回到本线程报告，析构时等待写完。
+ */
+void UpgradeManager::storeBaseline(const FirmwareInfo &fw)
+{
+    const QString target = baselinePathFor(fw.deviceType);
+    if (target.isEmpty() || !fw.image || fw.plan.digest().isEmpty() ||
+        QFileInfo(fw.filePath) == QFileInfo(target)) {
+        return;
+    }
+
+    baselineWriters.removeIf([](const QFuture<void> &writer) { return writer.isFinished(); });
+
+    const QSharedPointer<FirmwareImage> image = fw.image;
+    const QByteArray expected = fw.plan.digest();
+    const QString device = deviceName(fw.deviceType);
+    baselineWriters.append(QtConcurrent::run([this, image, expected, target, device]() {
+        const QString error = writeBaseline(*image, expected, target);
+        if (!error.isEmpty()) {
+            QMetaObject::invokeMethod(this, [this, device, error]() {
+                emit showInfo(tr(">>> %1 基线未更新（%2），下次升级将传输完整固件").arg(device, error));
+            }, Qt::QueuedConnection);
+        }
+    }));
+}
+}
@@ -0,0 +1,189 @@
+#include "inc/upgradejournal.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrentRun>
+
+namespace {
+constexpr int JOURNAL_VERSION = 1;
+
+bool writeFile(const QString &path, const QByteArray &data, QString *errorString)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+
+    file.write(data);
+    if (!file.commit()) {
+        if (errorString) {
+            *errorString = file.errorString();
+        }
+        return false;
+    }
+    return true;
+}
+}
+
+QJsonObject UpgradeJournal::toJson() const
+{
+    QJsonArray imageArray;
+    for (const Image &image : images) {
+        QJsonObject entry;
+        entry["device"] = image.device;
+        entry["path"] = image.path;
+        entry["size"] = static_cast<qint64>(image.size);
+        entry["sha256"] = QString::fromLatin1(image.digest.toHex());
+        entry["packet_size"] = image.packetSize;
+        entry["packet_count"] = static_cast<qint64>(image.packetCount);
+        imageArray.append(entry);
+    }
+
+    QJsonObject json;
+    json["version"] = JOURNAL_VERSION;
+    json["slave_id"] = slaveId;
+    json["extended"] = extended;
+    json["images"] = imageArray;
+    json["device_index"] = deviceIndex;
+    json["acked_packets"] = static_cast<qint64>(ackedPackets);
+    json["updated"] = updated;
+    return json;
+}
+
+UpgradeJournal UpgradeJournal::fromJson(const QJsonObject &json)
+{
+    UpgradeJournal journal;
+    if (json["version"].toInt() != JOURNAL_VERSION) {
+        return journal;
+    }
+
+    journal.slaveId = static_cast<quint8>(json["slave_id"].toInt());
+    journal.extended = json["extended"].toBool();
+    journal.deviceIndex = json["device_index"].toInt();
+    journal.ackedPackets = static_cast<quint32>(json["acked_packets"].toInteger());
+    journal.updated = json["updated"].toInteger();
+
+    for (const QJsonValue &value : json["images"].toArray()) {
+        const QJsonObject entry = value.toObject();
+        Image image;
+        image.device = entry["device"].toString();
+        image.path = entry["path"].toString();
+        image.size = static_cast<quint64>(entry["size"].toInteger());
+        image.digest = QByteArray::fromHex(entry["sha256"].toString().toLatin1());
+        image.packetSize = entry["packet_size"].toInt();
+        image.packetCount = static_cast<quint32>(entry["packet_count"].toInteger());
+        journal.images.append(image);
+    }
+
+    if (journal.deviceIndex < 0 || journal.deviceIndex > journal.images.size()) {
+        return UpgradeJournal();
+    }
+    return journal;
+}
+
+bool UpgradeJournal::save(const QString &path, QString *errorString) const
+{
+    return writeFile(path, QJsonDocument(toJson()).toJson(QJsonDocument::Compact), errorString);
+}
+
+UpgradeJournal UpgradeJournal::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return UpgradeJournal();
+    }
+
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    if (!document.isObject()) {
+        return UpgradeJournal();
+    }
+    return fromJson(document.object());
+}
+
+void UpgradeJournal::remove(const QString &path)
+{
+    QFile::remove(path);
+}
+
+// ============= 后台写入器 =============
+
+UpgradeJournal::Writer::~Writer()
+{
+    flush();
+}
+
+void UpgradeJournal::Writer::save(const QString &path, const UpgradeJournal &journal)
+{
+    submit(path, QJsonDocument(journal.toJson()).toJson(QJsonDocument::Compact), false);
+}
+
+void UpgradeJournal::Writer::remove(const QString &path)
+{
+    submit(path, QByteArray(), true);
+}
+
+void UpgradeJournal::Writer::submit(const QString &path, const QByteArray &data, bool remove)
+{
+    QMutexLocker locker(&mutex);
+    pendingPath = path;
+    pendingData = data;
+    pendingRemove = remove;
+    pending = true;
+
+    // 后台任务正在运行时由它取走本次请求，否则启动一个
+    if (!running) {
+        running = true;
+        worker = QtConcurrent::run([this]() { run(); });
+    }
+}
+
+void UpgradeJournal::Writer::run()
+{
+    QMutexLocker locker(&mutex);
+    while (pending) {
+        const QString path = pendingPath;
+        const QByteArray data = pendingData;
+        const bool remove = pendingRemove;
+        pending = false;
+        locker.unlock();
+
+        QString errorString;
+        bool ok = true;
+        if (remove) {
+            QFile::remove(path);
+        } else {
+            ok = writeFile(path, data, &errorString);
+        }
+
+        locker.relock();
+        if (!ok) {
+            error = errorString;
+        }
+    }
+    running = false;
+}
+
+void UpgradeJournal::Writer::flush()
+{
+    QMutexLocker locker(&mutex);
+    QFuture<void> running = worker;
+    locker.unlock();
+    running.waitForFinished();
+}
+
+QString UpgradeJournal::Writer::takeError()
+{
+    QMutexLocker locker(&mutex);
+    QString result = error;
+    error.clear();
+    return result;
+}
@@ -0,0 +1,168 @@
+#include "inc/upgradesession.h"
+
+namespace {
+constexpr int CONNECT_TIMEOUT_MS = 5000;
+}
+
+QString UpgradeSession::Target::name() const
+{
+    const QString linkName = link == CommunicationManager::LinkType::Serial
+                                 ? portName
+                                 : QStringLiteral("%1:%2").arg(host).arg(port);
+    return QStringLiteral("%1#%2").arg(linkName).arg(slaveId);
+}
+
+UpgradeSession::UpgradeSession(const Target &target, QObject *parent)
+    : QObject(parent)
+    , m_target(target)
+    , m_comm(this)
+    , m_upgrade(this)
+    , m_connectTimer(this)
+{
+    m_upgrade.setWindowSize(target.windowSize);
+    m_upgrade.setJournalPath(target.journalPath);
+    m_upgrade.setBaselineDir(target.baselineDir);
+    m_upgrade.setCompressionEnabled(target.compress);
+    m_connectTimer.setSingleShot(true);
+
+    // 应答 -> 状态机 -> 下一包 直接调用，与 LinkWorker 相同
+    connect(&m_comm, &CommunicationManager::frameReceived, this, [this](const BootLoaderProtocol::Frame &frame) {
+        if (m_upgrade.currentState() != UpgradeManager::UpgradeState::IDLE) {
+            m_upgrade.handleResponse(frame.type, frame.flag, frame.payload);
+        }
+    }, Qt::DirectConnection);
+    connect(&m_upgrade, &UpgradeManager::sendData, this, [this](const QByteArray &data, const QString &) {
+        if (!data.isEmpty()) {
+            m_comm.sendData(data);
+        }
+    });
+
+    connect(&m_comm, &CommunicationManager::connectionStateChanged, this, &UpgradeSession::onConnectionStateChanged);
+    connect(&m_comm, &CommunicationManager::serialError, this, &UpgradeSession::onLinkError);
+    connect(&m_comm, &CommunicationManager::tcpError, this, &UpgradeSession::onLinkError);
+    connect(&m_connectTimer, &QTimer::timeout, this, [this]() {
+        finish(Status::LinkError, tr("连接 %1 超时").arg(m_target.name()));
+    });
+
+    connect(&m_upgrade, &UpgradeManager::showInfo, this, &UpgradeSession::showInfo);
+    connect(&m_upgrade, &UpgradeManager::progressUpdated, this, &UpgradeSession::progressUpdated);
+    connect(&m_upgrade, &UpgradeManager::telemetryReady, this, &UpgradeSession::telemetryReady);
+    connect(&m_upgrade, &UpgradeManager::upgradeFinished, this, [this](bool success, const QString &message) {
+        finish(success ? Status::Success : Status::UpgradeFailed, message);
+    });
+}
+
+QString UpgradeSession::statusName(Status status)
+{
+    switch (status) {
+        case Status::Success: return QStringLiteral("success");
+        case Status::UpgradeFailed: return QStringLiteral("upgrade_failed");
+        case Status::LinkError: return QStringLiteral("link_error");
+        case Status::InvalidImage: return QStringLiteral("invalid_image");
+        case Status::Cancelled: return QStringLiteral("cancelled");
+    }
+    return QString();
+}
+
+void UpgradeSession::start()
+{
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+
+    if (m_target.link == CommunicationManager::LinkType::Serial) {
+        // 串口同步打开，失败时 serialError 已结束会话
+        m_comm.setActiveLink(CommunicationManager::LinkType::Serial);
+        m_comm.openSerialPort(m_target.portName, m_target.baudRate,
+                              QSerialPort::Data8, QSerialPort::OneStop, QSerialPort::NoParity);
+    } else {
+        m_comm.setActiveLink(CommunicationManager::LinkType::Ethernet);
+        m_connectTimer.start(CONNECT_TIMEOUT_MS);
+        m_comm.openTcpConnection(m_target.host, m_target.port);
+    }
+}
+
+void UpgradeSession::cancel()
+{
+    if (!m_running) {
+        return;
+    }
+    m_upgrade.stopUpgrade();
+    finish(Status::Cancelled, tr("升级已取消"));
+}
+
+void UpgradeSession::onConnectionStateChanged(bool connected)
+{
+    if (!m_running) {
+        return;
+    }
+    if (connected && !m_upgrading) {
+        m_connectTimer.stop();
+        beginUpgrade();
+    } else if (!connected && m_upgrading) {
+        m_upgrade.stopUpgrade();
+        finish(Status::LinkError, tr("%1 链路断开").arg(m_target.name()));
+    }
+}
+
+void UpgradeSession::onLinkError(const QString &message)
+{
+    if (!m_running) {
+        return;
+    }
+    // 连接建立前的错误，或升级中链路已关闭，都结束会话
+    const bool open = m_target.link == CommunicationManager::LinkType::Serial
+                          ? m_comm.isSerialPortOpen()
+                          : m_comm.isTcpConnected();
+    if (!m_upgrading || !open) {
+        m_upgrade.stopUpgrade();
+        finish(Status::LinkError, tr("%1：%2").arg(m_target.name(), message));
+    }
+}
+
+void UpgradeSession::beginUpgrade()
+{
+    if (!m_target.capturePath.isEmpty()) {
+        QString errorString;
+        if (!m_comm.startCapture(m_target.capturePath, &errorString)) {
+            emit showInfo(tr("无法创建抓包文件：%1").arg(errorString));
+        }
+    }
+
+    // 启动失败的原因由 showInfo 给出，这里记录最后一条作为结果信息
+    QString reason;
+    const QMetaObject::Connection capture = connect(&m_upgrade, &UpgradeManager::showInfo, this,
+                                                    [&reason](const QString &text) { reason = text; });
+    m_upgrading = m_upgrade.startUpgrade(m_target.slaveId, m_target.packetSize,
+                                         !m_target.fpgaPath.isEmpty(), !m_target.dsp1Path.isEmpty(),
+                                         !m_target.dsp2Path.isEmpty(), !m_target.armPath.isEmpty(),
+                                         m_target.fpgaPath, m_target.dsp1Path,
+                                         m_target.dsp2Path, m_target.armPath);
+    disconnect(capture);
+
+    if (!m_upgrading) {
+        finish(Status::InvalidImage, reason);
+    }
+}
+
+void UpgradeSession::finish(Status status, const QString &message)
+{
+    if (!m_running) {
+        return;
+    }
+    m_running = false;
+    m_upgrading = false;
+    m_connectTimer.stop();
+
+    // 结果可能在接收处理中途得出，关闭链路推迟到事件循环
+    QMetaObject::invokeMethod(this, [this, status, message]() {
+        m_comm.stopCapture();
+        if (m_target.link == CommunicationManager::LinkType::Serial) {
+            m_comm.closeSerialPort();
+        } else {
+            m_comm.closeTcpConnection();
+        }
+        emit finished(status, message);
+    }, Qt::QueuedConnection);
+}
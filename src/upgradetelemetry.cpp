@@ -0,0 +1,281 @@
+#include "inc/upgradetelemetry.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QtAlgorithms>
+#include <cmath>
+
+namespace {
+double toMs(qint64 us)
+{
+    return us / 1000.0;
+}
+
+QJsonObject histogramToJson(const LatencyHistogram &histogram)
+{
+    QJsonArray buckets;
+    for (int i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+        if (histogram.bucketCount(i) == 0) {
+            continue;
+        }
+        QJsonObject bucket;
+        bucket["le_us"] = i == LatencyHistogram::BUCKETS - 1 ? histogram.max() : LatencyHistogram::bucketUpperBound(i);
+        bucket["count"] = static_cast<qint64>(histogram.bucketCount(i));
+        buckets.append(bucket);
+    }
+
+    QJsonObject json;
+    json["count"] = static_cast<qint64>(histogram.count());
+    json["min_us"] = histogram.min();
+    json["mean_us"] = histogram.mean();
+    json["p50_us"] = histogram.percentile(0.50);
+    json["p90_us"] = histogram.percentile(0.90);
+    json["p99_us"] = histogram.percentile(0.99);
+    json["max_us"] = histogram.max();
+    json["buckets"] = buckets;
+    return json;
+}
+
+QJsonObject phasesToJson(const UpgradeTelemetry::PhaseDurations &phaseUs, bool deviceOnly)
+{
+    QJsonObject json;
+    for (int i = 0; i < UpgradeTelemetry::PHASE_COUNT; ++i) {
+        const auto phase = static_cast<UpgradeTelemetry::Phase>(i);
+        if (deviceOnly && phase != UpgradeTelemetry::Phase::Erase &&
+            phase != UpgradeTelemetry::Phase::Data && phase != UpgradeTelemetry::Phase::End) {
+            continue;
+        }
+        json[UpgradeTelemetry::phaseName(phase)] = toMs(phaseUs[i]);
+    }
+    return json;
+}
+
+QString formatRtt(const LatencyHistogram &histogram)
+{
+    if (histogram.count() == 0) {
+        return QStringLiteral("无样本");
+    }
+    return QStringLiteral("p50 %1 / p90 %2 / p99 %3 / max %4 ms")
+        .arg(toMs(histogram.percentile(0.50)), 0, 'f', 2)
+        .arg(toMs(histogram.percentile(0.90)), 0, 'f', 2)
+        .arg(toMs(histogram.percentile(0.99)), 0, 'f', 2)
+        .arg(toMs(histogram.max()), 0, 'f', 2);
+}
+}
+
+// ============= 延迟直方图 =============
+
+void LatencyHistogram::add(qint64 us)
+{
+    us = qMax<qint64>(us, 0);
+
+    // 第 i 桶对应 us 的二进制位数
+    const int bits = us > 0 ? 64 - qCountLeadingZeroBits(static_cast<quint64>(us)) : 0;
+    m_buckets[qMin(bits, BUCKETS - 1)]++;
+
+    if (m_count == 0 || us < m_min) {
+        m_min = us;
+    }
+    m_max = qMax(m_max, us);
+    m_sum += us;
+    m_count++;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (other.m_count == 0) {
+        return;
+    }
+    for (int i = 0; i < BUCKETS; ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_min = m_count == 0 ? other.m_min : qMin(m_min, other.m_min);
+    m_max = qMax(m_max, other.m_max);
+    m_sum += other.m_sum;
+    m_count += other.m_count;
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+
+    const quint64 target = qMax<quint64>(1, static_cast<quint64>(std::ceil(qBound(0.0, p, 1.0) * m_count)));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKETS - 1; ++i) {
+        seen += m_buckets[i];
+        if (seen >= target) {
+            return qMin(bucketUpperBound(i), m_max);
+        }
+    }
+    return m_max;
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int bucket)
+{
+    return qint64(1) << bucket;
+}
+
+// ============= 升级统计 =============
+
+QString UpgradeTelemetry::phaseName(Phase phase)
+{
+    switch (phase) {
+        case Phase::Request: return QStringLiteral("request");
+        case Phase::Reset: return QStringLiteral("reset");
+        case Phase::Erase: return QStringLiteral("erase");
+        case Phase::Data: return QStringLiteral("data");
+        case Phase::End: return QStringLiteral("end");
+        case Phase::TotalEnd: return QStringLiteral("total_end");
+        case Phase::Count: break;
+    }
+    return QString();
+}
+
+double UpgradeTelemetry::Device::goodput() const
+{
+    const qint64 dataUs = phaseUs[static_cast<int>(Phase::Data)];
+    return dataUs > 0 ? fileSize * 1e6 / dataUs : 0.0;
+}
+
+double UpgradeTelemetry::Device::compressionRatio() const
+{
+    return wireBytes > 0 ? static_cast<double>(payloadBytes) / wireBytes : 1.0;
+}
+
+double UpgradeTelemetry::Device::wireThroughput() const
+{
+    const qint64 dataUs = phaseUs[static_cast<int>(Phase::Data)];
+    return dataUs > 0 ? wireBytes * 1e6 / dataUs : 0.0;
+}
+
+double UpgradeTelemetry::goodput() const
+{
+    quint64 bytes = 0;
+    for (const Device &device : devices) {
+        bytes += device.fileSize;
+    }
+    const qint64 dataUs = phaseUs[static_cast<int>(Phase::Data)];
+    return dataUs > 0 ? bytes * 1e6 / dataUs : 0.0;
+}
+
+QStringList UpgradeTelemetry::summary() const
+{
+    auto phaseMs = [](const PhaseDurations &durations, Phase phase) {
+        return toMs(durations[static_cast<int>(phase)]);
+    };
+
+    QStringList lines;
+    lines << QStringLiteral("升级统计：总耗时 %1 s，分包 %2 字节，窗口 %3%4")
+                 .arg(toMs(totalUs) / 1000.0, 0, 'f', 2)
+                 .arg(packetSize)
+                 .arg(windowSize)
+                 .arg(extended ? QStringLiteral("，扩展寻址") : QString());
+    if (resumedPackets > 0) {
+        lines << QStringLiteral("  断点续传：跳过已确认的 %1 包").arg(resumedPackets);
+    }
+    lines << QStringLiteral("  阶段(ms)：请求 %1  复位 %2  擦除 %3  数据 %4  结束 %5  总体结束 %6")
+                 .arg(phaseMs(phaseUs, Phase::Request), 0, 'f', 1)
+                 .arg(phaseMs(phaseUs, Phase::Reset), 0, 'f', 1)
+                 .arg(phaseMs(phaseUs, Phase::Erase), 0, 'f', 1)
+                 .arg(phaseMs(phaseUs, Phase::Data), 0, 'f', 1)
+                 .arg(phaseMs(phaseUs, Phase::End), 0, 'f', 1)
+                 .arg(phaseMs(phaseUs, Phase::TotalEnd), 0, 'f', 1);
+
+    for (const Device &device : devices) {
+        lines << QStringLiteral("  %1：%2 字节 / %3 包，擦除 %4 ms，数据 %5 ms，结束 %6 ms，有效吞吐 %7 KB/s")
+                     .arg(device.name)
+                     .arg(device.fileSize)
+                     .arg(device.packetCount)
+                     .arg(phaseMs(device.phaseUs, Phase::Erase), 0, 'f', 1)
+                     .arg(phaseMs(device.phaseUs, Phase::Data), 0, 'f', 1)
+                     .arg(phaseMs(device.phaseUs, Phase::End), 0, 'f', 1)
+                     .arg(device.goodput() / 1024.0, 0, 'f', 1);
+        if (device.delta) {
+            lines << QStringLiteral("    差分升级：传输 %1/%2 块，%3 字节（文件的 %4%）")
+                         .arg(device.deltaPackets)
+                         .arg(device.packetCount)
+                         .arg(device.transferBytes)
+                         .arg(device.fileSize > 0 ? device.transferBytes * 100.0 / device.fileSize : 0.0, 0, 'f', 1);
+        }
+        if (device.compressed) {
+            lines << QStringLiteral("    压缩传输：数据 %1 字节，上线 %2 字节，压缩比 %3，链路吞吐 %4 KB/s")
+                         .arg(device.payloadBytes)
+                         .arg(device.wireBytes)
+                         .arg(device.compressionRatio(), 0, 'f', 2)
+                         .arg(device.wireThroughput() / 1024.0, 0, 'f', 1);
+        }
+        lines << QStringLiteral("    RTT %1，重传 %2（快速 %3），超时 %4")
+                     .arg(formatRtt(device.rtt))
+                     .arg(device.retransmits)
+                     .arg(device.fastRetransmits)
+                     .arg(device.timeouts);
+    }
+
+    lines << QStringLiteral("  合计：RTT %1，重传 %2，超时 %3，有效吞吐 %4 KB/s")
+                 .arg(formatRtt(rtt))
+                 .arg(retransmits)
+                 .arg(timeouts)
+                 .arg(goodput() / 1024.0, 0, 'f', 1);
+
+    quint64 payloadBytes = 0;
+    quint64 wireBytes = 0;
+    bool compressed = false;
+    for (const Device &device : devices) {
+        payloadBytes += device.payloadBytes;
+        wireBytes += device.wireBytes;
+        compressed = compressed || device.compressed;
+    }
+    if (compressed && wireBytes > 0) {
+        lines << QStringLiteral("  压缩合计：数据 %1 字节，上线 %2 字节，压缩比 %3")
+                     .arg(payloadBytes)
+                     .arg(wireBytes)
+                     .arg(static_cast<double>(payloadBytes) / wireBytes, 0, 'f', 2);
+    }
+    return lines;
+}
+
+QJsonObject UpgradeTelemetry::toJson() const
+{
+    QJsonArray deviceArray;
+    for (const Device &device : devices) {
+        QJsonObject json;
+        json["name"] = device.name;
+        json["file_size"] = static_cast<qint64>(device.fileSize);
+        json["packet_count"] = static_cast<qint64>(device.packetCount);
+        json["packet_size"] = device.packetSize;
+        json["delta"] = device.delta;
+        json["delta_packets"] = static_cast<qint64>(device.deltaPackets);
+        json["transfer_bytes"] = static_cast<qint64>(device.transferBytes);
+        json["compressed"] = device.compressed;
+        json["payload_bytes"] = static_cast<qint64>(device.payloadBytes);
+        json["wire_bytes"] = static_cast<qint64>(device.wireBytes);
+        json["compression_ratio"] = device.compressionRatio();
+        json["wire_bps"] = device.wireThroughput();
+        json["phases_ms"] = phasesToJson(device.phaseUs, true);
+        json["rtt"] = histogramToJson(device.rtt);
+        json["packets_sent"] = static_cast<qint64>(device.packetsSent);
+        json["retransmits"] = static_cast<qint64>(device.retransmits);
+        json["fast_retransmits"] = static_cast<qint64>(device.fastRetransmits);
+        json["timeouts"] = static_cast<qint64>(device.timeouts);
+        json["goodput_bps"] = device.goodput();
+        deviceArray.append(json);
+    }
+
+    QJsonObject json;
+    json["start_time"] = QDateTime::fromMSecsSinceEpoch(startTime).toString(Qt::ISODateWithMs);
+    json["success"] = success;
+    json["message"] = message;
+    json["total_ms"] = toMs(totalUs);
+    json["packet_size"] = packetSize;
+    json["window_size"] = windowSize;
+    json["extended"] = extended;
+    json["phases_ms"] = phasesToJson(phaseUs, false);
+    json["rtt"] = histogramToJson(rtt);
+    json["retransmits"] = static_cast<qint64>(retransmits);
+    json["timeouts"] = static_cast<qint64>(timeouts);
+    json["resumed_packets"] = static_cast<qint64>(resumedPackets);
+    json["goodput_bps"] = goodput();
+    json["devices"] = deviceArray;
+    return json;
+}
@@ -0,0 +1,18 @@
+# CRC16-MODBUS 微基准测试（逐位 / 查表 / slice-by-8）
+QT -= gui
+QT += core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = bench_crc
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    main.cpp \
+    ../../src/crc16.cpp
+
+HEADERS += \
+    ../../inc/crc16.h
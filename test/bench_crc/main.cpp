@@ -0,0 +1,136 @@
+// CRC16-MODBUS 微基准测试
+// 用法: bench_crc [镜像大小MB，默认16] [轮数，默认5]
+#include "inc/crc16.h"
+#include <QElapsedTimer>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+// 原实现：逐位移位，作为基准和正确性对照
+quint16 crcBitwise(const quint8 *data, qsizetype len)
+{
+    quint16 crc = 0xFFFF;
+    for (qsizetype i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            if (crc & 0x0001) {
+                crc = (crc >> 1) ^ 0xA001;
+            } else {
+                crc >>= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+quint16 crcTable(const quint8 *data, qsizetype len)
+{
+    return Crc16::updateTable(Crc16::INIT, data, len);
+}
+
+quint16 crcSlice8(const quint8 *data, qsizetype len)
+{
+    return Crc16::calculate(data, len);
+}
+
+// 按1024字节分包增量计算，模拟边加载边校验
+quint16 crcSlice8Chunked(const quint8 *data, qsizetype len)
+{
+    quint16 crc = Crc16::INIT;
+    for (qsizetype offset = 0; offset < len; offset += 1024) {
+        crc = Crc16::update(crc, data + offset, qMin<qsizetype>(1024, len - offset));
+    }
+    return crc;
+}
+
+// 生成类似FPGA比特流的数据：大段0x00/0xFF填充 + 重复配置帧 + 随机数据
+std::vector<quint8> makeBitstream(qsizetype size)
+{
+    std::vector<quint8> image(static_cast<size_t>(size));
+    quint32 seed = 0x12345678;
+    qsizetype i = 0;
+    while (i < size) {
+        seed = seed * 1664525u + 1013904223u;
+        const qsizetype run = qMin<qsizetype>(64 + (seed >> 20) % 4096, size - i);
+        switch ((seed >> 8) % 3) {
+        case 0:
+            std::fill(image.begin() + i, image.begin() + i + run, quint8(0xFF));
+            break;
+        case 1:
+            std::fill(image.begin() + i, image.begin() + i + run, quint8(0x00));
+            break;
+        default:
+            for (qsizetype k = 0; k < run; ++k) {
+                seed = seed * 1664525u + 1013904223u;
+                image[static_cast<size_t>(i + k)] = static_cast<quint8>(seed >> 24);
+            }
+            break;
+        }
+        i += run;
+    }
+    return image;
+}
+
+struct Result {
+    quint16 crc;
+    double mbPerSec;
+};
+
+Result run(const char *name, quint16 (*fn)(const quint8 *, qsizetype),
+           const std::vector<quint8> &image, int rounds)
+{
+    const qsizetype size = static_cast<qsizetype>(image.size());
+    quint16 crc = 0;
+    qint64 bestNs = -1;
+    for (int r = 0; r < rounds; ++r) {
+        QElapsedTimer timer;
+        timer.start();
+        crc = fn(image.data(), size);
+        const qint64 ns = timer.nsecsElapsed();
+        if (bestNs < 0 || ns < bestNs) {
+            bestNs = ns;
+        }
+    }
+    const double mbPerSec = (static_cast<double>(size) / (1024.0 * 1024.0)) /
+                            (static_cast<double>(qMax<qint64>(bestNs, 1)) / 1e9);
+    std::printf("%-20s crc=0x%04X  %10.1f MB/s  %8.2f ms\n",
+                name, crc, mbPerSec, static_cast<double>(bestNs) / 1e6);
+    return {crc, mbPerSec};
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    const int sizeMB = argc > 1 ? std::atoi(argv[1]) : 16;
+    const int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+    if (sizeMB <= 0 || rounds <= 0) {
+        std::fprintf(stderr, "usage: bench_crc [sizeMB] [rounds]\n");
+        return 2;
+    }
+
+    // MODBUS 标准测试向量
+    if (Crc16::calculate("123456789", 9) != 0x4B37) {
+        std::fprintf(stderr, "check value mismatch\n");
+        return 1;
+    }
+
+    const std::vector<quint8> image = makeBitstream(static_cast<qsizetype>(sizeMB) * 1024 * 1024);
+    std::printf("image: %d MB, best of %d rounds\n", sizeMB, rounds);
+
+    const Result bitwise = run("bitwise", crcBitwise, image, rounds);
+    const Result table = run("table", crcTable, image, rounds);
+    const Result slice8 = run("slice-by-8", crcSlice8, image, rounds);
+    const Result chunked = run("slice-by-8 (1K)", crcSlice8Chunked, image, rounds);
+
+    if (table.crc != bitwise.crc || slice8.crc != bitwise.crc || chunked.crc != bitwise.crc) {
+        std::fprintf(stderr, "CRC mismatch between implementations\n");
+        return 1;
+    }
+
+    std::printf("speedup vs bitwise: table %.1fx, slice-by-8 %.1fx\n",
+                table.mbPerSec / bitwise.mbPerSec, slice8.mbPerSec / bitwise.mbPerSec);
+    return 0;
+}
@@ -0,0 +1,42 @@
+# 端到端升级吞吐基准测试（UpgradeManager + CommunicationManager 对接本机 DeviceSimulator）
+QT -= gui
+QT += core network serialport concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = bench_upgrade
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    main.cpp \
+    ../devicesim/devicesimulator.cpp \
+    ../../src/protocol.cpp \
+    ../../src/crc16.cpp \
+    ../../src/lz4.cpp \
+    ../../src/framedecoder.cpp \
+    ../../src/transferplan.cpp \
+    ../../src/firmwareimage.cpp \
+    ../../src/sessioncapture.cpp \
+    ../../src/communication.cpp \
+    ../../src/timerwheel.cpp \
+    ../../src/upgradejournal.cpp \
+    ../../src/upgradetelemetry.cpp \
+    ../../src/upgrade.cpp
+
+HEADERS += \
+    ../devicesim/devicesimulator.h \
+    ../../inc/protocol.h \
+    ../../inc/crc16.h \
+    ../../inc/lz4.h \
+    ../../inc/framedecoder.h \
+    ../../inc/transferplan.h \
+    ../../inc/firmwareimage.h \
+    ../../inc/sessioncapture.h \
+    ../../inc/communication.h \
+    ../../inc/timerwheel.h \
+    ../../inc/upgradejournal.h \
+    ../../inc/upgradetelemetry.h \
+    ../../inc/upgrade.h
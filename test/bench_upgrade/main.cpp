@@ -0,0 +1,365 @@
+// 端到端升级吞吐基准测试
+// 用法: bench_upgrade [--packet-sizes 1024,2048,4096] [--image-kb 256,1024] [--rtt-ms 0,2,10]
+//                     [--loss 0,0.01] [--window 1] [--write-kbps 0] [--repeat 1] [--out result.json]
+//
+// UpgradeManager + CommunicationManager 通过本机TCP连接对接运行在独立线程中的 DeviceSimulator，
+// 按参数组合逐个完成一次ARM升级，结果以JSON输出：墙钟时间、有效吞吐、每MB占用的上位机CPU时间。
+#include "inc/communication.h"
+#include "inc/upgrade.h"
+#include "test/devicesim/devicesimulator.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QTimer>
+#include <cstdio>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace {
+
+constexpr int CONNECT_TIMEOUT_MS = 5000;
+constexpr quint8 SLAVE_ID = 1;
+
+struct Scenario {
+    int packetSize = 1024;
+    qint64 imageBytes = 0;
+    double rttMs = 0.0;
+    double loss = 0.0;
+    int window = 1;
+};
+
+#ifdef Q_OS_WIN
+qint64 fileTimeNs(const FILETIME &time)
+{
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return static_cast<qint64>(value.QuadPart) * 100;
+}
+#endif
+
+// 本进程所有线程的CPU时间（用户+内核）
+qint64 processCpuNs()
+{
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+    return fileTimeNs(kernel) + fileTimeNs(user);
+#else
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+// 调用线程的CPU时间
+qint64 threadCpuNs()
+{
+#ifdef Q_OS_WIN
+    FILETIME creation, exit, kernel, user;
+    GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user);
+    return fileTimeNs(kernel) + fileTimeNs(user);
+#else
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return qint64(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+QList<double> parseList(const QString &text)
+{
+    QList<double> values;
+    for (const QString &item : text.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        values.append(item.trimmed().toDouble());
+    }
+    return values;
+}
+
+/**
+ * @brief 在独立线程中运行的模拟器TCP服务器，每个连接一个 DeviceSimulator
+ */
+class SimulatorHost
+{
+public:
+    SimulatorHost()
+    {
+        thread.setObjectName(QStringLiteral("DeviceSimulator"));
+        thread.start();
+        context.moveToThread(&thread);
+        run([this]() {
+            server = new QTcpServer(&context);
+            server->listen(QHostAddress::LocalHost, 0);
+            QObject::connect(server, &QTcpServer::newConnection, &context, [this]() {
+                while (QTcpSocket *socket = server->nextPendingConnection()) {
+                    socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+                    auto *simulator = new DeviceSimulator(config, socket);
+                    QObject::connect(socket, &QTcpSocket::readyRead, simulator, [socket, simulator]() {
+                        simulator->receive(socket->readAll());
+                    });
+                    QObject::connect(simulator, &DeviceSimulator::transmit, socket, [socket](const QByteArray &data) {
+                        socket->write(data);
+                    });
+                    QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+                }
+            });
+        });
+    }
+
+    ~SimulatorHost()
+    {
+        run([this]() { delete server; });
+        thread.quit();
+        thread.wait();
+    }
+
+    quint16 port()
+    {
+        quint16 value = 0;
+        run([this, &value]() { value = server->serverPort(); });
+        return value;
+    }
+
+    // 之后建立的连接使用该参数
+    void setConfig(const SimulatorConfig &value)
+    {
+        run([this, value]() { config = value; });
+    }
+
+    // 模拟器线程的CPU时间
+    qint64 cpuNs()
+    {
+        qint64 value = 0;
+        run([&value]() { value = threadCpuNs(); });
+        return value;
+    }
+
+private:
+    template <typename Function>
+    void run(Function function)
+    {
+        QMetaObject::invokeMethod(&context, function, Qt::BlockingQueuedConnection);
+    }
+
+    QThread thread;
+    QObject context;
+    QTcpServer *server = nullptr;
+    SimulatorConfig config;
+};
+
+QJsonObject runScenario(const Scenario &scenario, SimulatorHost &simulator, const QString &imagePath, int writeKBps, quint32 seed)
+{
+    SimulatorConfig config;
+    config.linkLatencyUs = static_cast<int>(scenario.rttMs * 500.0);   // 往返时延的一半
+    config.resetMs = 0;
+    config.eraseBaseMs = 0;
+    config.writeKBps = writeKBps;
+    config.lossRate = scenario.loss;
+    config.replyLossRate = scenario.loss;
+    config.lossDataOnly = true;
+    config.seed = seed;
+    simulator.setConfig(config);
+
+    QJsonObject result;
+    result["packet_size"] = scenario.packetSize;
+    result["image_bytes"] = scenario.imageBytes;
+    result["rtt_ms"] = scenario.rttMs;
+    result["loss"] = scenario.loss;
+    result["window"] = scenario.window;
+
+    CommunicationManager comm;
+    comm.setActiveLink(CommunicationManager::LinkType::Ethernet);
+
+    QEventLoop loop;
+    QObject::connect(&comm, &CommunicationManager::connectionStateChanged, &loop, &QEventLoop::quit);
+    QObject::connect(&comm, &CommunicationManager::tcpError, &loop, &QEventLoop::quit);
+    QTimer connectTimer;
+    connectTimer.setSingleShot(true);
+    QObject::connect(&connectTimer, &QTimer::timeout, &loop, &QEventLoop::quit);
+    connectTimer.start(CONNECT_TIMEOUT_MS);
+    comm.openTcpConnection(QStringLiteral("127.0.0.1"), simulator.port());
+    loop.exec();
+    connectTimer.stop();
+    if (!comm.isTcpConnected()) {
+        result["success"] = false;
+        result["message"] = QStringLiteral("cannot connect to simulator");
+        return result;
+    }
+    QObject::disconnect(&comm, nullptr, &loop, nullptr);
+
+    UpgradeManager upgrade;
+    upgrade.setWindowSize(scenario.window);
+
+    // 与 LinkWorker 相同：应答 -> 状态机 -> 下一包 直接调用
+    QObject::connect(&comm, &CommunicationManager::frameReceived, &upgrade, [&upgrade](const BootLoaderProtocol::Frame &frame) {
+        upgrade.handleResponse(frame.type, frame.flag, frame.payload);
+    }, Qt::DirectConnection);
+    QObject::connect(&upgrade, &UpgradeManager::sendData, &comm, [&comm](const QByteArray &data, const QString &) {
+        comm.sendData(data);
+    });
+
+    UpgradeTelemetry telemetry;
+    bool success = false;
+    QString message;
+    QObject::connect(&upgrade, &UpgradeManager::telemetryReady, &loop, [&telemetry](const UpgradeTelemetry &value) {
+        telemetry = value;
+    });
+    QObject::connect(&upgrade, &UpgradeManager::upgradeFinished, &loop, [&](bool ok, const QString &text) {
+        success = ok;
+        message = text;
+        loop.quit();
+    });
+
+    const qint64 simulatorCpuStart = simulator.cpuNs();
+    const qint64 cpuStart = processCpuNs();
+    QElapsedTimer wall;
+    wall.start();
+
+    if (upgrade.startUpgrade(SLAVE_ID, scenario.packetSize, false, false, false, true,
+                             QString(), QString(), QString(), imagePath)) {
+        loop.exec();
+    } else {
+        message = QStringLiteral("upgrade did not start");
+    }
+
+    const qint64 wallNs = wall.nsecsElapsed();
+    const qint64 simulatorCpuNs = simulator.cpuNs() - simulatorCpuStart;
+    // 进程CPU时间减去模拟器线程，即上位机（含后台CRC计算）的CPU时间
+    const qint64 hostCpuNs = processCpuNs() - cpuStart - simulatorCpuNs;
+    const double megabytes = scenario.imageBytes / (1024.0 * 1024.0);
+
+    comm.closeTcpConnection();
+
+    result["success"] = success;
+    if (!success) {
+        result["message"] = message;
+    }
+    result["wall_ms"] = wallNs / 1e6;
+    result["goodput_bps"] = wallNs > 0 ? scenario.imageBytes * 1e9 / wallNs : 0.0;
+    result["data_goodput_bps"] = telemetry.goodput();
+    result["cpu_ms"] = hostCpuNs / 1e6;
+    result["cpu_ms_per_mb"] = megabytes > 0 ? hostCpuNs / 1e6 / megabytes : 0.0;
+    result["simulator_cpu_ms"] = simulatorCpuNs / 1e6;
+    result["retransmits"] = static_cast<qint64>(telemetry.retransmits);
+    result["timeouts"] = static_cast<qint64>(telemetry.timeouts);
+    result["rtt_p50_us"] = telemetry.rtt.percentile(0.50);
+    result["rtt_p99_us"] = telemetry.rtt.percentile(0.99);
+    return result;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("End-to-end upgrade throughput benchmark"));
+    parser.addHelpOption();
+    const QCommandLineOption packetOption("packet-sizes", "Packet sizes to sweep.", "list", "1024,2048,4096");
+    const QCommandLineOption imageOption("image-kb", "Image sizes (KB) to sweep.", "list", "256,1024");
+    const QCommandLineOption rttOption("rtt-ms", "Simulated round-trip times (ms) to sweep.", "list", "0,2,10");
+    const QCommandLineOption lossOption("loss", "Data packet loss rates to sweep (each direction).", "list", "0,0.01");
+    const QCommandLineOption windowOption("window", "Sliding window sizes to sweep.", "list", "1");
+    const QCommandLineOption writeOption("write-kbps", "Simulated flash write throughput (KB/s, 0 = unlimited).", "kbps", "0");
+    const QCommandLineOption repeatOption("repeat", "Runs per combination.", "n", "1");
+    const QCommandLineOption outOption("out", "Write JSON to file instead of stdout.", "file");
+    parser.addOptions({packetOption, imageOption, rttOption, lossOption, windowOption, writeOption, repeatOption, outOption});
+    parser.process(app);
+
+    const QList<double> packetSizes = parseList(parser.value(packetOption));
+    const QList<double> imageSizes = parseList(parser.value(imageOption));
+    const QList<double> rtts = parseList(parser.value(rttOption));
+    const QList<double> losses = parseList(parser.value(lossOption));
+    const QList<double> windows = parseList(parser.value(windowOption));
+    const int writeKBps = parser.value(writeOption).toInt();
+    const int repeat = qMax(1, parser.value(repeatOption).toInt());
+
+    // 固定种子生成镜像内容，各次运行结果可比较
+    QTemporaryDir imageDir;
+    if (!imageDir.isValid()) {
+        std::fprintf(stderr, "cannot create temporary directory\n");
+        return 1;
+    }
+    QMap<qint64, QString> images;
+    QRandomGenerator generator(0x5EED);
+    for (double kb : imageSizes) {
+        const qint64 bytes = static_cast<qint64>(kb * 1024);
+        QByteArray content(bytes, '\0');
+        generator.fillRange(reinterpret_cast<quint32 *>(content.data()), bytes / 4);
+        const QString path = imageDir.filePath(QStringLiteral("image_%1.bin").arg(bytes));
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly) || file.write(content) != bytes) {
+            std::fprintf(stderr, "cannot write %s\n", qPrintable(path));
+            return 1;
+        }
+        images.insert(bytes, path);
+    }
+
+    SimulatorHost simulator;
+    QJsonArray results;
+    bool allPassed = true;
+    quint32 seed = 1;
+
+    for (double packetSize : packetSizes) {
+        for (auto image = images.cbegin(); image != images.cend(); ++image) {
+            for (double rtt : rtts) {
+                for (double loss : losses) {
+                    for (double window : windows) {
+                        Scenario scenario;
+                        scenario.packetSize = static_cast<int>(packetSize);
+                        scenario.imageBytes = image.key();
+                        scenario.rttMs = rtt;
+                        scenario.loss = loss;
+                        scenario.window = static_cast<int>(window);
+
+                        for (int run = 0; run < repeat; ++run) {
+                            const QJsonObject result = runScenario(scenario, simulator, image.value(), writeKBps, seed++);
+                            allPassed = allPassed && result["success"].toBool();
+                            std::fprintf(stderr, "packet %5d  image %8lld  rtt %5.1f ms  loss %.3f  window %2d  %8.1f ms  %8.1f KB/s  %s\n",
+                                         scenario.packetSize, static_cast<long long>(scenario.imageBytes),
+                                         scenario.rttMs, scenario.loss, scenario.window,
+                                         result["wall_ms"].toDouble(), result["goodput_bps"].toDouble() / 1024.0,
+                                         result["success"].toBool() ? "ok" : "FAILED");
+                            results.append(result);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    QJsonObject report;
+    report["benchmark"] = QStringLiteral("bench_upgrade");
+    report["qt_version"] = QString::fromLatin1(qVersion());
+    report["timestamp"] = QDateTime::currentDateTime().toString(Qt::ISODate);
+    report["write_kbps"] = writeKBps;
+    report["results"] = results;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (parser.isSet(outOption)) {
+        QFile out(parser.value(outOption));
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate) || out.write(json) != json.size()) {
+            std::fprintf(stderr, "cannot write %s\n", qPrintable(out.fileName()));
+            return 1;
+        }
+    } else {
+        std::fwrite(json.constData(), 1, static_cast<size_t>(json.size()), stdout);
+    }
+
+    return allPassed ? 0 : 2;
+}
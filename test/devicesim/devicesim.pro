@@ -0,0 +1,26 @@
+# 下位机模拟器（TCP服务器，可同时模拟多个连接和从机ID）
+QT -= gui
+QT += core network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = devicesim
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    main.cpp \
+    devicesimulator.cpp \
+    ../../src/protocol.cpp \
+    ../../src/crc16.cpp \
+    ../../src/lz4.cpp \
+    ../../src/framedecoder.cpp
+
+HEADERS += \
+    devicesimulator.h \
+    ../../inc/protocol.h \
+    ../../inc/crc16.h \
+    ../../inc/lz4.h \
+    ../../inc/framedecoder.h
@@ -0,0 +1,389 @@
+#include "devicesimulator.h"
+#include "inc/lz4.h"
+#include <QTimer>
+#include <iterator>
+
+namespace {
+using MessageType = BootLoaderProtocol::MessageType;
+using ResponseFlag = BootLoaderProtocol::ResponseFlag;
+
+// 调试报文随机使用的标识（只影响上位机信息显示）
+constexpr ResponseFlag DEBUG_FLAGS[] = {
+    ResponseFlag::FPGA_READY,
+    ResponseFlag::FPGA_CHECK_PASS,
+    ResponseFlag::START_APP,
+    ResponseFlag::DSP_VERSION
+};
+
+bool isCommand(MessageType type)
+{
+    return type == MessageType::ARM_COMMAND || type == MessageType::FPGA_COMMAND ||
+           type == MessageType::DSP1_COMMAND || type == MessageType::DSP2_COMMAND;
+}
+
+bool isData(MessageType type)
+{
+    return type == MessageType::ARM_DATA || type == MessageType::FPGA_DATA ||
+           type == MessageType::DSP1_DATA || type == MessageType::DSP2_DATA ||
+           type == MessageType::DELTA_DATA || type == MessageType::COMPRESSED_DATA;
+}
+
+bool isEnd(MessageType type)
+{
+    return type == MessageType::ARM_END || type == MessageType::FPGA_END ||
+           type == MessageType::DSP1_END || type == MessageType::DSP2_END;
+}
+
+// 命令类型的下一个值就是同一设备的数据类型
+MessageType dataTypeFor(MessageType command)
+{
+    return static_cast<MessageType>(static_cast<quint8>(command) + 1);
+}
+
+quint16 installedKey(quint8 slaveId, MessageType dataType)
+{
+    return static_cast<quint16>((slaveId << 8) | static_cast<quint8>(dataType));
+}
+
+quint64 readBigEndian(QByteArrayView bytes, qsizetype size)
+{
+    quint64 value = 0;
+    for (qsizetype i = 0; i < size; ++i) {
+        value = (value << 8) | static_cast<quint8>(bytes[i]);
+    }
+    return value;
+}
+
+void appendBigEndian(QByteArray &out, quint32 value, qsizetype size)
+{
+    for (qsizetype i = size - 1; i >= 0; --i) {
+        out.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+}
+
+DeviceSimulator::DeviceSimulator(const SimulatorConfig &config, QObject *parent)
+    : QObject(parent)
+    , m_config(config)
+    , m_installed(QSharedPointer<InstalledImages>::create())
+    , m_rng(config.seed)
+    , m_uniform(0.0, 1.0)
+{
+    m_clock.start();
+}
+
+void DeviceSimulator::receive(QByteArrayView data)
+{
+    while (!data.isEmpty()) {
+        const qsizetype written = m_decoder.write(data.data(), data.size());
+        data = data.sliced(written);
+
+        QByteArrayView raw;
+        while (m_decoder.nextFrame(raw)) {
+            BootLoaderProtocol::Frame frame;
+            if (!BootLoaderProtocol::parseFrame(raw, frame)) {
+                m_stats.crcErrors++;
+                continue;
+            }
+            handleFrame(frame);
+        }
+    }
+}
+
+void DeviceSimulator::handleFrame(const BootLoaderProtocol::Frame &frame)
+{
+    m_stats.framesReceived++;
+    if (lossApplies(frame.type) && chance(m_config.lossRate)) {
+        m_stats.framesLost++;
+        return;
+    }
+
+    Device &device = m_devices[frame.slaveId];
+
+    if (chance(m_config.debugRate)) {
+        const ResponseFlag flag = DEBUG_FLAGS[m_rng() % std::size(DEBUG_FLAGS)];
+        m_stats.debugFrames++;
+        sendAfter(m_config.linkLatencyUs * 2, m_protocol.buildDebugInfo(frame.slaveId, flag));
+    }
+
+    const QByteArray status(1, 0x00);
+
+    switch (frame.type) {
+        case MessageType::UPGRADE_REQUEST: {
+            const quint8 flags = frame.payload.isEmpty() ? 0 : static_cast<quint8>(frame.payload[0]);
+
+            // 请求续传（bit6）时保留上次的升级状态，等待断点续传报文
+            if (!((flags & 0x40) && m_config.resume)) {
+                const qint64 busyUntil = device.busyUntilUs;
+                device = Device();
+                device.busyUntilUs = busyUntil;
+                device.extended = (flags & 0x80) && m_config.extendedAddressing;
+            }
+
+            // 状态 + 能力位（bit0 扩展寻址，bit1 断点续传，bit2 差分升级，bit3 压缩数据包，bit4 滑动窗口）
+            quint8 capabilities = 0;
+            if (m_config.extendedAddressing) {
+                capabilities |= BootLoaderProtocol::CAPABILITY_EXTENDED_ADDRESSING;
+            }
+            if (m_config.resume) {
+                capabilities |= BootLoaderProtocol::CAPABILITY_RESUME;
+            }
+            if (m_config.delta) {
+                capabilities |= BootLoaderProtocol::CAPABILITY_DELTA;
+            }
+            if (m_config.compression) {
+                capabilities |= BootLoaderProtocol::CAPABILITY_COMPRESSION;
+            }
+            if (m_config.window) {
+                capabilities |= BootLoaderProtocol::CAPABILITY_WINDOW;
+            }
+            QByteArray payload = status;
+            payload.append(static_cast<char>(capabilities));
+            reply(device, qint64(m_config.requestMs) * 1000,
+                  m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::ALLOW_UPGRADE, payload));
+            break;
+        }
+        case MessageType::SYSTEM_RESET:
+            reply(device, qint64(m_config.resetMs) * 1000,
+                  m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::RESTART_SUCCESS, status));
+            break;
+        case MessageType::TOTAL_END:
+            reply(device, qint64(m_config.totalEndMs) * 1000,
+                  m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::SUCCESS, status));
+            m_stats.upgradesCompleted++;
+            emit upgradeFinished(frame.slaveId, true);
+            break;
+        case MessageType::RESUME:
+            handleResume(device, frame);
+            break;
+        case MessageType::DELTA_COMMAND:
+            handleDeltaCommand(device, frame);
+            break;
+        case MessageType::DEBUG_INFO:
+            break;
+        default:
+            if (isCommand(frame.type)) {
+                handleCommand(device, frame);
+            } else if (isData(frame.type)) {
+                handleData(device, frame);
+            } else if (isEnd(frame.type)) {
+                handleEnd(device, frame);
+            }
+            break;
+    }
+}
+
+void DeviceSimulator::handleCommand(Device &device, const BootLoaderProtocol::Frame &frame)
+{
+    // 普通寻址：文件大小(4) + 包数(2) + CRC(2)；扩展寻址：文件大小(8) + 包数(4) + CRC(2)
+    const qsizetype sizeField = device.extended ? 8 : 4;
+    const qsizetype countField = device.extended ? 4 : 2;
+    if (frame.payload.size() < sizeField + countField + 2) {
+        reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::SIZE_ERROR, QByteArray(1, 0x01)));
+        return;
+    }
+
+    device.dataType = dataTypeFor(frame.type);
+    device.delta = false;
+    device.fileSize = readBigEndian(frame.payload, sizeField);
+    device.packetCount = static_cast<quint32>(readBigEndian(frame.payload.sliced(sizeField), countField));
+    device.fileCRC = static_cast<quint16>(readBigEndian(frame.payload.sliced(sizeField + countField), 2));
+    device.contiguous = 0;
+    device.outOfOrder.clear();
+    device.bytesReceived = 0;
+
+    // 先回复准备擦除，擦除完成后回复擦除成功
+    const QByteArray status(1, 0x00);
+    reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::PREPARE_ERASE, status));
+    const qint64 eraseUs = qint64(m_config.eraseBaseMs) * 1000 + throughputUs(device.fileSize, m_config.eraseKBps);
+    reply(device, eraseUs, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::ERASE_SUCCESS, status));
+}
+
+void DeviceSimulator::handleData(Device &device, const BootLoaderProtocol::Frame &frame)
+{
+    // 差分数据包：包序号(4) + 块号(4)，压缩数据包另加原始长度(2)，应答中的两个计数也是4字节
+    const bool compressed = frame.type == MessageType::COMPRESSED_DATA && m_config.compression;
+    const qsizetype numberSize = device.delta || compressed ? 4 : BootLoaderProtocol::packetNumberSize(device.extended);
+    const qsizetype fieldsSize = compressed ? BootLoaderProtocol::COMPRESSED_DATA_FIELDS
+                               : device.delta ? BootLoaderProtocol::DELTA_DATA_FIELDS
+                                              : numberSize;
+    const MessageType expectedType = compressed ? MessageType::COMPRESSED_DATA
+                                   : device.delta ? MessageType::DELTA_DATA
+                                                  : device.dataType;
+    const QByteArray failed(1, 0x01);
+    if (frame.type != expectedType || frame.payload.size() < fieldsSize) {
+        reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::FAILED, failed));
+        return;
+    }
+
+    const quint32 packetNum = static_cast<quint32>(readBigEndian(frame.payload, numberSize));
+    qsizetype dataSize = frame.payload.size() - fieldsSize;
+
+    // 压缩数据包解压后必须正好是原始长度；长度相等时为原始内容
+    if (compressed) {
+        const qsizetype rawSize = static_cast<qsizetype>(readBigEndian(frame.payload.sliced(8), 2));
+        if (dataSize < rawSize) {
+            QByteArray raw(rawSize, Qt::Uninitialized);
+            const QByteArrayView data = frame.payload.sliced(fieldsSize);
+            if (Lz4::decompress(data.data(), data.size(), raw.data(), raw.size()) != rawSize) {
+                reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::FAILED, failed));
+                return;
+            }
+        } else if (dataSize != rawSize) {
+            reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::FAILED, failed));
+            return;
+        }
+        dataSize = rawSize;
+    }
+    m_stats.dataPackets++;
+
+    // 重复包只应答，不再写入
+    const bool duplicate = packetNum == 0 || packetNum <= device.contiguous || device.outOfOrder.contains(packetNum);
+    qint64 processingUs = m_config.dataUs;
+    if (duplicate) {
+        m_stats.duplicatePackets++;
+    } else if (packetNum <= device.packetCount) {
+        device.bytesReceived += dataSize;
+        m_stats.bytesWritten += dataSize;
+        processingUs += throughputUs(dataSize, m_config.writeKBps);
+
+        if (packetNum == device.contiguous + 1) {
+            device.contiguous++;
+            while (device.outOfOrder.remove(device.contiguous + 1)) {
+                device.contiguous++;
+            }
+        } else {
+            device.outOfOrder.insert(packetNum);
+        }
+    }
+
+    // 状态(1) + 包序号 + 从第1包起连续收到的包数
+    QByteArray payload(1, 0x00);
+    appendBigEndian(payload, packetNum, numberSize);
+    appendBigEndian(payload, device.contiguous, numberSize);
+    reply(device, processingUs, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::SUCCESS, payload));
+}
+
+void DeviceSimulator::handleEnd(Device &device, const BootLoaderProtocol::Frame &frame)
+{
+    // 差分升级只收到变化的块，字节数不等于文件大小
+    const bool complete = device.contiguous == device.packetCount &&
+                          (device.delta || device.bytesReceived == device.fileSize);
+    if (complete) {
+        Installed &installed = (*m_installed)[installedKey(frame.slaveId, device.dataType)];
+        installed.fileSize = device.fileSize;
+        installed.fileCRC = device.fileCRC;
+        reply(device, qint64(m_config.endMs) * 1000,
+              m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::UPGRADE_END, QByteArray(1, 0x00)));
+    } else {
+        reply(device, qint64(m_config.endMs) * 1000,
+              m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::SIZE_ERROR, QByteArray(1, 0x01)));
+        m_stats.upgradesFailed++;
+        emit upgradeFinished(frame.slaveId, false);
+    }
+}
+
+void DeviceSimulator::handleResume(Device &device, const BootLoaderProtocol::Frame &frame)
+{
+    // 命令类型(1) + 文件大小(8) + 包数(4) + CRC(2) + 上位机记录的已确认包数(4)
+    const QByteArray failed(1, 0x01);
+    if (!m_config.resume || frame.payload.size() < 19) {
+        reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::FAILED, failed));
+        return;
+    }
+
+    const auto command = static_cast<MessageType>(frame.payload[0]);
+    const quint64 fileSize = readBigEndian(frame.payload.sliced(1), 8);
+    const quint32 packetCount = static_cast<quint32>(readBigEndian(frame.payload.sliced(9), 4));
+    if (!isCommand(command) || device.delta || dataTypeFor(command) != device.dataType ||
+        fileSize != device.fileSize || packetCount != device.packetCount || device.packetCount == 0) {
+        reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::FAILED, failed));
+        return;
+    }
+
+    // 状态 + 从第1包起连续收到的包数，连续范围之后已收到的包保留，重发时按重复包处理
+    QByteArray payload(1, 0x00);
+    appendBigEndian(payload, device.contiguous, 4);
+    reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::SUCCESS, payload));
+}
+
+void DeviceSimulator::handleDeltaCommand(Device &device, const BootLoaderProtocol::Frame &frame)
+{
+    // 命令类型(1) + 基线大小(8) + 基线CRC(2) + 文件大小(8) + 变化块数(4) + 文件CRC(2) + 块大小(2)
+    const QByteArray failed(1, 0x01);
+    if (!m_config.delta || frame.payload.size() < 27) {
+        reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::FAILED, failed));
+        return;
+    }
+
+    const auto command = static_cast<MessageType>(frame.payload[0]);
+    const quint64 baselineSize = readBigEndian(frame.payload.sliced(1), 8);
+    const quint16 baselineCRC = static_cast<quint16>(readBigEndian(frame.payload.sliced(9), 2));
+
+    // 当前固件与上位机的基线不一致时拒绝，上位机改为完整升级
+    const auto installed = m_installed->constFind(installedKey(frame.slaveId, dataTypeFor(command)));
+    if (!isCommand(command) || installed == m_installed->constEnd() ||
+        installed->fileSize != baselineSize || installed->fileCRC != baselineCRC) {
+        reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::FAILED, failed));
+        return;
+    }
+
+    device.dataType = dataTypeFor(command);
+    device.delta = true;
+    device.fileSize = readBigEndian(frame.payload.sliced(11), 8);
+    device.packetCount = static_cast<quint32>(readBigEndian(frame.payload.sliced(19), 4));
+    device.fileCRC = static_cast<quint16>(readBigEndian(frame.payload.sliced(23), 2));
+    device.contiguous = 0;
+    device.outOfOrder.clear();
+    device.bytesReceived = 0;
+
+    // 只擦除变化的块，按基础时间计
+    const QByteArray status(1, 0x00);
+    reply(device, 0, m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::PREPARE_ERASE, status));
+    reply(device, qint64(m_config.eraseBaseMs) * 1000,
+          m_protocol.buildResponse(frame.slaveId, frame.type, ResponseFlag::ERASE_SUCCESS, status));
+}
+
+void DeviceSimulator::reply(Device &device, qint64 processingUs, QByteArray frame)
+{
+    // 报文经过链路到达后排队处理，处理完成后应答再经过链路返回
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+    const qint64 start = qMax(now + m_config.linkLatencyUs, device.busyUntilUs);
+    device.busyUntilUs = start + processingUs;
+
+    if (lossApplies(static_cast<MessageType>(frame[5])) && chance(m_config.replyLossRate)) {
+        m_stats.repliesLost++;
+        return;
+    }
+    if (chance(m_config.corruptRate)) {
+        const quint32 bit = m_rng() % (frame.size() * 8);
+        frame[bit / 8] = static_cast<char>(frame[bit / 8] ^ (1 << (bit % 8)));
+        m_stats.repliesCorrupted++;
+    }
+
+    sendAfter(device.busyUntilUs + m_config.linkLatencyUs - now, std::move(frame));
+}
+
+void DeviceSimulator::sendAfter(qint64 delayUs, QByteArray frame)
+{
+    // 定时器精度为毫秒，向上取整；0 延迟也经过事件循环再发出
+    const int delayMs = static_cast<int>((qMax<qint64>(delayUs, 0) + 999) / 1000);
+    QTimer::singleShot(delayMs, Qt::PreciseTimer, this, [this, frame = std::move(frame)]() {
+        emit transmit(frame);
+    });
+}
+
+bool DeviceSimulator::lossApplies(MessageType type) const
+{
+    return !m_config.lossDataOnly || isData(type);
+}
+
+bool DeviceSimulator::chance(double probability)
+{
+    return probability > 0.0 && m_uniform(m_rng) < probability;
+}
+
+qint64 DeviceSimulator::throughputUs(quint64 bytes, double kbps)
+{
+    return kbps > 0.0 ? static_cast<qint64>(bytes * 1e6 / (kbps * 1024.0)) : 0;
+}
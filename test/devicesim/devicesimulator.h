@@ -0,0 +1,140 @@
+#ifndef DEVICESIMULATOR_H
+#define DEVICESIMULATOR_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <random>
+
+#include "inc/protocol.h"
+#include "inc/framedecoder.h"
+
+/**
+ * @brief 模拟下位机的参数
+ *
+ * 时间参数描述设备处理各类报文所需的时间，链路延迟在收发两个方向各加一次；
+ * 同一从机按到达顺序逐个处理报文，处理时间会排队累积。
+ */
+struct SimulatorConfig {
+    int linkLatencyUs = 0;          // 单向链路延迟
+    int requestMs = 0;              // 升级请求处理时间
+    int resetMs = 500;              // 系统复位（重启进入BootLoader）
+    int eraseBaseMs = 300;          // 擦除Flash基础时间
+    double eraseKBps = 0.0;         // 擦除速度(KB/s)，0 表示只计基础时间
+    int dataUs = 0;                 // 每个数据包的固定处理时间
+    double writeKBps = 0.0;         // Flash写入速度(KB/s)，0 表示不计写入时间
+    int endMs = 0;                  // 升级结束（整体校验/配置）
+    int totalEndMs = 0;             // 总体结束
+    double lossRate = 0.0;          // 上位机报文丢失概率
+    double replyLossRate = 0.0;     // 应答丢失概率
+    bool lossDataOnly = false;      // 只丢弃数据包及其应答（控制报文超时很长，基准测试时不丢）
+    double corruptRate = 0.0;       // 应答中翻转一位的概率（上位机CRC校验失败）
+    double debugRate = 0.0;         // 处理每个报文前插入调试报文的概率
+    bool extendedAddressing = true; // 是否支持扩展寻址
+    bool resume = true;             // 是否支持断点续传（同一链路内保留从机的升级状态）
+    bool delta = true;              // 是否支持差分升级（基线为同一链路内上次成功写入的固件）
+    bool compression = true;        // 是否支持压缩数据包（逐包解压校验长度，写入时间按解压后的字节计）
+    bool window = true;             // 是否支持滑动窗口（缓存乱序数据包，应答连续接收的包数）
+    quint32 seed = 1;               // 随机数种子，相同参数和种子得到相同的丢包序列
+};
+
+/**
+ * @brief 下位机模拟器
+ *
+ * 使用与上位机相同的 BootLoaderProtocol / FrameDecoder 编解码，一个实例对应一条链路
+ * （一个TCP连接或进程内直连），链路上可以有任意多个从机ID，每个从机独立维护升级状态。
+ * 应答通过定时器在模拟的处理时间之后发出，从不在 receive() 内同步发出，
+ * 进程内直连时不会形成 发送 -> 应答 -> 发送 的递归。
+ */
+class DeviceSimulator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats {
+        quint64 framesReceived = 0;
+        quint64 framesLost = 0;         // 按 lossRate 丢弃的报文
+        quint64 repliesLost = 0;
+        quint64 repliesCorrupted = 0;
+        quint64 crcErrors = 0;          // 收到的报文CRC错误
+        quint64 dataPackets = 0;
+        quint64 duplicatePackets = 0;   // 重复收到的数据包（上位机重传）
+        quint64 bytesWritten = 0;
+        quint64 debugFrames = 0;
+        int upgradesCompleted = 0;
+        int upgradesFailed = 0;
+    };
+
+    // 升级成功后各从机各设备当前固件的大小和CRC（模拟Flash内容），差分升级时据此确认基线
+    struct Installed {
+        quint64 fileSize = 0;
+        quint16 fileCRC = 0;
+    };
+    using InstalledImages = QHash<quint16, Installed>;  // 键为 从机ID << 8 | 数据类型
+
+    explicit DeviceSimulator(const SimulatorConfig &config, QObject *parent = nullptr);
+
+    // 多个实例共用已安装的固件，断开重连后仍是同一批设备；默认每个实例独立
+    void shareInstalled(const QSharedPointer<InstalledImages> &images) { m_installed = images; }
+
+    /**
+     * @brief 上位机发来的字节流（可以是任意分段）
+     */
+    void receive(QByteArrayView data);
+
+    const Stats &stats() const { return m_stats; }
+
+signals:
+    // 发往上位机的报文
+    void transmit(const QByteArray &data);
+
+    // 某个从机收到总体结束，或升级结束校验失败
+    void upgradeFinished(quint8 slaveId, bool success);
+
+private:
+    // 单个从机的升级状态
+    struct Device {
+        bool extended = false;
+        BootLoaderProtocol::MessageType dataType = BootLoaderProtocol::MessageType::FPGA_DATA;
+        bool delta = false;             // 本次按差分升级接收
+        quint64 fileSize = 0;
+        quint16 fileCRC = 0;
+        quint32 packetCount = 0;        // 差分升级时为变化的块数
+        quint32 contiguous = 0;         // 从第1包起连续收到的包数
+        QSet<quint32> outOfOrder;       // 连续范围之后已收到的包序号
+        quint64 bytesReceived = 0;
+        qint64 busyUntilUs = 0;         // 处理完已排队报文的时刻
+    };
+
+    void handleFrame(const BootLoaderProtocol::Frame &frame);
+    void handleCommand(Device &device, const BootLoaderProtocol::Frame &frame);
+    void handleData(Device &device, const BootLoaderProtocol::Frame &frame);
+    void handleEnd(Device &device, const BootLoaderProtocol::Frame &frame);
+    void handleResume(Device &device, const BootLoaderProtocol::Frame &frame);
+    void handleDeltaCommand(Device &device, const BootLoaderProtocol::Frame &frame);
+
+    /**
+     * @brief 报文处理 processingUs 后发出应答
+     */
+    void reply(Device &device, qint64 processingUs, QByteArray frame);
+    void sendAfter(qint64 delayUs, QByteArray frame);
+    bool chance(double probability);
+    bool lossApplies(BootLoaderProtocol::MessageType type) const;
+    static qint64 throughputUs(quint64 bytes, double kbps);
+
+    SimulatorConfig m_config;
+    BootLoaderProtocol m_protocol;
+    FrameDecoder m_decoder;
+    QHash<quint8, Device> m_devices;
+    QSharedPointer<InstalledImages> m_installed;
+    QElapsedTimer m_clock;
+    std::mt19937 m_rng;
+    std::uniform_real_distribution<double> m_uniform;
+    Stats m_stats;
+};
+
+#endif // DEVICESIMULATOR_H
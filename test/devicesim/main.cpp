@@ -0,0 +1,167 @@
+// 下位机模拟器 - TCP服务器
+// 用法: devicesim [--port 503] [--latency-us N] [--reset-ms N] [--erase-ms N] [--erase-kbps N]
+//                 [--data-us N] [--write-kbps N] [--end-ms N] [--loss P] [--reply-loss P] [--loss-data-only]
+//                 [--corrupt P] [--debug P] [--no-extended] [--no-resume] [--no-delta] [--no-compress] [--no-window]
+//                 [--seed N] [--verbose]
+//
+// 每个TCP连接是一条独立链路，链路上按报文中的从机ID分别模拟设备，
+// 可同时接受数百个连接；所有连接在同一个事件循环中处理。
+// 已升级成功的固件（差分升级的基线）在所有连接间共享，重新连接后可以差分升级。
+#include "devicesimulator.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <cstdio>
+
+namespace {
+
+// 每秒检查一次，汇总有变化时输出，便于观察压力测试
+constexpr int STATS_INTERVAL_MS = 1000;
+
+struct Totals {
+    int connections = 0;
+    int completed = 0;
+    int failed = 0;
+
+    bool operator!=(const Totals &other) const
+    {
+        return connections != other.connections || completed != other.completed || failed != other.failed;
+    }
+};
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("BootLoader device simulator"));
+    parser.addHelpOption();
+
+    const QCommandLineOption portOption("port", "TCP listen port.", "port", "503");
+    const QCommandLineOption latencyOption("latency-us", "One-way link latency (us).", "us", "0");
+    const QCommandLineOption requestOption("request-ms", "Upgrade request handling time (ms).", "ms", "0");
+    const QCommandLineOption resetOption("reset-ms", "System reset time (ms).", "ms", "500");
+    const QCommandLineOption eraseOption("erase-ms", "Flash erase base time (ms).", "ms", "300");
+    const QCommandLineOption eraseRateOption("erase-kbps", "Flash erase throughput (KB/s, 0 = base time only).", "kbps", "0");
+    const QCommandLineOption dataOption("data-us", "Fixed per-packet handling time (us).", "us", "0");
+    const QCommandLineOption writeRateOption("write-kbps", "Flash write throughput (KB/s, 0 = unlimited).", "kbps", "0");
+    const QCommandLineOption endOption("end-ms", "Upgrade end verification time (ms).", "ms", "0");
+    const QCommandLineOption lossOption("loss", "Probability of dropping a host frame.", "p", "0");
+    const QCommandLineOption replyLossOption("reply-loss", "Probability of dropping a reply.", "p", "0");
+    const QCommandLineOption lossDataOption("loss-data-only", "Apply loss to data packets and their replies only.");
+    const QCommandLineOption corruptOption("corrupt", "Probability of flipping one bit in a reply.", "p", "0");
+    const QCommandLineOption debugOption("debug", "Probability of emitting a DEBUG_INFO frame per request.", "p", "0");
+    const QCommandLineOption noExtendedOption("no-extended", "Do not advertise extended addressing.");
+    const QCommandLineOption noResumeOption("no-resume", "Do not advertise resumable upgrades.");
+    const QCommandLineOption noDeltaOption("no-delta", "Do not advertise delta upgrades.");
+    const QCommandLineOption noCompressOption("no-compress", "Do not advertise compressed data packets.");
+    const QCommandLineOption noWindowOption("no-window", "Do not advertise sliding-window acknowledgements.");
+    const QCommandLineOption seedOption("seed", "Random seed (each connection adds its index).", "seed", "1");
+    const QCommandLineOption verboseOption("verbose", "Print per-connection events.");
+    parser.addOptions({portOption, latencyOption, requestOption, resetOption, eraseOption, eraseRateOption,
+                       dataOption, writeRateOption, endOption, lossOption, replyLossOption, lossDataOption, corruptOption,
+                       debugOption, noExtendedOption, noResumeOption, noDeltaOption, noCompressOption, noWindowOption,
+                       seedOption, verboseOption});
+    parser.process(app);
+
+    SimulatorConfig config;
+    config.linkLatencyUs = parser.value(latencyOption).toInt();
+    config.requestMs = parser.value(requestOption).toInt();
+    config.resetMs = parser.value(resetOption).toInt();
+    config.eraseBaseMs = parser.value(eraseOption).toInt();
+    config.eraseKBps = parser.value(eraseRateOption).toDouble();
+    config.dataUs = parser.value(dataOption).toInt();
+    config.writeKBps = parser.value(writeRateOption).toDouble();
+    config.endMs = parser.value(endOption).toInt();
+    config.lossRate = parser.value(lossOption).toDouble();
+    config.replyLossRate = parser.value(replyLossOption).toDouble();
+    config.lossDataOnly = parser.isSet(lossDataOption);
+    config.corruptRate = parser.value(corruptOption).toDouble();
+    config.debugRate = parser.value(debugOption).toDouble();
+    config.extendedAddressing = !parser.isSet(noExtendedOption);
+    config.resume = !parser.isSet(noResumeOption);
+    config.delta = !parser.isSet(noDeltaOption);
+    config.compression = !parser.isSet(noCompressOption);
+    config.window = !parser.isSet(noWindowOption);
+    config.seed = parser.value(seedOption).toUInt();
+    const bool verbose = parser.isSet(verboseOption);
+
+    QTcpServer server;
+    server.setMaxPendingConnections(1024);
+    const quint16 port = static_cast<quint16>(parser.value(portOption).toUInt());
+    if (!server.listen(QHostAddress::Any, port)) {
+        std::fprintf(stderr, "listen on port %u failed: %s\n", port, qPrintable(server.errorString()));
+        return 1;
+    }
+    std::printf("devicesim listening on port %u\n", port);
+    std::fflush(stdout);
+
+    Totals totals;
+    quint32 connectionIndex = 0;
+    const auto installed = QSharedPointer<DeviceSimulator::InstalledImages>::create();
+
+    QObject::connect(&server, &QTcpServer::newConnection, &server, [&]() {
+        while (QTcpSocket *socket = server.nextPendingConnection()) {
+            socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+
+            SimulatorConfig linkConfig = config;
+            linkConfig.seed = config.seed + connectionIndex++;
+            auto *simulator = new DeviceSimulator(linkConfig, socket);
+            simulator->shareInstalled(installed);
+            totals.connections++;
+
+            const QString peer = QStringLiteral("%1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort());
+            if (verbose) {
+                std::printf("[+] %s\n", qPrintable(peer));
+            }
+
+            QObject::connect(socket, &QTcpSocket::readyRead, simulator, [socket, simulator]() {
+                const QByteArray data = socket->readAll();
+                simulator->receive(data);
+            });
+            QObject::connect(simulator, &DeviceSimulator::transmit, socket, [socket](const QByteArray &data) {
+                socket->write(data);
+            });
+            QObject::connect(simulator, &DeviceSimulator::upgradeFinished, simulator,
+                             [&totals, peer, verbose](quint8 slaveId, bool success) {
+                success ? totals.completed++ : totals.failed++;
+                if (verbose) {
+                    std::printf("[%s] %s slave %u\n", success ? "ok" : "fail", qPrintable(peer), slaveId);
+                }
+            });
+            QObject::connect(socket, &QTcpSocket::disconnected, socket, [socket, simulator, &totals, peer, verbose]() {
+                const DeviceSimulator::Stats &stats = simulator->stats();
+                totals.connections--;
+                if (verbose) {
+                    std::printf("[-] %s frames %llu lost %llu/%llu corrupt %llu dup %llu crc %llu debug %llu\n",
+                                qPrintable(peer),
+                                static_cast<unsigned long long>(stats.framesReceived),
+                                static_cast<unsigned long long>(stats.framesLost),
+                                static_cast<unsigned long long>(stats.repliesLost),
+                                static_cast<unsigned long long>(stats.repliesCorrupted),
+                                static_cast<unsigned long long>(stats.duplicatePackets),
+                                static_cast<unsigned long long>(stats.crcErrors),
+                                static_cast<unsigned long long>(stats.debugFrames));
+                }
+                socket->deleteLater();
+            });
+        }
+    });
+
+    QTimer statsTimer;
+    Totals printed;
+    QObject::connect(&statsTimer, &QTimer::timeout, &statsTimer, [&totals, &printed]() {
+        if (totals != printed) {
+            std::printf("connections %d  completed %d  failed %d\n", totals.connections, totals.completed, totals.failed);
+            std::fflush(stdout);
+            printed = totals;
+        }
+    });
+    statsTimer.start(STATS_INTERVAL_MS);
+
+    return app.exec();
+}
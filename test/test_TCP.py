@@ -47,9 +47,11 @@ class BootLoaderTestServer:
     def __init__(self, port=503):
         self.port = port
         self.running = False
-        self.received_packets = 0
+        self.received_packets = 0  # 从第1包起连续收到的包数
+        self.out_of_order = set()  # 先于缺失包到达的包序号
         self.expected_file_size = 0
         self.expected_packet_count = 0
+        self.extended = False  # 扩展寻址（32位包序号）
 
     def calculate_crc16(self, data):
         """计算CRC16-MODBUS校验"""
@@ -133,10 +135,12 @@ class BootLoaderTestServer:
         payload = frame_info['payload']
         upgrade_flags = payload[0] if payload else 0
 
-        print(f"[请求] 升级请求 - FPGA:{bool(upgrade_flags & 0x01)} DSP1:{bool(upgrade_flags & 0x02)} DSP2:{bool(upgrade_flags & 0x04)} ARM:{bool(upgrade_flags & 0x08)}")
+        print(f"[请求] 升级请求 - FPGA:{bool(upgrade_flags & 0x01)} DSP1:{bool(upgrade_flags & 0x02)} DSP2:{bool(upgrade_flags & 0x04)} ARM:{bool(upgrade_flags & 0x08)} 扩展寻址:{bool(upgrade_flags & 0x80)}")
 
-        # 允许升级
-        return self.build_response(self.MSG_UPGRADE_REQUEST, self.FLAG_ALLOW_UPGRADE, b'\x00')
+        self.extended = bool(upgrade_flags & 0x80)
+
+        # 允许升级，能力位 bit0 表示支持扩展寻址，bit4 表示支持滑动窗口（应答连续接收的包数）
+        return self.build_response(self.MSG_UPGRADE_REQUEST, self.FLAG_ALLOW_UPGRADE, b'\x00\x11')
 
     def handle_system_reset(self, frame_info):
         """处理系统复位"""
@@ -152,14 +156,15 @@ class BootLoaderTestServer:
         """处理升级指令"""
         payload = frame_info['payload']
 
-        if len(payload) >= 8:
-            file_size = struct.unpack('>I', payload[0:4])[0]
-            packet_count = struct.unpack('>H', payload[4:6])[0]
-            file_crc = struct.unpack('>H', payload[6:8])[0]
+        # 扩展寻址: 文件大小(8) + 包数(4) + CRC(2)，否则 文件大小(4) + 包数(2) + CRC(2)
+        fmt = '>QIH' if self.extended else '>IHH'
 
+        if len(payload) >= struct.calcsize(fmt):
+            file_size, packet_count, file_crc = struct.unpack(fmt, payload[0:struct.calcsize(fmt)])
             self.expected_file_size = file_size
             self.expected_packet_count = packet_count
             self.received_packets = 0
+            self.out_of_order.clear()
 
             device_name = {
                 self.MSG_ARM_COMMAND: "ARM",
@@ -180,19 +185,28 @@ class BootLoaderTestServer:
         """处理升级数据"""
         payload = frame_info['payload']
 
-        if len(payload) >= 2:
-            packet_num = struct.unpack('>H', payload[0:2])[0]
-            data = payload[2:]
+        num_size = 4 if self.extended else 2
+        if len(payload) >= num_size:
+            packet_num = int.from_bytes(payload[0:num_size], 'big')
+            data = payload[num_size:]
 
-            self.received_packets += 1
+            # 重复包不计数；乱序到达的包先记下，缺失包补齐后连续计数一并前移
+            if packet_num == self.received_packets + 1:
+                self.received_packets += 1
+                while self.received_packets + 1 in self.out_of_order:
+                    self.out_of_order.discard(self.received_packets + 1)
+                    self.received_packets += 1
+            elif packet_num > self.received_packets:
+                self.out_of_order.add(packet_num)
 
             # 每10包打印一次进度
             if packet_num % 10 == 0 or packet_num == self.expected_packet_count:
                 progress = (self.received_packets * 100) // self.expected_packet_count if self.expected_packet_count > 0 else 0
                 print(f"[数据] 包序号:{packet_num}/{self.expected_packet_count} 数据大小:{len(data)}字节 进度:{progress}%")
 
-            # 构建响应payload: status(1) + packet_num(2) + received_count(2)
-            response_payload = struct.pack('>BHH', 0x00, packet_num, self.received_packets)
+            # 构建响应payload: status(1) + packet_num(2/4) + received_count(2/4)
+            response_payload = struct.pack('>BII' if self.extended else '>BHH',
+                                           0x00, packet_num, self.received_packets)
 
             return self.build_response(frame_info['msg_type'], self.FLAG_SUCCESS, response_payload)
 
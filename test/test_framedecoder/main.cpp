@@ -0,0 +1,319 @@
+// 接收帧分割器测试
+// 用法: test_framedecoder
+//
+// 覆盖 FrameDecoder 中手写环形缓冲区容易出错的路径：逐字节和任意位置分段写入、跨越缓冲区
+// 末尾的帧（拼接到暂存区）、帧头之前的杂散数据、末尾单独的 0xAA / 0x55（帧头的前半个字节）、
+// CRC错误的帧交出后后续帧仍能对齐、长度字段过大或小于最小帧长。
+// 全部通过时退出码为0，否则逐条输出失败项并返回1。
+#include "inc/framedecoder.h"
+#include "inc/crc16.h"
+#include <QByteArray>
+#include <QList>
+#include <cstdio>
+#include <random>
+
+namespace {
+int failures = 0;
+
+void check(bool condition, const char *what)
+{
+    if (!condition) {
+        std::printf("FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+/**
+ * @brief 构造一帧：帧头 + ID + 长度(2，高位在前) + 类型 + 标识 + 数据 + CRC(低位在前)
+ * @param slave 为 true 时使用下位机帧头 0x55 0xAA
+ */
+QByteArray buildFrame(bool slave, quint8 slaveId, quint8 type, const QByteArray &data)
+{
+    const qsizetype length = FrameDecoder::MIN_FRAME_SIZE + data.size();
+    QByteArray frame;
+    frame.append(static_cast<char>(slave ? 0x55 : 0xAA));
+    frame.append(static_cast<char>(slave ? 0xAA : 0x55));
+    frame.append(static_cast<char>(slaveId));
+    frame.append(static_cast<char>((length >> 8) & 0xFF));
+    frame.append(static_cast<char>(length & 0xFF));
+    frame.append(static_cast<char>(type));
+    frame.append(static_cast<char>(0x00));
+    frame.append(data);
+    const quint16 crc = Crc16::calculate(frame.constData(), frame.size());
+    frame.append(static_cast<char>(crc & 0xFF));
+    frame.append(static_cast<char>((crc >> 8) & 0xFF));
+    return frame;
+}
+
+bool crcValid(const QByteArray &frame)
+{
+    if (frame.size() < FrameDecoder::MIN_FRAME_SIZE) {
+        return false;
+    }
+    const quint16 crc = Crc16::calculate(frame.constData(), frame.size() - 2);
+    return static_cast<quint8>(frame[frame.size() - 2]) == (crc & 0xFF) &&
+           static_cast<quint8>(frame[frame.size() - 1]) == (crc >> 8);
+}
+
+// 不含 0xAA / 0x55 的字节，用作数据或杂散数据时不会被当作帧头
+QByteArray noise(qsizetype size, std::mt19937 &rng)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (char &byte : data) {
+        quint8 value;
+        do {
+            value = static_cast<quint8>(rng());
+        } while (value == 0xAA || value == 0x55);
+        byte = static_cast<char>(value);
+    }
+    return data;
+}
+
+QByteArray randomBytes(qsizetype size, std::mt19937 &rng)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (char &byte : data) {
+        byte = static_cast<char>(rng());
+    }
+    return data;
+}
+
+// 取出当前所有完整帧
+void drain(FrameDecoder &decoder, QList<QByteArray> &frames)
+{
+    QByteArrayView frame;
+    while (decoder.nextFrame(frame)) {
+        frames.append(frame.toByteArray());
+    }
+}
+
+// 按 chunk 字节分段写入，缓冲区满时先取帧再继续
+QList<QByteArray> feed(FrameDecoder &decoder, const QByteArray &stream, qsizetype chunk)
+{
+    QList<QByteArray> frames;
+    qsizetype pos = 0;
+    while (pos < stream.size()) {
+        const qsizetype length = qMin(chunk, stream.size() - pos);
+        pos += decoder.write(stream.constData() + pos, length);
+        drain(decoder, frames);
+    }
+    return frames;
+}
+
+QList<QByteArray> sampleFrames(std::mt19937 &rng)
+{
+    QList<QByteArray> frames;
+    frames.append(buildFrame(false, 1, 0x01, QByteArray()));
+    frames.append(buildFrame(true, 2, 0x04, randomBytes(1, rng)));
+    // 数据中含有两种帧头的字节序列，不能被当作新帧
+    frames.append(buildFrame(true, 3, 0x04, QByteArray("\xAA\x55\x55\xAA\x55", 5)));
+    frames.append(buildFrame(false, 4, 0x02, randomBytes(300, rng)));
+    frames.append(buildFrame(true, 5, 0x0E, randomBytes(17, rng)));
+    return frames;
+}
+
+QByteArray join(const QList<QByteArray> &frames)
+{
+    QByteArray stream;
+    for (const QByteArray &frame : frames) {
+        stream.append(frame);
+    }
+    return stream;
+}
+
+void testByteByByte()
+{
+    std::mt19937 rng(1);
+    const QList<QByteArray> frames = sampleFrames(rng);
+    FrameDecoder decoder;
+    check(feed(decoder, join(frames), 1) == frames, "byte-by-byte feed yields every frame unchanged");
+    check(decoder.size() == 0 && decoder.droppedBytes() == 0, "byte-by-byte feed drops nothing");
+}
+
+void testSplitFeeds()
+{
+    std::mt19937 rng(2);
+    const QList<QByteArray> frames = sampleFrames(rng);
+    const QByteArray stream = join(frames);
+    bool allMatch = true;
+    for (qsizetype split = 0; split <= stream.size(); ++split) {
+        FrameDecoder decoder;
+        QList<QByteArray> out;
+        decoder.write(stream.constData(), split);
+        drain(decoder, out);
+        decoder.write(stream.constData() + split, stream.size() - split);
+        drain(decoder, out);
+        allMatch = allMatch && out == frames && decoder.droppedBytes() == 0;
+    }
+    check(allMatch, "a feed split at any position yields every frame unchanged");
+
+    // 长度不一的分段
+    FrameDecoder decoder;
+    check(feed(decoder, stream + stream + stream, 7) == frames + frames + frames, "7-byte feeds yield every frame");
+}
+
+void testWrapAround()
+{
+    std::mt19937 rng(3);
+    QList<QByteArray> frames;
+    qint64 position = 0;
+    int wrapped = 0;
+    // 总长超过缓冲区容量数倍，其中包含最大长度的帧
+    while (position < 4 * FrameDecoder::CAPACITY) {
+        const qsizetype dataSize = frames.size() % 9 == 8
+            ? FrameDecoder::MAX_FRAME_SIZE - FrameDecoder::MIN_FRAME_SIZE
+            : static_cast<qsizetype>(rng() % 3000);
+        const QByteArray frame = buildFrame(frames.size() % 2 == 0, 1, 0x04, randomBytes(dataSize, rng));
+        if ((position % FrameDecoder::CAPACITY) + frame.size() > FrameDecoder::CAPACITY) {
+            ++wrapped;
+        }
+        position += frame.size();
+        frames.append(frame);
+    }
+    check(wrapped > 1, "test stream places frames across the buffer end");
+
+    for (qsizetype chunk : {qsizetype(4093), qsizetype(FrameDecoder::CAPACITY), qsizetype(1) << 20}) {
+        FrameDecoder decoder;
+        const QList<QByteArray> out = feed(decoder, join(frames), chunk);
+        check(out == frames, "frames across the buffer end are reassembled unchanged");
+        check(decoder.droppedBytes() == 0, "frames across the buffer end drop nothing");
+    }
+}
+
+void testGarbageBeforeHeader()
+{
+    std::mt19937 rng(4);
+    const QByteArray frame = buildFrame(false, 1, 0x01, randomBytes(20, rng));
+    const QByteArray slaveFrame = buildFrame(true, 1, 0x01, randomBytes(20, rng));
+
+    // 杂散数据中单独的 0x55、0xAA 以及 0x55 后面不是 0xAA 的情况
+    QByteArray garbage = noise(100, rng);
+    garbage.append("\x55\x01\xAA\x02\x55\x55\x03", 7);
+    garbage.append(noise(50, rng));
+
+    FrameDecoder decoder;
+    const QList<QByteArray> out = feed(decoder, garbage + frame + garbage + slaveFrame, 1);
+    check(out == QList<QByteArray>({frame, slaveFrame}), "frames after garbage are found");
+    check(decoder.droppedBytes() == static_cast<quint64>(2 * garbage.size()), "garbage before a header is counted as dropped");
+
+    FrameDecoder whole;
+    check(feed(whole, garbage + frame + garbage + slaveFrame, 1 << 20) == QList<QByteArray>({frame, slaveFrame}),
+          "frames after garbage are found when written at once");
+}
+
+void testTrailingHeaderByte()
+{
+    std::mt19937 rng(5);
+    for (bool slave : {false, true}) {
+        const QByteArray frame = buildFrame(slave, 1, 0x01, randomBytes(10, rng));
+        const QByteArray garbage = noise(40, rng);
+
+        // 杂散数据后只到达帧头的第一个字节
+        FrameDecoder decoder;
+        QList<QByteArray> out;
+        const QByteArray first = garbage + frame.left(1);
+        decoder.write(first.constData(), first.size());
+        drain(decoder, out);
+        check(out.isEmpty(), "a lone header byte does not produce a frame");
+        check(decoder.size() == 1, "a lone trailing header byte is kept");
+
+        const QByteArray rest = frame.mid(1);
+        decoder.write(rest.constData(), rest.size());
+        drain(decoder, out);
+        check(out == QList<QByteArray>({frame}), "a frame whose header byte arrived alone is found");
+        check(decoder.droppedBytes() == static_cast<quint64>(garbage.size()), "only garbage before a lone header byte is dropped");
+    }
+
+    // 末尾的 0x55 后面到达的不是 0xAA
+    FrameDecoder decoder;
+    QList<QByteArray> out;
+    const QByteArray frame = buildFrame(false, 1, 0x01, randomBytes(10, rng));
+    decoder.write("\x55", 1);
+    drain(decoder, out);
+    const QByteArray rest = QByteArray("\x01", 1) + frame;
+    decoder.write(rest.constData(), rest.size());
+    drain(decoder, out);
+    check(out == QList<QByteArray>({frame}), "a trailing 0x55 that is not a header is dropped");
+}
+
+void testResyncAfterBadCrc()
+{
+    std::mt19937 rng(6);
+    const QByteArray good = buildFrame(true, 1, 0x04, randomBytes(30, rng));
+
+    // CRC错误的帧按长度整体交出，由调用方丢弃，后续帧仍然对齐
+    QByteArray badCrc = buildFrame(true, 1, 0x04, randomBytes(30, rng));
+    badCrc[badCrc.size() - 1] = static_cast<char>(badCrc[badCrc.size() - 1] ^ 0x01);
+    {
+        FrameDecoder decoder;
+        const QList<QByteArray> out = feed(decoder, badCrc + good, 1);
+        check(out.size() == 2 && !crcValid(out[0]) && out[1] == good, "frame after a bad CRC is found");
+    }
+
+    // 长度字段被改小：交出的前半段CRC错误，剩余部分作为杂散数据跳过，下一帧仍能找到
+    // （原CRC字节也改掉，避免其恰好与下一帧的帧头拼出假帧头）
+    QByteArray shortened = buildFrame(true, 1, 0x04, noise(30, rng));
+    shortened[4] = static_cast<char>(FrameDecoder::MIN_FRAME_SIZE + 5);
+    shortened[shortened.size() - 2] = 0x00;
+    shortened[shortened.size() - 1] = 0x00;
+    {
+        FrameDecoder decoder;
+        const QList<QByteArray> out = feed(decoder, shortened + good, 3);
+        check(out.size() == 2 && !crcValid(out[0]) && out[1] == good, "frame after a corrupted length is found");
+    }
+}
+
+void testInvalidLength()
+{
+    std::mt19937 rng(7);
+    const QByteArray good = buildFrame(false, 1, 0x01, randomBytes(12, rng));
+
+    // 长度小于最小帧长（含0）：丢弃帧头继续查找
+    for (qsizetype length : {qsizetype(0), qsizetype(1), FrameDecoder::MIN_FRAME_SIZE - 1}) {
+        QByteArray bad("\xAA\x55\x01", 3);
+        bad.append(static_cast<char>((length >> 8) & 0xFF));
+        bad.append(static_cast<char>(length & 0xFF));
+        bad.append(noise(6, rng));
+
+        FrameDecoder decoder;
+        const QList<QByteArray> out = feed(decoder, bad + good, 1);
+        check(out == QList<QByteArray>({good}), "header with a length below the minimum is skipped");
+        check(decoder.droppedBytes() == static_cast<quint64>(bad.size()), "invalid header and its bytes are dropped");
+    }
+
+    // 长度字段为最大值而实际数据很短：等到足够的字节后交出（CRC错误），之后的帧仍然对齐
+    QByteArray oversize("\x55\xAA\x01\xFF\xFF\x04\x00", 7);
+    oversize.append(noise(FrameDecoder::MAX_FRAME_SIZE - oversize.size(), rng));
+    {
+        FrameDecoder decoder;
+        QList<QByteArray> out;
+        decoder.write(oversize.constData(), 100);
+        drain(decoder, out);
+        check(out.isEmpty(), "oversize length waits for the whole frame");
+
+        const QByteArray rest = oversize.mid(100) + good;
+        decoder.write(rest.constData(), rest.size());
+        drain(decoder, out);
+        check(out.size() == 2 && out[0].size() == FrameDecoder::MAX_FRAME_SIZE && !crcValid(out[0]) && out[1] == good,
+              "frame after an oversize length is found");
+    }
+}
+}
+
+int main()
+{
+    testByteByByte();
+    testSplitFeeds();
+    testWrapAround();
+    testGarbageBeforeHeader();
+    testTrailingHeaderByte();
+    testResyncAfterBadCrc();
+    testInvalidLength();
+
+    if (failures > 0) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all frame decoder tests passed\n");
+    return 0;
+}
@@ -0,0 +1,20 @@
+# 接收帧分割器测试（分段写入、跨越缓冲区末尾、杂散数据、末尾半个帧头、CRC错误后重同步、无效长度）
+QT -= gui
+QT += core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = test_framedecoder
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    main.cpp \
+    ../../src/framedecoder.cpp \
+    ../../src/crc16.cpp
+
+HEADERS += \
+    ../../inc/framedecoder.h \
+    ../../inc/crc16.h
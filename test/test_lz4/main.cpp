@@ -0,0 +1,255 @@
+// LZ4 块格式测试
+// 用法: test_lz4
+//
+// 对随机、长重复段和不可压缩三类输入做压缩/解压往返，长度覆盖 0..MF_LIMIT 附近的每个值
+// 和 4096 以内的随机值；逐个解析压缩结果的序列，确认满足参考实现解压所要求的块末尾约束；
+// 检查容量边界（compressBound 总能成功、容量不足返回0、以上次结果长度为容量时输出不变），
+// 以及截断、非法偏移、长度溢出等畸形输入的解压一律返回 -1。
+// 全部通过时退出码为0，否则逐条输出失败项并返回1。
+#include "inc/lz4.h"
+#include <QByteArray>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+namespace {
+// 与 lz4.cpp 一致的块格式约束
+constexpr int LAST_LITERALS = 5;     // 块末尾至少5字节是字面量
+constexpr int MF_LIMIT = 12;         // 最后一个匹配必须在块末尾12字节之前开始
+constexpr int MAX_SIZE = 4096;
+
+int failures = 0;
+
+void check(bool condition, const char *what, qsizetype size = -1)
+{
+    if (!condition) {
+        if (size >= 0) {
+            std::printf("FAIL: %s (size %lld)\n", what, static_cast<long long>(size));
+        } else {
+            std::printf("FAIL: %s\n", what);
+        }
+        ++failures;
+    }
+}
+
+enum class Kind { Random, Runs, Incompressible };
+
+// Random：小字母表，含短重复；Runs：零段和重复模式交替；Incompressible：均匀随机字节
+QByteArray generate(Kind kind, qsizetype size, std::mt19937 &rng)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    qsizetype i = 0;
+    while (i < size) {
+        switch (kind) {
+        case Kind::Random:
+            data[i++] = "abcdefgh"[rng() % 8];
+            break;
+        case Kind::Runs: {
+            // 长度可超过 15+255，覆盖匹配长度的多字节编码
+            const qsizetype run = qMin<qsizetype>(size - i, 1 + rng() % 600);
+            const int pattern = static_cast<int>(rng() % 3);
+            const char value = static_cast<char>(rng());
+            for (qsizetype j = 0; j < run; ++j, ++i) {
+                data[i] = pattern == 0 ? '\0' : pattern == 1 ? value : static_cast<char>(j % 7);
+            }
+            break;
+        }
+        case Kind::Incompressible:
+            data[i++] = static_cast<char>(rng());
+            break;
+        }
+    }
+    return data;
+}
+
+/**
+ * @brief 逐个解析序列，检查块格式约束
+ *
+ * 每个匹配的偏移在已输出范围内，最后一个匹配在块末尾 MF_LIMIT 字节之前开始，
+ * 块末尾至少 LAST_LITERALS 字节是字面量，解析出的总长度等于原始长度。
+ */
+bool followsFormat(const QByteArray &packed, qsizetype rawSize)
+{
+    const quint8 *ip = reinterpret_cast<const quint8 *>(packed.constData());
+    const quint8 *const end = ip + packed.size();
+    qsizetype pos = 0;
+    bool hasMatch = false;
+
+    auto readLength = [&ip, end](qsizetype &length) {
+        quint8 byte;
+        do {
+            if (ip >= end) {
+                return false;
+            }
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (ip < end) {
+        const quint8 token = *ip++;
+        qsizetype literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(literalLength)) {
+            return false;
+        }
+        if (end - ip < literalLength) {
+            return false;
+        }
+        ip += literalLength;
+        pos += literalLength;
+
+        if (ip == end) {
+            // 最后一个序列：有匹配时其后至少 LAST_LITERALS 字节字面量
+            return pos == rawSize && (!hasMatch || literalLength >= LAST_LITERALS);
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        const qsizetype offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        qsizetype matchLength = token & 0x0F;
+        if (matchLength == 15 && !readLength(matchLength)) {
+            return false;
+        }
+        matchLength += Lz4::MIN_MATCH;
+
+        if (offset == 0 || offset > pos || pos >= rawSize - MF_LIMIT ||
+            pos + matchLength > rawSize - LAST_LITERALS) {
+            return false;
+        }
+        pos += matchLength;
+        hasMatch = true;
+    }
+    return false;   // 缺少只含字面量的最后一个序列
+}
+
+void checkRoundTrip(const QByteArray &data)
+{
+    const qsizetype size = data.size();
+    QByteArray packed(Lz4::compressBound(size), Qt::Uninitialized);
+    const qsizetype packedSize = Lz4::compress(data.constData(), size, packed.data(), packed.size());
+    check(packedSize > 0, "compressBound capacity always succeeds", size);
+    if (packedSize <= 0) {
+        return;
+    }
+    packed.resize(packedSize);
+    check(followsFormat(packed, size), "compressed block follows the LZ4 block format", size);
+
+    // 输出缓冲区恰好等于原始长度
+    QByteArray restored(size, Qt::Uninitialized);
+    const qsizetype restoredSize = Lz4::decompress(packed.constData(), packed.size(), restored.data(), size);
+    check(restoredSize == size && restored == data, "round trip restores the input", size);
+
+    // 以上次结果长度为容量再压缩，输出逐字节相同；少1字节时返回0
+    QByteArray again(packedSize, Qt::Uninitialized);
+    check(Lz4::compress(data.constData(), size, again.data(), packedSize) == packedSize && again == packed,
+          "recompressing with the previous size as capacity gives the same bytes", size);
+    check(Lz4::compress(data.constData(), size, again.data(), packedSize - 1) == 0,
+          "capacity one byte short of the result returns 0", size);
+
+    if (size > 0) {
+        check(Lz4::decompress(packed.constData(), packed.size(), restored.data(), size - 1) == -1,
+              "decompress into a too small buffer fails", size);
+    }
+
+    // 截断的输入不能还原出完整内容，也不能越界
+    for (qsizetype cut = 0; cut < packed.size(); ++cut) {
+        const qsizetype partial = Lz4::decompress(packed.constData(), cut, restored.data(), size);
+        if (partial >= size && size > 0) {
+            check(false, "truncated input does not restore the whole block", size);
+            break;
+        }
+    }
+}
+
+void testRoundTrips()
+{
+    std::mt19937 rng(20240601);
+    for (Kind kind : {Kind::Random, Kind::Runs, Kind::Incompressible}) {
+        for (qsizetype size = 0; size <= MF_LIMIT + 32; ++size) {
+            checkRoundTrip(generate(kind, size, rng));
+        }
+        for (int round = 0; round < 300; ++round) {
+            checkRoundTrip(generate(kind, static_cast<qsizetype>(rng() % (MAX_SIZE + 1)), rng));
+        }
+        checkRoundTrip(generate(kind, MAX_SIZE, rng));
+    }
+
+    // 全零块：单个长匹配
+    checkRoundTrip(QByteArray(MAX_SIZE, '\0'));
+
+    // 不可压缩的块在容量比原始长度少1字节时得到0（传输计划据此按原始内容发送）
+    const QByteArray noise = generate(Kind::Incompressible, MAX_SIZE, rng);
+    QByteArray packed(MAX_SIZE, Qt::Uninitialized);
+    check(Lz4::compress(noise.constData(), noise.size(), packed.data(), noise.size() - 1) == 0,
+          "incompressible block does not fit in size - 1");
+}
+
+qsizetype decompressBytes(std::initializer_list<int> bytes, qsizetype capacity)
+{
+    QByteArray src;
+    for (int byte : bytes) {
+        src.append(static_cast<char>(byte));
+    }
+    QByteArray dst(capacity, Qt::Uninitialized);
+    return Lz4::decompress(src.constData(), src.size(), dst.data(), capacity);
+}
+
+void testMalformed()
+{
+    // 字面量长度超出输入
+    check(decompressBytes({0x50, 'a', 'b'}, 64) == -1, "literal length beyond input");
+    // 字面量长度的扩展字节缺失或全部为255直到输入结束
+    check(decompressBytes({0xF0}, 64) == -1, "missing literal length byte");
+    check(decompressBytes({0xF0, 255, 255, 255}, 64) == -1, "literal length bytes run past the input");
+    // 字面量超出输出容量
+    check(decompressBytes({0x40, 'a', 'b', 'c', 'd'}, 3) == -1, "literals beyond output capacity");
+    // 偏移只有1字节
+    check(decompressBytes({0x11, 'a', 0x01}, 64) == -1, "truncated offset");
+    // 偏移为0
+    check(decompressBytes({0x10, 'a', 0x00, 0x00, 0x00}, 64) == -1, "zero offset");
+    // 偏移超出已输出的内容
+    check(decompressBytes({0x10, 'a', 0x02, 0x00, 0x00}, 64) == -1, "offset beyond output");
+    check(decompressBytes({0x00, 0x01, 0x00, 0x00}, 64) == -1, "match before any output");
+    // 匹配长度扩展字节缺失
+    check(decompressBytes({0x1F, 'a', 0x01, 0x00}, 64) == -1, "missing match length byte");
+    check(decompressBytes({0x1F, 'a', 0x01, 0x00, 255, 255}, 4096) == -1, "match length bytes run past the input");
+    // 匹配超出输出容量
+    check(decompressBytes({0x1F, 'a', 0x01, 0x00, 255, 0, 0x00}, 64) == -1, "match beyond output capacity");
+
+    // 合法的最小块
+    check(decompressBytes({0x00}, 0) == 0, "empty block decompresses to nothing");
+    check(decompressBytes({0x14, 'a', 0x01, 0x00, 0x10, 'b'}, 10) == 10, "valid overlapping match");
+
+    // 随机字节：结果只能是 -1 或不超过容量的长度
+    std::mt19937 rng(7);
+    QByteArray dst(MAX_SIZE, Qt::Uninitialized);
+    for (int round = 0; round < 20000; ++round) {
+        QByteArray src(static_cast<qsizetype>(rng() % 64), Qt::Uninitialized);
+        for (char &byte : src) {
+            byte = static_cast<char>(rng());
+        }
+        const qsizetype capacity = static_cast<qsizetype>(rng() % (MAX_SIZE + 1));
+        const qsizetype result = Lz4::decompress(src.constData(), src.size(), dst.data(), capacity);
+        if (result < -1 || result > capacity) {
+            check(false, "random input stays within the output capacity");
+            break;
+        }
+    }
+}
+}
+
+int main()
+{
+    testRoundTrips();
+    testMalformed();
+
+    if (failures > 0) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all LZ4 tests passed\n");
+    return 0;
+}
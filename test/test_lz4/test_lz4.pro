@@ -0,0 +1,18 @@
+# LZ4 块格式测试（往返、格式约束、容量边界、畸形输入解压）
+QT -= gui
+QT += core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = test_lz4
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    main.cpp \
+    ../../src/lz4.cpp
+
+HEADERS += \
+    ../../inc/lz4.h
@@ -0,0 +1,172 @@
+// 时间轮测试
+// 用法: test_timerwheel
+//
+// 覆盖时间轮中容易出错的路径：超过一圈（约2.56s）的定时器、回调中重新启动/停止
+// 同一槽位的其他定时器、事件循环停顿超过一圈后的追赶、全部到期空闲后重新启动。
+// 全部通过时退出码为0，否则逐条输出失败项并返回1。
+#include "inc/timerwheel.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QThread>
+#include <QTimer>
+#include <cstdio>
+
+namespace {
+constexpr qint64 LATE_TOLERANCE_MS = 250;   // 允许的触发延迟（调度抖动）
+
+int failures = 0;
+
+void check(bool condition, const char *what)
+{
+    if (!condition) {
+        std::printf("FAIL: %s\n", what);
+        ++failures;
+    }
+}
+
+// 运行事件循环直到 done() 为真或超过 limitMs
+template <typename Done>
+void runUntil(Done done, int limitMs)
+{
+    QElapsedTimer clock;
+    clock.start();
+    while (!done() && clock.elapsed() < limitMs) {
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+    }
+}
+
+// 不早于设定时间触发，且延迟在容差内
+bool onTime(qint64 firedMs, qint64 expectedMs)
+{
+    return firedMs >= expectedMs && firedMs <= expectedMs + LATE_TOLERANCE_MS;
+}
+
+void testBeyondOneRound()
+{
+    const int roundMs = TimerWheel::SLOT_COUNT * TimerWheel::TICK_MS;
+    QElapsedTimer clock;
+    qint64 longFired = -1;
+    qint64 shortFired = -1;
+    TimerWheel::Timer longTimer([&]() { longFired = clock.elapsed(); });
+    TimerWheel::Timer shortTimer([&]() { shortFired = clock.elapsed(); });
+
+    // 两个定时器落在同一槽位，短的在本圈到期，长的在下一圈
+    clock.start();
+    longTimer.start(roundMs + 500);
+    shortTimer.start(500);
+    runUntil([&]() { return longFired >= 0; }, roundMs + 2000);
+
+    check(onTime(shortFired, 500), "short timer sharing a slot fires in the first round");
+    check(onTime(longFired, roundMs + 500), "timer beyond one round fires in its own round, not earlier");
+    check(TimerWheel::forCurrentThread()->activeCount() == 0, "no timer left active after a long timer");
+}
+
+void testStartStopFromCallback()
+{
+    QElapsedTimer clock;
+    int firstCount = 0;
+    int stoppedCount = 0;
+    qint64 restartedFired = -1;
+    int restartedCount = 0;
+    TimerWheel::Timer stopped([&]() { ++stoppedCount; });
+    TimerWheel::Timer restarted([&]() { restartedFired = clock.elapsed(); ++restartedCount; });
+    TimerWheel::Timer first([&]() {
+        ++firstCount;
+        stopped.stop();         // 同一槽位中尚未处理的定时器
+        restarted.start(100);   // 同一槽位中尚未处理的定时器改到以后
+    });
+
+    clock.start();
+    first.start(50);
+    stopped.start(50);
+    restarted.start(50);
+    runUntil([&]() { return restartedCount > 0; }, 2000);
+    runUntil([]() { return false; }, 100);     // 确认不会再次触发
+
+    check(firstCount == 1, "first timer fires once");
+    check(stoppedCount == 0, "timer stopped from another callback in the same slot does not fire");
+    check(restartedCount == 1, "timer restarted from another callback fires once");
+    check(onTime(restartedFired, 150), "restarted timer uses its new interval");
+}
+
+void testRearmSelf()
+{
+    int count = 0;
+    TimerWheel::Timer *selfTimer = nullptr;
+    TimerWheel::Timer timer([&]() {
+        if (++count < 5) {
+            selfTimer->start(10);
+        }
+    });
+    selfTimer = &timer;
+
+    timer.start(10);
+    runUntil([&]() { return count >= 5; }, 2000);
+    runUntil([]() { return false; }, 50);
+
+    check(count == 5, "timer restarted from its own callback fires once per start");
+    check(!timer.isActive(), "timer inactive after its last callback");
+}
+
+void testCatchUpAfterStall()
+{
+    const int roundMs = TimerWheel::SLOT_COUNT * TimerWheel::TICK_MS;
+    QElapsedTimer clock;
+    qint64 dueFired = -1;
+    qint64 laterFired = -1;
+    TimerWheel::Timer due([&]() { dueFired = clock.elapsed(); });
+    TimerWheel::Timer later([&]() { laterFired = clock.elapsed(); });
+
+    clock.start();
+    due.start(20);
+    later.start(roundMs * 2);
+
+    // 事件循环停顿超过一圈（如系统休眠、界面线程卡住）
+    QThread::msleep(static_cast<unsigned long>(roundMs + 500));
+    const qint64 resumed = clock.elapsed();
+    runUntil([&]() { return dueFired >= 0; }, 1000);
+
+    check(dueFired >= 0 && dueFired <= resumed + LATE_TOLERANCE_MS, "overdue timer fires right after the stall");
+    check(laterFired < 0, "timer due after the stall does not fire early");
+
+    runUntil([&]() { return laterFired >= 0; }, roundMs * 2);
+    check(onTime(laterFired, roundMs * 2), "timer due after the stall fires on time");
+}
+
+void testRestartFromIdle()
+{
+    TimerWheel *wheel = TimerWheel::forCurrentThread();
+    check(wheel->activeCount() == 0, "wheel idle before restart test");
+
+    // 空闲期间时间轮不推进，重新启动时不能把空闲期间的刻度算作已过
+    runUntil([]() { return false; }, 700);
+
+    QElapsedTimer clock;
+    qint64 fired = -1;
+    TimerWheel::Timer timer([&]() { fired = clock.elapsed(); });
+    clock.start();
+    timer.start(50);
+    runUntil([&]() { return fired >= 0; }, 2000);
+
+    check(onTime(fired, 50), "timer started after an idle period fires on time");
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    testBeyondOneRound();
+    testStartStopFromCallback();
+    testRearmSelf();
+    testCatchUpAfterStall();
+    testRestartFromIdle();
+
+    if (failures > 0) {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all timer wheel tests passed\n");
+    return 0;
+}
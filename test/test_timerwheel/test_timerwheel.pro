@@ -0,0 +1,18 @@
+# 时间轮测试（跨圈定时、回调中启停其他定时器、事件循环停顿后追赶、空闲后重新启动）
+QT -= gui
+QT += core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = test_timerwheel
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    main.cpp \
+    ../../src/timerwheel.cpp
+
+HEADERS += \
+    ../../inc/timerwheel.h
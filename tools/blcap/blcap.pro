@@ -0,0 +1,24 @@
+# 会话抓包离线分析工具（.blcap）
+QT -= gui
+QT += core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = blcap
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    main.cpp \
+    ../../src/sessioncapture.cpp \
+    ../../src/protocol.cpp \
+    ../../src/crc16.cpp \
+    ../../src/framedecoder.cpp
+
+HEADERS += \
+    ../../inc/sessioncapture.h \
+    ../../inc/protocol.h \
+    ../../inc/crc16.h \
+    ../../inc/framedecoder.h
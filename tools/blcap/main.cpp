@@ -0,0 +1,474 @@
+// 会话抓包离线分析
+// 用法: blcap <抓包文件.blcap> [--gap-ms 空闲阈值毫秒，默认50] [--top 列出最长空闲数，默认10]
+//
+// 重放抓包中的全部报文，输出：各阶段耗时、数据包往返时延分布与直方图、
+// 重传次数、CRC错误帧数、超过阈值的链路空闲区间。
+#include "inc/sessioncapture.h"
+#include "inc/protocol.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+using Protocol = BootLoaderProtocol;
+using MessageType = BootLoaderProtocol::MessageType;
+using ResponseFlag = BootLoaderProtocol::ResponseFlag;
+
+constexpr int HISTOGRAM_BUCKETS = 16;       // 64us 起按2倍递增，最后一档为 >=1s
+constexpr quint64 HISTOGRAM_BASE_NS = 64000;
+
+bool isDataType(MessageType type)
+{
+    return type == MessageType::ARM_DATA || type == MessageType::FPGA_DATA ||
+           type == MessageType::DSP1_DATA || type == MessageType::DSP2_DATA ||
+           type == MessageType::DELTA_DATA || type == MessageType::COMPRESSED_DATA;
+}
+
+double toMs(quint64 ns)
+{
+    return static_cast<double>(ns) / 1e6;
+}
+
+void print(const QString &text)
+{
+    std::printf("%s\n", text.toLocal8Bit().constData());
+}
+
+// 阶段：连续发送同一类型报文的区间，到下一类型报文首次发送为止
+struct Phase {
+    MessageType type = MessageType::UPGRADE_REQUEST;
+    quint64 startNs = 0;
+    quint64 endNs = 0;
+    quint64 txFrames = 0;
+    quint64 rxFrames = 0;
+    quint64 txBytes = 0;
+    quint64 retransmits = 0;
+};
+
+struct Pending {
+    quint64 sentNs = 0;
+    int sends = 0;
+};
+
+struct Gap {
+    quint64 startNs = 0;
+    quint64 durationNs = 0;
+    QString before;
+    QString after;
+};
+
+class Analyzer
+{
+public:
+    void setGapThreshold(quint64 ns) { gapThreshold = ns; }
+    void add(const SessionCapture::Record &record);
+    void report(qint64 startTime, quint64 gapThresholdNs, int topGaps);
+
+private:
+    QString describe(const SessionCapture::Record &record, const Protocol::Frame &frame) const;
+    qsizetype packetNumberSize(MessageType type) const;
+    quint32 readPacketNumber(MessageType type, QByteArrayView bytes) const;
+    void handleTx(const SessionCapture::Record &record, const Protocol::Frame &frame);
+    void handleRx(const SessionCapture::Record &record, const Protocol::Frame &frame);
+    static void printDistribution(const QString &title, QVector<quint64> samples);
+
+    bool extended = false;
+    bool extendedRequested = false;
+
+    QVector<Phase> phases;
+    QHash<quint64, Pending> pendingData;            // (类型 << 32 | 包序号) -> 发送记录
+    QHash<quint8, Pending> pendingControl;          // 类型 -> 发送记录
+    QVector<quint64> dataRtt;
+    QHash<quint8, QVector<quint64>> controlRtt;
+
+    quint64 records = 0;
+    quint64 txFrames = 0;
+    quint64 rxFrames = 0;
+    quint64 txBytes = 0;
+    quint64 rxBytes = 0;
+    quint64 dataPayloadBytes = 0;
+    quint64 dataRawBytes = 0;                       // 压缩数据包按解压后的长度计
+    quint64 dataRetransmits = 0;
+    quint64 controlRetransmits = 0;
+    quint64 crcErrors = 0;
+    quint64 malformed = 0;
+    quint64 debugFrames = 0;
+    quint64 errorReplies = 0;
+
+    quint64 firstNs = 0;
+    quint64 lastNs = 0;
+    QString lastDescription;
+    QVector<Gap> gaps;
+    quint64 gapThreshold = 50000000;
+};
+
+// 差分和压缩数据包的序号固定4字节，其余数据包取决于是否扩展寻址
+qsizetype Analyzer::packetNumberSize(MessageType type) const
+{
+    return type == MessageType::DELTA_DATA || type == MessageType::COMPRESSED_DATA
+        ? 4 : Protocol::packetNumberSize(extended);
+}
+
+quint32 Analyzer::readPacketNumber(MessageType type, QByteArrayView bytes) const
+{
+    quint32 value = 0;
+    for (qsizetype i = 0; i < packetNumberSize(type); ++i) {
+        value = (value << 8) | static_cast<quint8>(bytes[i]);
+    }
+    return value;
+}
+
+QString Analyzer::describe(const SessionCapture::Record &record, const Protocol::Frame &frame) const
+{
+    const bool tx = record.direction == SessionCapture::Direction::Tx;
+    QString text = tx ? QStringLiteral("TX ") : QStringLiteral("RX ");
+    if (record.flags & SessionCapture::FLAG_CRC_ERROR) {
+        return text + QStringLiteral("CRC错误帧 (%1 字节)").arg(record.data.size());
+    }
+
+    text += Protocol::getMessageTypeDescription(frame.type);
+    if (!tx) {
+        text += QStringLiteral(" [%1]").arg(Protocol::getResponseDescription(frame.flag));
+    }
+
+    if (isDataType(frame.type)) {
+        // 发送：数据包序号紧跟标识；应答：状态(1) + 包序号
+        const qsizetype fieldSize = packetNumberSize(frame.type);
+        const qsizetype offset = tx ? 0 : 1;
+        if (frame.payload.size() >= offset + fieldSize) {
+            text += QStringLiteral(" #%1").arg(readPacketNumber(frame.type, frame.payload.sliced(offset)));
+        }
+    }
+    return text;
+}
+
+void Analyzer::add(const SessionCapture::Record &record)
+{
+    Protocol::Frame frame;
+    const bool crcError = record.flags & SessionCapture::FLAG_CRC_ERROR;
+    const bool parsed = !crcError && Protocol::parseFrame(QByteArrayView(record.data), frame);
+    const QString description = parsed || crcError ? describe(record, frame) : QStringLiteral("无法解析的报文");
+
+    if (records == 0) {
+        firstNs = record.timestampNs;
+    } else if (record.timestampNs - lastNs >= gapThreshold) {
+        Gap gap;
+        gap.startNs = lastNs;
+        gap.durationNs = record.timestampNs - lastNs;
+        gap.before = lastDescription;
+        gap.after = description;
+        gaps.append(gap);
+    }
+    ++records;
+    lastNs = record.timestampNs;
+    lastDescription = description;
+
+    if (record.direction == SessionCapture::Direction::Tx) {
+        ++txFrames;
+        txBytes += record.data.size();
+    } else {
+        ++rxFrames;
+        rxBytes += record.data.size();
+    }
+
+    if (crcError) {
+        ++crcErrors;
+        return;
+    }
+    if (!parsed) {
+        ++malformed;
+        return;
+    }
+
+    if (record.direction == SessionCapture::Direction::Tx) {
+        handleTx(record, frame);
+    } else {
+        handleRx(record, frame);
+    }
+}
+
+void Analyzer::handleTx(const SessionCapture::Record &record, const Protocol::Frame &frame)
+{
+    if (frame.type == MessageType::UPGRADE_REQUEST && !frame.payload.isEmpty()) {
+        extendedRequested = static_cast<quint8>(frame.payload[0]) & 0x80;
+    }
+
+    if (phases.isEmpty() || phases.last().type != frame.type) {
+        if (!phases.isEmpty()) {
+            phases.last().endNs = record.timestampNs;
+        }
+        Phase phase;
+        phase.type = frame.type;
+        phase.startNs = record.timestampNs;
+        phases.append(phase);
+    }
+
+    Phase &phase = phases.last();
+    ++phase.txFrames;
+    phase.txBytes += record.data.size();
+
+    if (isDataType(frame.type)) {
+        // 差分数据包在包序号后还有4字节块号，压缩数据包再加2字节原始长度
+        const qsizetype fieldSize = frame.type == MessageType::COMPRESSED_DATA ? Protocol::COMPRESSED_DATA_FIELDS
+                                  : frame.type == MessageType::DELTA_DATA ? Protocol::DELTA_DATA_FIELDS
+                                                                          : packetNumberSize(frame.type);
+        if (frame.payload.size() < fieldSize) {
+            return;
+        }
+        dataPayloadBytes += frame.payload.size() - fieldSize;
+        if (frame.type == MessageType::COMPRESSED_DATA) {
+            dataRawBytes += (static_cast<quint8>(frame.payload[8]) << 8) | static_cast<quint8>(frame.payload[9]);
+        } else {
+            dataRawBytes += frame.payload.size() - fieldSize;
+        }
+
+        const quint64 key = (quint64(frame.type) << 32) | readPacketNumber(frame.type, frame.payload);
+        Pending &pending = pendingData[key];
+        if (pending.sends > 0) {
+            ++dataRetransmits;
+            ++phase.retransmits;
+        }
+        ++pending.sends;
+        pending.sentNs = record.timestampNs;
+        return;
+    }
+
+    // 控制报文：上一帧尚未应答又发送同一类型视为重发
+    Pending &pending = pendingControl[quint8(frame.type)];
+    if (pending.sends > 0) {
+        ++controlRetransmits;
+        ++phase.retransmits;
+    }
+    ++pending.sends;
+    pending.sentNs = record.timestampNs;
+}
+
+void Analyzer::handleRx(const SessionCapture::Record &record, const Protocol::Frame &frame)
+{
+    if (!phases.isEmpty()) {
+        ++phases.last().rxFrames;
+    }
+
+    if (frame.type == MessageType::DEBUG_INFO) {
+        ++debugFrames;
+        return;
+    }
+
+    switch (frame.flag) {
+        case ResponseFlag::FAILED:
+        case ResponseFlag::CRC_ERROR:
+        case ResponseFlag::TIMEOUT:
+        case ResponseFlag::FORBID_UPGRADE:
+        case ResponseFlag::UNLOCK_FAILED:
+        case ResponseFlag::ERASE_FAILED:
+        case ResponseFlag::RESTART_FAILED:
+        case ResponseFlag::SIZE_ERROR:
+        case ResponseFlag::DATA_CRC_ERROR:
+        case ResponseFlag::FPGA_FILE_DAMAGED:
+        case ResponseFlag::FPGA_STATUS_ERROR:
+            ++errorReplies;
+            break;
+        default:
+            break;
+    }
+
+    // 设备接受扩展寻址后，之后的数据包序号为4字节
+    if (frame.type == MessageType::UPGRADE_REQUEST && frame.flag == ResponseFlag::ALLOW_UPGRADE) {
+        extended = extendedRequested && frame.payload.size() >= 2 &&
+                   (static_cast<quint8>(frame.payload[1]) & Protocol::CAPABILITY_EXTENDED_ADDRESSING);
+    }
+
+    if (isDataType(frame.type)) {
+        const qsizetype fieldSize = packetNumberSize(frame.type);
+        if (frame.payload.size() < 1 + fieldSize) {
+            return;
+        }
+        const quint64 key = (quint64(frame.type) << 32) | readPacketNumber(frame.type, frame.payload.sliced(1));
+        auto it = pendingData.find(key);
+        if (it == pendingData.end()) {
+            return;
+        }
+        // Karn 算法：重传过的包无法确定应答对应哪一次发送，不计入时延
+        if (it->sends == 1) {
+            dataRtt.append(record.timestampNs - it->sentNs);
+        }
+        pendingData.erase(it);
+        return;
+    }
+
+    // 控制报文取第一条应答（擦除等耗时操作包含设备执行时间）
+    auto it = pendingControl.find(quint8(frame.type));
+    if (it == pendingControl.end() || it->sends == 0) {
+        return;
+    }
+    if (it->sends == 1) {
+        controlRtt[quint8(frame.type)].append(record.timestampNs - it->sentNs);
+    }
+    it->sends = 0;
+}
+
+void Analyzer::printDistribution(const QString &title, QVector<quint64> samples)
+{
+    if (samples.isEmpty()) {
+        print(QStringLiteral("%1: 无样本").arg(title));
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double p) {
+        const qsizetype index = std::min<qsizetype>(samples.size() - 1, static_cast<qsizetype>(p * samples.size()));
+        return toMs(samples[index]);
+    };
+    print(QStringLiteral("%1: %2 个样本  min %3  p50 %4  p90 %5  p99 %6  max %7 ms")
+              .arg(title)
+              .arg(samples.size())
+              .arg(toMs(samples.first()), 0, 'f', 3)
+              .arg(percentile(0.50), 0, 'f', 3)
+              .arg(percentile(0.90), 0, 'f', 3)
+              .arg(percentile(0.99), 0, 'f', 3)
+              .arg(toMs(samples.last()), 0, 'f', 3));
+}
+
+void Analyzer::report(qint64 startTime, quint64 gapThresholdNs, int topGaps)
+{
+    if (!phases.isEmpty()) {
+        phases.last().endNs = lastNs;
+    }
+    const quint64 totalNs = lastNs - firstNs;
+
+    print(QStringLiteral("开始时间: %1").arg(QDateTime::fromMSecsSinceEpoch(startTime).toString("yyyy-MM-dd hh:mm:ss.zzz")));
+    print(QStringLiteral("记录 %1 条，时长 %2 s，扩展寻址 %3")
+              .arg(records)
+              .arg(toMs(totalNs) / 1000.0, 0, 'f', 3)
+              .arg(extended ? QStringLiteral("是") : QStringLiteral("否")));
+    print(QStringLiteral("发送 %1 帧 / %2 字节，接收 %3 帧 / %4 字节")
+              .arg(txFrames).arg(txBytes).arg(rxFrames).arg(rxBytes));
+    print(QStringLiteral("数据包重传 %1，控制报文重发 %2，CRC错误帧 %3，无法解析 %4，错误应答 %5，调试报文 %6")
+              .arg(dataRetransmits).arg(controlRetransmits).arg(crcErrors)
+              .arg(malformed).arg(errorReplies).arg(debugFrames));
+    if (!pendingData.isEmpty()) {
+        print(QStringLiteral("未单独应答的数据包 %1（累计应答或传输中断）").arg(pendingData.size()));
+    }
+
+    print(QString());
+    print(QStringLiteral("阶段耗时:"));
+    quint64 dataNs = 0;
+    for (const Phase &phase : phases) {
+        if (isDataType(phase.type)) {
+            dataNs += phase.endNs - phase.startNs;
+        }
+        print(QStringLiteral("  %1 +%2 s  %3 ms  发送 %4 帧  接收 %5 帧  重发 %6")
+                  .arg(Protocol::getMessageTypeDescription(phase.type), -12)
+                  .arg(toMs(phase.startNs - firstNs) / 1000.0, 0, 'f', 3)
+                  .arg(toMs(phase.endNs - phase.startNs), 10, 'f', 1)
+                  .arg(phase.txFrames)
+                  .arg(phase.rxFrames)
+                  .arg(phase.retransmits));
+    }
+    if (dataNs > 0) {
+        print(QStringLiteral("数据阶段有效吞吐: %1 KB/s")
+                  .arg(dataPayloadBytes / 1024.0 / (toMs(dataNs) / 1000.0), 0, 'f', 1));
+        if (dataRawBytes != dataPayloadBytes && dataPayloadBytes > 0) {
+            print(QStringLiteral("压缩传输: 解压后 %1 KB/s，压缩比 %2")
+                      .arg(dataRawBytes / 1024.0 / (toMs(dataNs) / 1000.0), 0, 'f', 1)
+                      .arg(static_cast<double>(dataRawBytes) / dataPayloadBytes, 0, 'f', 2));
+        }
+    }
+
+    print(QString());
+    printDistribution(QStringLiteral("数据包往返时延"), dataRtt);
+    for (auto it = controlRtt.cbegin(); it != controlRtt.cend(); ++it) {
+        printDistribution(QStringLiteral("%1应答").arg(Protocol::getMessageTypeDescription(MessageType(it.key()))), it.value());
+    }
+
+    if (!dataRtt.isEmpty()) {
+        quint64 histogram[HISTOGRAM_BUCKETS] = {};
+        for (quint64 ns : dataRtt) {
+            int bucket = 0;
+            for (quint64 limit = HISTOGRAM_BASE_NS; ns >= limit && bucket < HISTOGRAM_BUCKETS - 1; limit <<= 1) {
+                ++bucket;
+            }
+            ++histogram[bucket];
+        }
+        const quint64 peak = *std::max_element(histogram, histogram + HISTOGRAM_BUCKETS);
+
+        print(QString());
+        print(QStringLiteral("数据包往返时延直方图:"));
+        for (int i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+            if (histogram[i] == 0) {
+                continue;
+            }
+            const QString label = i == HISTOGRAM_BUCKETS - 1
+                                      ? QStringLiteral(">= %1 ms").arg(toMs(HISTOGRAM_BASE_NS << (i - 1)), 0, 'f', 3)
+                                      : QStringLiteral("< %1 ms").arg(toMs(HISTOGRAM_BASE_NS << i), 0, 'f', 3);
+            const int width = static_cast<int>(histogram[i] * 50 / peak);
+            print(QStringLiteral("  %1 %2 %3")
+                      .arg(label, 14)
+                      .arg(histogram[i], 8)
+                      .arg(QString(qMax(width, 1), QLatin1Char('#'))));
+        }
+    }
+
+    print(QString());
+    print(QStringLiteral("空闲超过 %1 ms 的区间 %2 个").arg(toMs(gapThresholdNs), 0, 'f', 1).arg(gaps.size()));
+    std::sort(gaps.begin(), gaps.end(), [](const Gap &a, const Gap &b) {
+        return a.durationNs > b.durationNs;
+    });
+    for (int i = 0; i < gaps.size() && i < topGaps; ++i) {
+        const Gap &gap = gaps[i];
+        print(QStringLiteral("  +%1 s  %2 ms  %3  ->  %4")
+                  .arg(toMs(gap.startNs - firstNs) / 1000.0, 0, 'f', 3)
+                  .arg(toMs(gap.durationNs), 8, 'f', 1)
+                  .arg(gap.before, gap.after));
+    }
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+
+    QString path;
+    double gapMs = 50.0;
+    int topGaps = 10;
+    for (int i = 1; i < args.size(); ++i) {
+        if (args[i] == QLatin1String("--gap-ms") && i + 1 < args.size()) {
+            gapMs = args[++i].toDouble();
+        } else if (args[i] == QLatin1String("--top") && i + 1 < args.size()) {
+            topGaps = args[++i].toInt();
+        } else if (path.isEmpty()) {
+            path = args[i];
+        } else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.isEmpty() || gapMs <= 0) {
+        std::fprintf(stderr, "usage: blcap <capture.blcap> [--gap-ms N] [--top N]\n");
+        return 1;
+    }
+
+    SessionCaptureReader reader;
+    QString errorString;
+    if (!reader.open(path, &errorString)) {
+        std::fprintf(stderr, "%s: %s\n", path.toLocal8Bit().constData(), errorString.toLocal8Bit().constData());
+        return 1;
+    }
+
+    const quint64 gapThresholdNs = static_cast<quint64>(gapMs * 1e6);
+    Analyzer analyzer;
+    analyzer.setGapThreshold(gapThresholdNs);
+
+    SessionCapture::Record record;
+    while (reader.next(record)) {
+        analyzer.add(record);
+    }
+    analyzer.report(reader.startTime(), gapThresholdNs, topGaps);
+    return 0;
+}
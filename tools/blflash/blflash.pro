@@ -0,0 +1,46 @@
+# 命令行升级工具（无界面，QCoreApplication）
+QT -= gui
+QT += core network serialport concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+TARGET = blflash
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    main.cpp \
+    ../../src/fleetupgrade.cpp \
+    ../../src/iothreadpool.cpp \
+    ../../src/upgradesession.cpp \
+    ../../src/communication.cpp \
+    ../../src/upgrade.cpp \
+    ../../src/protocol.cpp \
+    ../../src/crc16.cpp \
+    ../../src/lz4.cpp \
+    ../../src/framedecoder.cpp \
+    ../../src/transferplan.cpp \
+    ../../src/firmwareimage.cpp \
+    ../../src/sessioncapture.cpp \
+    ../../src/timerwheel.cpp \
+    ../../src/upgradejournal.cpp \
+    ../../src/upgradetelemetry.cpp
+
+HEADERS += \
+    ../../inc/fleetupgrade.h \
+    ../../inc/iothreadpool.h \
+    ../../inc/upgradesession.h \
+    ../../inc/communication.h \
+    ../../inc/upgrade.h \
+    ../../inc/protocol.h \
+    ../../inc/crc16.h \
+    ../../inc/lz4.h \
+    ../../inc/framedecoder.h \
+    ../../inc/transferplan.h \
+    ../../inc/firmwareimage.h \
+    ../../inc/sessioncapture.h \
+    ../../inc/timerwheel.h \
+    ../../inc/upgradejournal.h \
+    ../../inc/upgradetelemetry.h
@@ -0,0 +1,349 @@
+// 命令行升级工具（无界面，用于产线烧录工位脚本调用）
+// 用法: blflash (--tcp 主机[:端口] | --serial 端口 [--baud 波特率] | --fleet 目标文件) [--slave ID列表]
+//               [--jobs N] [--io-threads N] [--packet-size N] [--window N]
+//               [--fpga 文件] [--dsp1 文件] [--dsp2 文件] [--arm 文件]
+//               [--capture 抓包文件] [--journal 目录] [--baseline 目录] [--no-compress] [--timeout 秒] [--quiet] [--telemetry]
+//
+// --journal 给出时每个目标在该目录下保存一个断点记录，中断后用同样的参数再次运行即从断点续传。
+// --baseline 给出时每个目标在该目录下保存成功写入的固件，下次升级只传输有变化的块（需下位机支持差分升级）。
+// 下位机支持时默认压缩传输，--no-compress 关闭。
+// 从机ID列表如 "1"、"1-8"、"1,3,5"；多个目标同时升级，每个目标一条独立链路，
+// 最多同时运行 --jobs 个，分布在 --io-threads 个I/O线程上（默认按CPU核数，单个目标时不另开线程）。目标文件每行一条链路及其从机ID列表（# 开头为注释）：
+//   192.168.1.10:503   1-4
+//   serial:COM3@115200 2
+//
+// 标准输出每行一个JSON对象（JSON Lines），均带 "target" 字段：
+//   {"event":"info","text":...}                      升级过程信息（--quiet 时不输出）
+//   {"event":"progress","device":"FPGA",...}          进度，每个目标最多每100ms一行
+//   {"event":"result","status":"success",...}          目标结束，--telemetry 时附带完整统计
+//   {"event":"fleet","running":...}                    多个目标时的汇总进度
+// 退出码见 ExitCode；多个目标结果不同时为 EXIT_PARTIAL。
+#include "inc/fleetupgrade.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QThread>
+#include <QTimer>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+
+enum ExitCode {
+    EXIT_OK = 0,
+    EXIT_UPGRADE_FAILED = 1,
+    EXIT_LINK_ERROR = 2,
+    EXIT_INVALID_IMAGE = 3,
+    EXIT_USAGE = 4,
+    EXIT_TIMEOUT = 5,
+    EXIT_PARTIAL = 6
+};
+
+int exitCodeFor(UpgradeSession::Status status)
+{
+    switch (status) {
+        case UpgradeSession::Status::Success: return EXIT_OK;
+        case UpgradeSession::Status::UpgradeFailed: return EXIT_UPGRADE_FAILED;
+        case UpgradeSession::Status::LinkError: return EXIT_LINK_ERROR;
+        case UpgradeSession::Status::InvalidImage: return EXIT_INVALID_IMAGE;
+        case UpgradeSession::Status::Cancelled: return EXIT_TIMEOUT;
+    }
+    return EXIT_UPGRADE_FAILED;
+}
+
+// 每个事件一行，立即刷新，调用方可以逐行读取
+void emitLine(const QJsonObject &json)
+{
+    const QByteArray line = QJsonDocument(json).toJson(QJsonDocument::Compact);
+    std::fwrite(line.constData(), 1, static_cast<size_t>(line.size()), stdout);
+    std::fputc('\n', stdout);
+    std::fflush(stdout);
+}
+
+void usageError(const QString &message)
+{
+    std::fprintf(stderr, "blflash: %s\n", qPrintable(message));
+    std::exit(EXIT_USAGE);
+}
+
+// 链路："主机[:端口]" 或 "serial:端口[@波特率]"
+bool parseLink(const QString &text, UpgradeSession::Target &target)
+{
+    if (text.startsWith(QLatin1String("serial:"))) {
+        const QString spec = text.mid(7);
+        const int at = spec.indexOf(QLatin1Char('@'));
+        target.link = CommunicationManager::LinkType::Serial;
+        target.portName = at >= 0 ? spec.left(at) : spec;
+        if (at >= 0) {
+            bool ok = false;
+            target.baudRate = spec.mid(at + 1).toInt(&ok);
+            if (!ok || target.baudRate <= 0) {
+                return false;
+            }
+        }
+        return !target.portName.isEmpty();
+    }
+
+    const int colon = text.lastIndexOf(QLatin1Char(':'));
+    target.link = CommunicationManager::LinkType::Ethernet;
+    target.host = colon > 0 ? text.left(colon) : text;
+    if (colon > 0) {
+        bool ok = false;
+        target.port = text.mid(colon + 1).toUShort(&ok);
+        if (!ok || target.port == 0) {
+            return false;
+        }
+    }
+    return !target.host.isEmpty();
+}
+
+// 从机ID列表："1"、"1-8"、"1,3,5-7"
+bool parseSlaveIds(const QString &text, QList<quint8> &ids)
+{
+    for (const QString &item : text.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        const QStringList range = item.trimmed().split(QLatin1Char('-'));
+        bool okFirst = false;
+        bool okLast = false;
+        const uint first = range.first().toUInt(&okFirst);
+        const uint last = range.size() == 2 ? range.last().toUInt(&okLast) : first;
+        if (!okFirst || (range.size() == 2 && !okLast) || range.size() > 2 ||
+            first < 1 || last > 255 || first > last) {
+            return false;
+        }
+        for (uint id = first; id <= last; ++id) {
+            ids.append(static_cast<quint8>(id));
+        }
+    }
+    return !ids.isEmpty();
+}
+
+void addTargets(QList<UpgradeSession::Target> &targets, const UpgradeSession::Target &link, const QList<quint8> &ids)
+{
+    for (quint8 id : ids) {
+        UpgradeSession::Target target = link;
+        target.slaveId = id;
+        targets.append(target);
+    }
+}
+
+bool loadFleetFile(const QString &path, const UpgradeSession::Target &base,
+                   QList<UpgradeSession::Target> &targets, QString &error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = QStringLiteral("cannot open %1: %2").arg(path, file.errorString());
+        return false;
+    }
+
+    int lineNumber = 0;
+    while (!file.atEnd()) {
+        lineNumber++;
+        const QString line = QString::fromUtf8(file.readLine()).section(QLatin1Char('#'), 0, 0).trimmed();
+        if (line.isEmpty()) {
+            continue;
+        }
+        const QStringList fields = line.split(QRegularExpression(QStringLiteral("\\s+")));
+        UpgradeSession::Target link = base;
+        QList<quint8> ids;
+        if (fields.size() > 2 || !parseLink(fields[0], link) ||
+            !parseSlaveIds(fields.size() == 2 ? fields[1] : QStringLiteral("1"), ids)) {
+            error = QStringLiteral("%1:%2: invalid target \"%3\"").arg(path).arg(lineNumber).arg(line);
+            return false;
+        }
+        addTargets(targets, link, ids);
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("blflash"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Headless BootLoader firmware upgrade"));
+    parser.addHelpOption();
+    const QCommandLineOption tcpOption("tcp", "Upgrade over TCP.", "host[:port]");
+    const QCommandLineOption serialOption("serial", "Upgrade over a serial port.", "port");
+    const QCommandLineOption baudOption("baud", "Serial baud rate.", "baud", "115200");
+    const QCommandLineOption fleetOption("fleet", "Upgrade every target listed in a file.", "file");
+    const QCommandLineOption slaveOption("slave", "Slave IDs, e.g. 1, 1-8 or 1,3,5.", "ids", "1");
+    const QCommandLineOption jobsOption("jobs", "Maximum number of concurrent sessions.", "n", "8");
+    const QCommandLineOption ioThreadsOption("io-threads", "I/O threads shared by all links (0 = run links on the main thread).", "n");
+    const QCommandLineOption packetOption("packet-size", "Packet size in bytes (FPGA always uses 1024).", "bytes", "1024");
+    const QCommandLineOption windowOption("window", "Sliding window size (1 = stop-and-wait).", "n", "1");
+    const QCommandLineOption fpgaOption("fpga", "FPGA image.", "file");
+    const QCommandLineOption dsp1Option("dsp1", "DSP1 image.", "file");
+    const QCommandLineOption dsp2Option("dsp2", "DSP2 image.", "file");
+    const QCommandLineOption armOption("arm", "ARM image.", "file");
+    const QCommandLineOption captureOption("capture", "Record the session to a .blcap file (single target only).", "file");
+    const QCommandLineOption journalOption("journal", "Keep resume checkpoints in this directory.", "dir");
+    const QCommandLineOption baselineOption("baseline", "Keep installed images in this directory for delta upgrades.", "dir");
+    const QCommandLineOption noCompressOption("no-compress", "Send firmware data uncompressed.");
+    const QCommandLineOption timeoutOption("timeout", "Abort after this many seconds (0 = no limit).", "s", "0");
+    const QCommandLineOption quietOption("quiet", "Do not print info events.");
+    const QCommandLineOption telemetryOption("telemetry", "Include full telemetry in result lines.");
+    parser.addOptions({tcpOption, serialOption, baudOption, fleetOption, slaveOption, jobsOption, ioThreadsOption, packetOption,
+                       windowOption, fpgaOption, dsp1Option, dsp2Option, armOption, captureOption, journalOption, baselineOption,
+                       noCompressOption, timeoutOption, quietOption, telemetryOption});
+    parser.process(app);
+
+    // 各目标共用的分包与固件参数
+    UpgradeSession::Target base;
+    base.packetSize = parser.value(packetOption).toInt();
+    base.windowSize = qMax(1, parser.value(windowOption).toInt());
+    base.baudRate = parser.value(baudOption).toInt();
+    base.fpgaPath = parser.value(fpgaOption);
+    base.dsp1Path = parser.value(dsp1Option);
+    base.dsp2Path = parser.value(dsp2Option);
+    base.armPath = parser.value(armOption);
+    base.compress = !parser.isSet(noCompressOption);
+    if (base.fpgaPath.isEmpty() && base.dsp1Path.isEmpty() &&
+        base.dsp2Path.isEmpty() && base.armPath.isEmpty()) {
+        usageError(QStringLiteral("no image given (--fpga/--dsp1/--dsp2/--arm)"));
+    }
+
+    QList<UpgradeSession::Target> targets;
+    const int linkOptions = int(parser.isSet(tcpOption)) + int(parser.isSet(serialOption)) + int(parser.isSet(fleetOption));
+    if (linkOptions != 1) {
+        usageError(QStringLiteral("exactly one of --tcp, --serial or --fleet is required"));
+    }
+    if (parser.isSet(fleetOption)) {
+        QString error;
+        if (!loadFleetFile(parser.value(fleetOption), base, targets, error)) {
+            usageError(error);
+        }
+    } else {
+        UpgradeSession::Target link = base;
+        const QString spec = parser.isSet(tcpOption) ? parser.value(tcpOption)
+                                                     : QStringLiteral("serial:") + parser.value(serialOption);
+        if (!parseLink(spec, link)) {
+            usageError(QStringLiteral("invalid link %1").arg(spec));
+        }
+        QList<quint8> ids;
+        if (!parseSlaveIds(parser.value(slaveOption), ids)) {
+            usageError(QStringLiteral("--slave must list IDs in 1-255"));
+        }
+        addTargets(targets, link, ids);
+    }
+    if (targets.isEmpty()) {
+        usageError(QStringLiteral("no target"));
+    }
+    if (parser.isSet(captureOption)) {
+        if (targets.size() > 1) {
+            usageError(QStringLiteral("--capture needs a single target"));
+        }
+        targets.first().capturePath = parser.value(captureOption);
+    }
+    if (parser.isSet(journalOption) || parser.isSet(baselineOption)) {
+        // 文件名取自目标名称，如 "192.168.1.10_503_1.json"、"192.168.1.10_503_1/ARM.bin"
+        const QDir journalDir(parser.value(journalOption));
+        const QDir baselineDir(parser.value(baselineOption));
+        static const QRegularExpression unsafe(QStringLiteral("[^A-Za-z0-9.-]"));
+        for (UpgradeSession::Target &target : targets) {
+            QString fileName = target.name();
+            fileName.replace(unsafe, QStringLiteral("_"));
+            if (parser.isSet(journalOption)) {
+                target.journalPath = journalDir.filePath(fileName + QStringLiteral(".json"));
+            }
+            if (parser.isSet(baselineOption)) {
+                target.baselineDir = baselineDir.filePath(fileName);
+            }
+        }
+    }
+
+    const bool quiet = parser.isSet(quietOption);
+    const bool withTelemetry = parser.isSet(telemetryOption);
+    const int timeoutSeconds = parser.value(timeoutOption).toInt();
+
+    FleetUpgrade fleet;
+    fleet.setMaxConcurrent(parser.value(jobsOption).toInt());
+    fleet.setIoThreads(parser.isSet(ioThreadsOption)
+                           ? parser.value(ioThreadsOption).toInt()
+                           : (targets.size() > 1 ? qMin(static_cast<int>(targets.size()), QThread::idealThreadCount()) : 0));
+    for (const UpgradeSession::Target &target : std::as_const(targets)) {
+        fleet.addTarget(target);
+    }
+    auto targetName = [&targets](int index) { return targets[index].name(); };
+
+    if (!quiet) {
+        QObject::connect(&fleet, &FleetUpgrade::sessionInfo, &app, [&](int index, const QString &text) {
+            QJsonObject json;
+            json["event"] = QStringLiteral("info");
+            json["target"] = targetName(index);
+            json["text"] = text;
+            emitLine(json);
+        });
+    }
+    QObject::connect(&fleet, &FleetUpgrade::sessionProgress, &app, [&](int index, const UpgradeManager::Progress &progress) {
+        QJsonObject json;
+        json["event"] = QStringLiteral("progress");
+        json["target"] = targetName(index);
+        json["device"] = UpgradeManager::deviceName(progress.device);
+        json["device_percent"] = progress.devicePercent;
+        json["total_percent"] = progress.totalPercent;
+        json["device_bytes"] = static_cast<qint64>(progress.deviceBytes);
+        json["device_total_bytes"] = static_cast<qint64>(progress.deviceTotalBytes);
+        json["bytes"] = static_cast<qint64>(progress.overallBytes);
+        json["total_bytes"] = static_cast<qint64>(progress.overallTotalBytes);
+        json["bytes_per_second"] = qRound64(progress.bytesPerSecond);
+        json["eta_ms"] = progress.totalEtaMs;
+        json["retransmits"] = static_cast<qint64>(progress.retransmits);
+        json["timeouts"] = static_cast<qint64>(progress.timeouts);
+        emitLine(json);
+    });
+    QObject::connect(&fleet, &FleetUpgrade::sessionFinished, &app, [&](int index, const FleetUpgrade::Result &result) {
+        QJsonObject json;
+        json["event"] = QStringLiteral("result");
+        json["target"] = targetName(index);
+        json["status"] = UpgradeSession::statusName(result.status);
+        json["message"] = result.message;
+        json["elapsed_ms"] = result.elapsedMs;
+        if (withTelemetry) {
+            json["telemetry"] = result.telemetry.toJson();
+        }
+        emitLine(json);
+    });
+    if (targets.size() > 1) {
+        QObject::connect(&fleet, &FleetUpgrade::progressUpdated, &app, [](const FleetUpgrade::Progress &progress) {
+            QJsonObject json;
+            json["event"] = QStringLiteral("fleet");
+            json["total"] = progress.total;
+            json["pending"] = progress.pending;
+            json["running"] = progress.running;
+            json["succeeded"] = progress.succeeded;
+            json["failed"] = progress.failed;
+            json["percent"] = progress.percent;
+            json["bytes"] = static_cast<qint64>(progress.bytes);
+            json["total_bytes"] = static_cast<qint64>(progress.totalBytes);
+            json["bytes_per_second"] = qRound64(progress.bytesPerSecond);
+            emitLine(json);
+        });
+    }
+    QObject::connect(&fleet, &FleetUpgrade::finished, &app, &QCoreApplication::quit, Qt::QueuedConnection);
+
+    QTimer deadline;
+    if (timeoutSeconds > 0) {
+        deadline.setSingleShot(true);
+        QObject::connect(&deadline, &QTimer::timeout, &fleet, &FleetUpgrade::cancel);
+        deadline.start(timeoutSeconds * 1000);
+    }
+
+    QTimer::singleShot(0, &fleet, &FleetUpgrade::start);
+    app.exec();
+
+    // 全部目标结果相同时使用该结果的退出码
+    int exitCode = -1;
+    for (const FleetUpgrade::Result &result : fleet.results()) {
+        const int code = exitCodeFor(result.status);
+        exitCode = (exitCode < 0 || exitCode == code) ? code : EXIT_PARTIAL;
+    }
+    return exitCode < 0 ? EXIT_UPGRADE_FAILED : exitCode;
+}